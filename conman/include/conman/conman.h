@@ -17,11 +17,14 @@
 #include <ocl/TaskBrowser.hpp>
 #include <ocl/LoggingService.hpp>
 #include <rtt/Logger.hpp>
+#include <rtt/ConnPolicy.hpp>
 
 #include <boost/graph/directed_graph.hpp>
 #include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/filtered_graph.hpp>
 #include <boost/graph/topological_sort.hpp>
 #include <boost/graph/labeled_graph.hpp>
+#include <boost/dynamic_bitset.hpp>
 
 //! Conman Controller Manager
 namespace conman 
@@ -39,6 +42,8 @@ namespace conman
 
       //! An index for use in topological sort
       unsigned int index;
+      //! The stable ID of the block in the scheme
+      unsigned int id;
       //! If true, all inputs are latched
       bool latched_input;
       //! If true, all outputs are latched
@@ -131,6 +136,37 @@ namespace conman
     typedef boost::graph_traits<conman::graph::DataFlowGraph>::out_edge_iterator DataFlowOutEdgeIterator;
     //! Iterator for iterating over edges in the DataFlowGraph in no particular order
     typedef boost::graph_traits<conman::graph::DataFlowGraph>::in_edge_iterator DataFlowInEdgeIterator;
+    //! Iterator for iterating over all edges in the DataFlowGraph in no particular order
+    typedef boost::graph_traits<conman::graph::DataFlowGraph>::edge_iterator DataFlowEdgeIterator;
+
+    /** \brief Edge predicate which only passes unlatched data flow edges
+     *
+     * This is used to view the execution scheduling graph (ESG) as the DFG
+     * without its latched edges, so latching an edge only requires setting its
+     * latched flag.
+     */
+    struct UnlatchedEdgePredicate
+    {
+      UnlatchedEdgePredicate() : graph(NULL) { }
+      UnlatchedEdgePredicate(const DataFlowGraph *graph_) : graph(graph_) { }
+
+      bool operator()(const DataFlowEdgeDescriptor &edge) const {
+        return !(*graph)[edge]->latched;
+      }
+
+      const DataFlowGraph *graph;
+    };
+
+    //! Boost Graph for representing the ESG as a view of the DFG
+    typedef
+      boost::filtered_graph
+      <DataFlowGraph, UnlatchedEdgePredicate>
+      ExecutionGraph;
+
+    //! Iterator for iterating over vertices in the ExecutionGraph in no particular order
+    typedef boost::graph_traits<conman::graph::ExecutionGraph>::vertex_iterator ExecutionVertexIterator;
+    //! Iterator for iterating over unlatched edges in the ExecutionGraph in no particular order
+    typedef boost::graph_traits<conman::graph::ExecutionGraph>::out_edge_iterator ExecutionOutEdgeIterator;
 
     //! Topological Ordering container for DataFlowGraph vertices
     typedef std::list<DataFlowVertexDescriptor> DataFlowPath;
@@ -190,53 +226,94 @@ namespace conman
       std::vector<DataFlowPath> &cycles;
     };
 
-    /** \brief Boost graph for representing the conflicts between components
+    /** \brief Dense bit matrix for representing the conflicts between components
      *
-     * Vertices in this graph correspond to blocks, and edges correspond to
-     * conflict relationships between those blocks. I.e. if two blocks are
-     * adjacent in this graph, then they cannot be run at the same time without
-     * causing a resource exclusivity violation.
-     * 
-     * Vertex Type: listS
-     *  - Allows for low-time-complexity adding/removing edges
-     *
-     * Edge Type: listS
-     *  - Low time complexity
-     *  - Permits parallel edges to describe multiple links between blocks
-     *
-     * Directed Type: undirectedS
-     *  - The "conflict" relationship is symmetric
+     * Rows and columns in this matrix correspond to block indices, and set
+     * bits correspond to conflict relationships between those blocks. I.e. if
+     * bit j of row i is set, then blocks i and j cannot be run at the same time
+     * without causing a resource exclusivity violation. The "conflict"
+     * relationship is symmetric, so the matrix is too.
      */
-    typedef 
-      boost::adjacency_list< 
-        boost::listS, 
-        boost::listS, 
-        boost::undirectedS, 
-        DataFlowVertex::Ptr>
-          ConflictGraph;
-
-    //! Vertex descriptor for the block conflict graph
-    typedef boost::graph_traits<ConflictGraph>::vertex_descriptor ConflictVertexDescriptor;
-    //! Vertex descriptor map for retrieving DataFlowGraph vertices
-    typedef std::map<RTT::TaskContext*,ConflictVertexDescriptor> ConflictVertexMap;
-    //! Iterator for iterating over vertices in the ConflictGraph in no particular order
-    typedef boost::graph_traits<conman::graph::ConflictGraph>::vertex_iterator ConflictVertexIterator;
-    //! Iterator for iterating over adjacent vertices in the ConflictGraph in no particular order
-    typedef boost::graph_traits<conman::graph::ConflictGraph>::adjacency_iterator ConflictAdjacencyIterator;
+    typedef boost::dynamic_bitset<> ConflictSet;
+    typedef std::vector<ConflictSet> ConflictMatrix;
   }
 
   //! Exclusivity modes describe how a given port can be accessed.
   struct Exclusivity {
     typedef unsigned int Mode;
-    //! Any number of connections.
+    //! Any number of connections (the scheme doesn't combine their samples).
     static const Mode UNRESTRICTED = 0;
     //! Limit to one connection.
     static const Mode EXCLUSIVE = 1;
   };
 
+  //! Cost models used when automatically placing latches.
+  struct LatchCost {
+    typedef unsigned int Mode;
+    //! Every latched block pair costs the same.
+    static const Mode UNIFORM = 0;
+    //! Each latched block pair costs the number of port connections it delays.
+    static const Mode CONNECTIONS = 1;
+  };
+
+  //! Results of configuring a block, as reported by the scheme.
+  struct ConfigureStatus {
+    typedef int Mode;
+    //! The block could not be configured.
+    static const Mode FAILED = 0;
+    //! The block was configured.
+    static const Mode CONFIGURED = 1;
+    //! The block was running, so it was left as it was.
+    static const Mode SKIPPED = 2;
+  };
+
   //! Structure for representing groups of comopnents
   typedef std::map<std::string, std::set<std::string> > GroupMap;
 
+  //! Stable integer handle for a block or group in a scheme
+  typedef unsigned int BlockID;
+  //! The handle for names which are not blocks or groups in a scheme
+  static const BlockID INVALID_BLOCK_ID = static_cast<BlockID>(-1);
+
+  //! The result of configuring a block
+  struct ConfigureResult
+  {
+    //! The name of the block
+    std::string block;
+    //! True if the block was configured successfully (or skipped)
+    bool success;
+    //! True if the block was running, so it was left as it was
+    bool skipped;
+    //! The time it took to configure the block
+    RTT::Seconds duration;
+  };
+
+  //! A recommended policy for a connection between blocks in a scheme
+  struct ConnectionRecommendation
+  {
+    //! The source port, as "block.port"
+    std::string source;
+    //! The sink port, as "block.port"
+    std::string sink;
+    //! The current policy of the connection
+    RTT::ConnPolicy policy;
+    //! The cheapest policy which is correct for the connection
+    RTT::ConnPolicy recommended;
+    //! True if the current buffer can overflow between sink updates
+    bool undersized;
+  };
+
+  //! Execution statistics of a block, as measured by its conman hook
+  struct BlockStats
+  {
+    RTT::Seconds period;
+    RTT::Seconds period_avg;
+    RTT::Seconds period_max;
+    RTT::Seconds duration;
+    RTT::Seconds duration_avg;
+    RTT::Seconds duration_max;
+  };
+
 
   //! Get all ports for a service
   static const void GetAllPorts(
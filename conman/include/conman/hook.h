@@ -12,6 +12,7 @@
 #include <rtt/plugin/PluginLoader.hpp>
 
 #include <conman/conman.h>
+#include <conman/payload.h>
 
 namespace conman {
 
@@ -34,6 +35,14 @@ namespace conman {
       getDesiredMinPeriod("getDesiredMinPeriod"),
       setInputExclusivity("setInputExclusivity"),
       getInputExclusivity("getInputExclusivity"),
+      setPortDimension("setPortDimension"),
+      getPortDimension("getPortDimension"),
+      setPortJointNames("setPortJointNames"),
+      getPortJointNames("getPortJointNames"),
+      registerPayloadPool("registerPayloadPool"),
+      getPayloadPoolCapacity("getPayloadPoolCapacity"),
+      getPayloadPoolAvailable("getPayloadPoolAvailable"),
+      getPayloadPoolExhausted("getPayloadPoolExhausted"),
       getTime("getTime"),
       getPeriod("getPeriod"),
       getPeriodAvg("getPeriodAvg"),
@@ -52,6 +61,15 @@ namespace conman {
       this->addOperationCaller(getDesiredMinPeriod);
       this->addOperationCaller(setInputExclusivity);
       this->addOperationCaller(getInputExclusivity);
+      this->addOperationCaller(setPortDimension);
+      this->addOperationCaller(getPortDimension);
+      this->addOperationCaller(setPortJointNames);
+      this->addOperationCaller(getPortJointNames);
+
+      this->addOperationCaller(registerPayloadPool);
+      this->addOperationCaller(getPayloadPoolCapacity);
+      this->addOperationCaller(getPayloadPoolAvailable);
+      this->addOperationCaller(getPayloadPoolExhausted);
 
       this->addOperationCaller(getTime);
 
@@ -80,6 +98,24 @@ namespace conman {
     RTT::OperationCaller<conman::Exclusivity::Mode(const std::string&)>
       getInputExclusivity;
 
+    RTT::OperationCaller<bool(const std::string&, const unsigned int)>
+      setPortDimension;
+    RTT::OperationCaller<unsigned int(const std::string&)>
+      getPortDimension;
+    RTT::OperationCaller<bool(const std::string&, const std::vector<std::string>&)>
+      setPortJointNames;
+    RTT::OperationCaller<std::vector<std::string>(const std::string&)>
+      getPortJointNames;
+
+    RTT::OperationCaller<bool(const std::string&, conman::PayloadPoolBase::Ptr)>
+      registerPayloadPool;
+    RTT::OperationCaller<unsigned int(const std::string&)>
+      getPayloadPoolCapacity;
+    RTT::OperationCaller<unsigned int(const std::string&)>
+      getPayloadPoolAvailable;
+    RTT::OperationCaller<unsigned long(const std::string&)>
+      getPayloadPoolExhausted;
+
     RTT::OperationCaller<RTT::Seconds(void)>
       getTime;
 
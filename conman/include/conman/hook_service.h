@@ -12,9 +12,11 @@
 #include <rtt/RTT.hpp>
 #include <rtt/Service.hpp>
 #include <rtt/Logger.hpp>
+#include <rtt/os/Mutex.hpp>
 #include <rtt/plugin/PluginLoader.hpp>
 
 #include <conman/conman.h>
+#include <conman/payload.h>
 
 namespace conman {
   
@@ -58,6 +60,59 @@ namespace conman {
 
     //\}
 
+    /** \name Conman Port Contracts
+     *
+     * The shape of the data on a port can be declared so that connections
+     * between ports with different shapes are reported by the scheme when it
+     * models them, instead of checking each sample at runtime. The scheme
+     * leaves these connections alone, but it doesn't model them, and it
+     * can't be started until they're removed.
+     */
+    //\{
+
+    //! Set the dimension of the samples on a port (0 if unspecified)
+    bool setPortDimension(
+        const std::string &port_name,
+        const unsigned int dimension);
+
+    //! Get the dimension of the samples on a port (0 if unspecified)
+    unsigned int getPortDimension(
+        const std::string &port_name);
+
+    //! Set the names of the joints of a joint-space port (this also sets its dimension)
+    bool setPortJointNames(
+        const std::string &port_name,
+        const std::vector<std::string> &joint_names);
+
+    //! Get the names of the joints of a joint-space port (empty if unspecified)
+    std::vector<std::string> getPortJointNames(
+        const std::string &port_name);
+
+    //\}
+
+    /** \name Payload Pool Introspection */
+    //\{
+
+    /** \brief Register a payload pool so that its statistics can be inspected
+     *
+     * This should be called while the owner is configured, it fails while the
+     * owner is running. The pools are guarded by a mutex, so this can be
+     * called from any thread.
+     */
+    bool registerPayloadPool(
+        const std::string &pool_name,
+        conman::PayloadPoolBase::Ptr pool);
+    //! Get the names of the registered payload pools
+    std::vector<std::string> getPayloadPools() const;
+    //! Get the number of payloads in a pool
+    unsigned int getPayloadPoolCapacity(const std::string &pool_name) const;
+    //! Get the number of payloads in a pool which are not in use
+    unsigned int getPayloadPoolAvailable(const std::string &pool_name) const;
+    //! Get the number of times a payload was requested from an empty pool
+    unsigned long getPayloadPoolExhausted(const std::string &pool_name) const;
+
+    //\}
+
     /** \name Time Introspection */
     //\{
     //! Get the current execution time
@@ -127,10 +182,42 @@ namespace conman {
       // Currently no output port properties
     };
 
+    //! The declared shape of the samples on a port
+    struct PortShape {
+      PortShape() : dimension(0) { }
+      //! The dimension of the samples (0 if unspecified)
+      unsigned int dimension;
+      //! The names of the joints for joint-space samples
+      std::vector<std::string> joint_names;
+    };
+
+    /** \brief Mutex protecting the port annotations and shapes
+     *
+     * A scheme can configure several blocks concurrently, and their
+     * configureHooks set these while other threads may be reading them.
+     */
+    mutable RTT::os::Mutex config_mutex_;
+
+    //! Map port names onto their declared shapes
+    std::map<std::string, PortShape> port_shapes_;
+
     //! Map port names onto port annotations
     std::map<std::string, InputProperties> input_ports_;
     std::map<std::string, OutputProperties> output_ports_;
 
+    //! Mutex protecting the payload pool map
+    mutable RTT::os::Mutex pools_mutex_;
+
+    //! Map pool names onto the owner's payload pools
+    std::map<std::string, conman::PayloadPoolBase::Ptr> payload_pools_;
+
+    /** \brief Get a registered payload pool by name (NULL if it isn't
+     * registered)
+     *
+     * The pool mutex must be locked while the pool is used.
+     */
+    conman::PayloadPoolBase* getPayloadPool(const std::string &pool_name) const;
+
     /** \brief Get a port by name
      *
      * Currently, just a pass-through to the owning TaskContext's getPort(), but
@@ -0,0 +1,261 @@
+/** Copyright (c) 2013, Jonathan Bohren, all rights reserved.
+ * This software is released under the BSD 3-clause license, for the details of
+ * this license, please see LICENSE.txt at the root of this repository.
+ */
+
+#ifndef __CONMAN_PAYLOAD_H
+#define __CONMAN_PAYLOAD_H
+
+#include <vector>
+
+#include <rtt/Port.hpp>
+#include <rtt/os/Atomic.hpp>
+#include <rtt/os/Mutex.hpp>
+#include <rtt/os/MutexLock.hpp>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_array.hpp>
+
+namespace conman
+{
+  template <class T> class PayloadPool;
+
+  namespace detail
+  {
+    template <class T> struct PayloadStorage;
+
+    //! A pooled payload and its reference count
+    template <class T>
+    struct PayloadNode
+    {
+      //! The number of handles to this payload
+      RTT::os::AtomicInt refs;
+      //! The storage this payload belongs to
+      PayloadStorage<T> *storage;
+      //! The payload itself
+      T value;
+    };
+
+    /** \brief The payloads of a pool
+     *
+     * This is reference counted separately from the pool so that payloads
+     * which are still held by ports or readers can be released after the pool
+     * is destroyed.
+     */
+    template <class T>
+    struct PayloadStorage
+    {
+      PayloadStorage(const size_t capacity, const T &sample) :
+        refs(1),
+        capacity(capacity),
+        nodes(new PayloadNode<T>[capacity]),
+        exhausted(0)
+      {
+        free_nodes.reserve(capacity);
+        for(size_t i=0; i < capacity; i++) {
+          nodes[i].storage = this;
+          nodes[i].value = sample;
+          free_nodes.push_back(&nodes[i]);
+        }
+      }
+
+      //! Return a node to the free list
+      void release(PayloadNode<T> *node)
+      {
+        {
+          RTT::os::MutexLock lock(mutex);
+          free_nodes.push_back(node);
+        }
+
+        // Each node which is in use holds a reference to the storage
+        if(refs.dec_and_test()) {
+          delete this;
+        }
+      }
+
+      //! The number of references (the pool plus each node in use)
+      RTT::os::AtomicInt refs;
+      //! The number of payloads
+      const size_t capacity;
+      //! The payloads
+      boost::scoped_array<PayloadNode<T> > nodes;
+      //! The payloads which are not in use (preallocated to the capacity)
+      std::vector<PayloadNode<T>*> free_nodes;
+      //! The number of times a payload was requested from the empty pool
+      unsigned long exhausted;
+      //! Guards the free list and statistics
+      RTT::os::Mutex mutex;
+    };
+  }
+
+  /** \brief Reference-counted handle to an immutable pooled payload
+   *
+   * Copying a handle only changes a reference count, so these can be passed
+   * through RTT ports in place of large samples like images or point clouds.
+   * When the last handle to a payload is destroyed, it is returned to its
+   * PayloadPool. Readers only get const access to the payload.
+   */
+  template <class T>
+  class SharedPayload
+  {
+  public:
+    SharedPayload() : node_(NULL) { }
+
+    SharedPayload(const SharedPayload &other) : node_(other.node_)
+    {
+      if(node_) { node_->refs.inc(); }
+    }
+
+    ~SharedPayload()
+    {
+      Release(node_);
+    }
+
+    SharedPayload& operator=(const SharedPayload &other)
+    {
+      if(other.node_) { other.node_->refs.inc(); }
+      detail::PayloadNode<T> *old_node = node_;
+      node_ = other.node_;
+      Release(old_node);
+      return *this;
+    }
+
+    //! Drop this handle's reference to the payload
+    void reset()
+    {
+      Release(node_);
+      node_ = NULL;
+    }
+
+    //! True if this handle doesn't refer to a payload
+    bool empty() const { return node_ == NULL; }
+
+    const T* get() const { return node_ ? &node_->value : NULL; }
+    const T& operator*() const { return node_->value; }
+    const T* operator->() const { return &node_->value; }
+
+  private:
+    friend class PayloadPool<T>;
+
+    //! Construct a handle to a node which already holds a reference
+    explicit SharedPayload(detail::PayloadNode<T> *node) : node_(node) { }
+
+    static void Release(detail::PayloadNode<T> *node)
+    {
+      if(node && node->refs.dec_and_test()) {
+        node->storage->release(node);
+      }
+    }
+
+    detail::PayloadNode<T> *node_;
+  };
+
+  //! Statistics interface for payload pools of any type
+  class PayloadPoolBase
+  {
+  public:
+    typedef boost::shared_ptr<PayloadPoolBase> Ptr;
+
+    virtual ~PayloadPoolBase() { }
+
+    //! The number of payloads in the pool
+    virtual unsigned int capacity() const = 0;
+    //! The number of payloads which are not in use
+    virtual unsigned int available() const = 0;
+    //! The number of times a payload was requested from the empty pool
+    virtual unsigned long exhausted() const = 0;
+  };
+
+  /** \brief Fixed-size pool of recyclable payloads
+   *
+   * All of the payloads are allocated and initialized from a sample when the
+   * pool is constructed (in a block's configureHook), so allocating a payload
+   * is realtime-safe. If all of the payloads are in use, allocate() returns
+   * NULL instead of growing the pool.
+   *
+   * A writer fills the payload returned by allocate() and then writes the
+   * handle to a port; it must not modify the payload after publishing it.
+   * Note that connections keep a handle to the last sample they carried, so
+   * a pool needs a few more payloads than are in flight at once.
+   */
+  template <class T>
+  class PayloadPool : public PayloadPoolBase
+  {
+  public:
+    typedef boost::shared_ptr<PayloadPool<T> > Ptr;
+
+    PayloadPool(const size_t capacity, const T &sample = T()) :
+      storage_(new detail::PayloadStorage<T>(capacity, sample))
+    { }
+
+    virtual ~PayloadPool()
+    {
+      // The storage is deleted once the last payload in use is released
+      if(storage_->refs.dec_and_test()) {
+        delete storage_;
+      }
+    }
+
+    /** \brief Get an unused payload to fill
+     *
+     * \param payload The handle to publish once the payload is filled
+     *
+     * Returns a pointer to the payload, or NULL if the pool is exhausted.
+     */
+    T* allocate(SharedPayload<T> &payload)
+    {
+      detail::PayloadNode<T> *node = NULL;
+      {
+        RTT::os::MutexLock lock(storage_->mutex);
+        if(storage_->free_nodes.empty()) {
+          storage_->exhausted++;
+        } else {
+          node = storage_->free_nodes.back();
+          storage_->free_nodes.pop_back();
+        }
+      }
+
+      if(node == NULL) {
+        payload.reset();
+        return NULL;
+      }
+
+      // The node holds a reference to the storage while it's in use
+      storage_->refs.inc();
+      node->refs.set(1);
+      payload = SharedPayload<T>(node);
+
+      return &node->value;
+    }
+
+    virtual unsigned int capacity() const
+    {
+      return storage_->capacity;
+    }
+
+    virtual unsigned int available() const
+    {
+      RTT::os::MutexLock lock(storage_->mutex);
+      return storage_->free_nodes.size();
+    }
+
+    virtual unsigned long exhausted() const
+    {
+      RTT::os::MutexLock lock(storage_->mutex);
+      return storage_->exhausted;
+    }
+
+  private:
+    detail::PayloadStorage<T> *storage_;
+  };
+
+  //! Port types which carry pooled payloads
+  template <class T>
+  struct PayloadPort
+  {
+    typedef RTT::InputPort<SharedPayload<T> > Input;
+    typedef RTT::OutputPort<SharedPayload<T> > Output;
+  };
+}
+
+#endif // ifndef __CONMAN_PAYLOAD_H
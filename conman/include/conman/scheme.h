@@ -6,7 +6,10 @@
 #ifndef __CONMAN_SCHEME_H
 #define __CONMAN_SCHEME_H
 
+#include <rtt/os/Mutex.hpp>
+
 #include <conman/conman.h>
+#include <conman/scheme_fork.h>
 
 namespace conman
 {
@@ -48,10 +51,19 @@ namespace conman
     //! Check if a block is in the scheme
     bool hasBlock(const std::string &name) const;
 
-    //! Get the names of all the blocks in this scheme
+    /** \brief Get the names of all the blocks in this scheme
+     *
+     * This always allocates the returned vector, so use the overload below
+     * when the scheme has a capacity.
+     */
     std::vector<std::string> getBlocks() const;
 
-    //! Get the names of all the blocks in this scheme
+    /** \brief Get the names of all the blocks in this scheme
+     *
+     * The names are copied into the storage which is already in the vector,
+     * so when the same vector is reused, this doesn't allocate unless the
+     * blocks have changed.
+     */
     void getBlocks(std::vector<std::string> &blocks) const;
 
     /** \brief Add a block which is already a peer of this scheme by name. */
@@ -67,6 +79,91 @@ namespace conman
     /** \brief Remove a block from the scheme */
     bool removeBlock(RTT::TaskContext *block);
 
+    /** \brief Add several blocks which are already peers of this scheme by
+     * name, regenerating the model only once. */
+    bool addBlocks(const std::vector<std::string> &names);
+
+    /** \brief Reserve storage for a maximum number of blocks and groups
+     *
+     * Once a capacity is set, adding more blocks or groups than it allows
+     * fails, and the storage used by the ID-based runtime operations and
+     * queries is preallocated, so that they never allocate memory. This fails
+     * if the scheme already has more blocks or groups than the capacity.
+     */
+    bool setCapacity(
+        const unsigned int max_blocks,
+        const unsigned int max_groups);
+
+    //\}
+
+    ///////////////////////////////////////////////////////////////////////////
+    /** \name Model Edit Transactions
+     *
+     * Normally, each modification of the scheme (adding or removing blocks,
+     * latching connections, etc.) regenerates the DFG and ESG, recomputes
+     * conflicts, and recomputes the execution ordering. When several
+     * modifications are made between a call to \ref beginEdit and a call to
+     * \ref commit, this is only done once, when the outermost transaction is
+     * committed.
+     *
+     * Transactions can be nested, and the scheme cannot be started while a
+     * transaction is open.
+     */
+    //\{
+
+    //! Begin a transaction of scheme modifications
+    bool beginEdit();
+
+    /** \brief Commit a transaction of scheme modifications
+     *
+     * If this closes the outermost transaction, this regenerates the model
+     * and returns the result.
+     */
+    bool commit();
+
+    //! Check if a transaction is open
+    bool isEditing() const;
+
+    //\}
+
+    ///////////////////////////////////////////////////////////////////////////
+    /** \name Scheme Description Files
+     *
+     * A scheme description file declares the blocks, groups, latches, rates,
+     * and enabled blocks of a scheme, one declaration per line:
+     * <pre>
+     *    # Comments start with a hash
+     *    block <block> [<block> ...]
+     *    group <group> <member> [<member> ...]
+     *    latch <source block or group> <sink block or group>
+     *    latch_inputs <block or group>
+     *    latch_outputs <block or group>
+     *    period <block or group> <desired min period in seconds>
+     *    enable <block or group> [<block or group> ...]
+     * </pre>
+     * The blocks must already be peers of the scheme. The whole file is
+     * loaded in a single edit transaction.
+     *
+     * The computed model (execution ordering and conflicts) can be saved to a
+     * binary snapshot, which is validated against a hash of the modeled
+     * blocks, port connections, and latches when it is loaded, so that a
+     * scheme can be restored without recomputing it.
+     */
+    //\{
+
+    /** \brief Load a scheme description file
+     *
+     * If a snapshot file is given and it matches the loaded model, the
+     * execution ordering and conflicts are restored from it. Otherwise, they
+     * are computed and the snapshot file is (re)written.
+     */
+    bool loadScheme(
+        const std::string &scheme_file,
+        const std::string &snapshot_file);
+
+    //! Save a binary snapshot of the computed model
+    bool saveSnapshot(const std::string &snapshot_file) const;
+
     //\}
 
     ///////////////////////////////////////////////////////////////////////////
@@ -174,10 +271,25 @@ namespace conman
      * Note that self-loops are implicitly latched, so adding latches on the
      * connections from a component to itself is a no-op.
      *
+     * When possible, the sink of a latched connection is executed before its
+     * source, so that it always reads the sample written in the previous
+     * cycle. This is not possible if the sink also depends on the source
+     * through unlatched connections (see latchesDelayed()).
+     *
      */
     //\{
 
-    //! Add/Remove a latch between two blocks (or two groups of blocks) by name
+    /** \brief Add/Remove a latch between two blocks (or two groups of blocks) by name
+     *
+     * This returns true if the latches were applied, even if the scheme is
+     * still not executable (see executable()). Latches are always applied,
+     * but if the scheme is executable and the sink of a new latch depends on
+     * its source through unlatched connections, the latch can't delay its
+     * connections by a cycle, so this returns false.
+     *
+     * When this is called in an open edit transaction, the delay can't be
+     * checked until the transaction is committed (see latchesDelayed()).
+     */
     bool latchConnections(
       const std::string &source_name,
       const std::string &sink_name,
@@ -203,6 +315,30 @@ namespace conman
     bool latchOutputs(const std::string &name, const bool latch);
     //! Set latching for all current and future input arcs to a given block
     bool latchOutputs(RTT::TaskContext *block, const bool latch);
+
+    /** \brief Propose a set of latches which makes the ESG acyclic
+     *
+     * This computes an approximate minimum-cost feedback arc set of the
+     * Execution Scheduling Graph (ESG) using the Eades-Lin-Smyth heuristic on
+     * each of its non-trivial strongly-connected components. Arcs which can be
+     * restored without re-introducing a cycle are then removed from the set.
+     *
+     * The proposed latch between \p sources[i] and \p sinks[i] is not applied.
+     * It returns the number of proposed latches.
+     *
+     * \param cost The \ref conman::LatchCost model used to weight each arc.
+     */
+    int proposeLatches(
+      std::vector<std::string> &sources,
+      std::vector<std::string> &sinks,
+      const conman::LatchCost::Mode cost) const;
+
+    /** \brief Propose and optionally apply latches which make the ESG acyclic
+     *
+     * See \ref proposeLatches. It returns the number of proposed latches, or
+     * -1 if they could not be applied.
+     */
+    int autoLatch(const conman::LatchCost::Mode cost, const bool apply);
     //\}
 
     ///////////////////////////////////////////////////////////////////////////
@@ -227,6 +363,10 @@ namespace conman
     /** \brief Get the number of latches in a given path through the DFG. */
     int latchCount(const std::vector<std::string> &path) const;
 
+    /** \brief Get the number of latches in a given path through the DFG,
+     * where each element of the path is a block's vertex index. */
+    int latchCount(const std::vector<unsigned int> &path) const;
+
     /** \brief Get the maximum number of latches in any cycle in the DFG. */
     int maxLatchCount() const;
 
@@ -234,6 +374,17 @@ namespace conman
      * DFG has no cycles, this returns 0.*/
     int minLatchCount() const;
 
+    /** \brief Get the version of the scheme model
+     *
+     * The model version is incremented whenever blocks, arcs, connections, or
+     * latches are added to or removed from the DFG or ESG. The results of the
+     * latch analysis are cached for a given model version.
+     *
+     * The version is only modified by own-thread operations, so the RTT
+     * operation is also executed in the scheme's thread.
+     */
+    unsigned long getModelVersion() const;
+
     //\}
 
     ///////////////////////////////////////////////////////////////////////////
@@ -261,6 +412,14 @@ namespace conman
      */
     bool executable() const;
 
+    /** \brief Returns true if the sink of every latched connection is executed
+     * before its source
+     *
+     * In this case, each latched sink reads exactly the sample which was
+     * written in the previous cycle.
+     */
+    bool latchesDelayed() const;
+
     /** \brief Computes all simple cycles in the pending Execution Scheduling
      * Graph (ESG).
      *
@@ -272,11 +431,72 @@ namespace conman
 
     /** \brief Gets the execution order for the scheme or if it can't be
      * executed, returns false.
+     *
+     * Like \ref getBlocks, this reuses the storage in the vector, so it
+     * doesn't allocate when the same vector is reused.
      */
     bool getExecutionOrder(std::vector<std::string> &order) const;
 
     //\}
 
+    ///////////////////////////////////////////////////////////////////////////
+    /** \name What-If Analysis
+     *
+     * A fork of the scheme model can be modified and analyzed (adding blocks,
+     * latching connections, enabling blocks, and computing orderings and
+     * conflicts) without modifying the scheme, even while it is running.
+     */
+    //\{
+
+    /** \brief Fork the scheme model
+     *
+     * Forks share the model until they are modified, and the model is only
+     * copied from the scheme's graphs when the model version or block groups
+     * have changed since the last fork.
+     *
+     * The scheme's model is only modified in its own thread while it is
+     * stopped, so calling this from another thread is only safe while the
+     * scheme is running. Forks refer to the blocks directly, so they can't be
+     * passed through RTT operations. Other threads and processes should use
+     * the what-if operations below, which are executed in the scheme's thread.
+     */
+    conman::SchemeFork fork() const;
+
+    /** \brief Check if the scheme would be executable with more blocks or latches
+     *
+     * \param add_blocks The names of peers of the scheme to add
+     * \param latch_sources The sources of the connections to latch
+     * \param latch_sinks The sinks of the connections to latch (one for each
+     * source)
+     */
+    bool whatIfExecutable(
+        const std::vector<std::string> &add_blocks,
+        const std::vector<std::string> &latch_sources,
+        const std::vector<std::string> &latch_sinks) const;
+
+    /** \brief Get the execution ordering with more blocks or latches
+     *
+     * This returns an empty ordering if the scheme wouldn't be executable.
+     * See whatIfExecutable() for the arguments.
+     */
+    std::vector<std::string> whatIfExecutionOrder(
+        const std::vector<std::string> &add_blocks,
+        const std::vector<std::string> &latch_sources,
+        const std::vector<std::string> &latch_sinks) const;
+
+    /** \brief Get the blocks which would be enabled after enabling some blocks
+     *
+     * \param enable_names The blocks or groups to enable
+     * \param force If true, conflicting blocks would be disabled
+     *
+     * This returns an empty list if the blocks couldn't be enabled.
+     */
+    std::vector<std::string> whatIfEnableBlocks(
+        const std::vector<std::string> &enable_names,
+        const bool force) const;
+
+    //\}
+
 
     ///////////////////////////////////////////////////////////////////////////
     /** \name Runtime Scheme Control
@@ -375,14 +595,227 @@ namespace conman
 
     //\}
 
+    ///////////////////////////////////////////////////////////////////////////
+    /** \name Demand-Driven Execution
+     *
+     * In demand-driven mode, an enabled block is only updated if it
+     * contributes to an enabled sink. Sinks are blocks which have no outputs
+     * in the DFG, and blocks which have been marked as required. A block
+     * contributes to a sink if there is a path of enabled blocks from it to the
+     * sink in the DFG (latched connections are included, since they still
+     * carry data).
+     *
+     * Enabled blocks which don't contribute to any sink remain running, but
+     * they are skipped in updateHook(). The demanded blocks are only recomputed
+     * when the set of running blocks or the model changes.
+     */
+    //\{
+
+    //! Enable or disable demand-driven execution
+    void setDemandDriven(const bool demand_driven);
+    //! Check if demand-driven execution is enabled
+    bool isDemandDriven() const;
+    //! Mark a block (or the blocks in a group) as required sinks
+    bool setRequired(const std::string &block_name, const bool required);
+    //! Check if a block is marked as required
+    bool isRequired(const std::string &block_name) const;
+    //! Check if an enabled block contributes to an enabled sink
+    bool isDemanded(const std::string &block_name) const;
+
+    //\}
+
+    ///////////////////////////////////////////////////////////////////////////
+    /** \name Local Connections
+     *
+     * All of the blocks in a scheme are executed one after another by the
+     * scheme's thread, so the connections between them don't need to be
+     * synchronized. When local connections are enabled, the scheme reconnects
+     * the connections between its blocks with the same connection policy but
+     * without locking (RTT::ConnPolicy::UNSYNC), and restores the original
+     * lock policy when they are disabled or when a block is removed from the
+     * scheme.
+     *
+     * The connections are still RTT channels, only their locking is
+     * removed; the ports don't share a slot. A connection is reconnected with
+     * RTT::ConnPolicy::init set, so the source's last written sample is
+     * carried over into the new channel, but any other unread samples in a
+     * buffered connection are dropped.
+     *
+     * Connections to ports outside of the scheme are not modified.
+     */
+    //\{
+
+    //! Enable or disable unsynchronized connections between the blocks
+    bool setLocalConnections(const bool local);
+    //! Check if the connections between the blocks are unsynchronized
+    bool hasLocalConnections() const;
+
+    /** \brief Recommend the cheapest correct policy for each connection
+     * between blocks in the scheme
+     *
+     * Connections between blocks don't need to be synchronized. Buffered
+     * connections whose source writes at most one sample between sink
+     * updates (according to the blocks' desired minimum periods) only need to
+     * hold the newest sample. Other buffers are sized to hold all of the
+     * samples written between sink updates, and are reported as undersized if
+     * they can't hold them already.
+     *
+     * \param apply If true, the connections are rewired with the recommended
+     * policies, this requires that the scheme is stopped
+     * \param recommendations The recommendation for each connection
+     *
+     * Returns the number of connections whose recommended policy differs
+     * from their current policy, or -1 on failure.
+     */
+    int optimizeConnections(
+        const bool apply,
+        std::vector<conman::ConnectionRecommendation> &recommendations);
+    //! Recommend (and optionally apply) connection policies, and log them
+    int optimizeConnections(const bool apply);
+
+    //\}
+
+    ///////////////////////////////////////////////////////////////////////////
+    /** \name Block Configuration
+     *
+     * Blocks need to be configured before they can be enabled. Since blocks
+     * may take a long time to configure (loading parameters, etc), groups of
+     * blocks can be configured concurrently on a bounded number of threads.
+     */
+    //\{
+
+    /** \brief Configure blocks (or groups) concurrently
+     *
+     * \param block_names The blocks and groups to configure
+     * \param max_threads The maximum number of threads to use, or 0 to use
+     * one per core
+     * \param report The configure result for each block
+     *
+     * This blocks the scheme's thread until all of the blocks are
+     * configured, so it can only be called while the scheme is not running.
+     * Blocks which are running are already configured, so they are skipped.
+     *
+     * The blocks' configureHooks are called concurrently. The conman hook
+     * guards its own configuration, but anything else which blocks share
+     * while they are configured (globals, files, devices) needs to be
+     * thread-safe.
+     *
+     * Returns true if all of the blocks were configured successfully.
+     */
+    bool configureBlocks(
+        const std::vector<std::string> &block_names,
+        const unsigned int max_threads,
+        std::vector<conman::ConfigureResult> &report);
+
+    /** \brief Configure blocks (or groups) concurrently, and report the
+     * results in parallel lists
+     *
+     * This is the same as the above, but the report only uses types which
+     * have typekits, so it can be used from scripts and other processes.
+     *
+     * \param configured_blocks The name of each block
+     * \param status The conman::ConfigureStatus of each block
+     * \param durations The time it took to configure each block
+     */
+    bool configureBlocks(
+        const std::vector<std::string> &block_names,
+        const unsigned int max_threads,
+        std::vector<std::string> &configured_blocks,
+        std::vector<int> &status,
+        std::vector<double> &durations);
+
+    /** \brief Configure all of the blocks, or the blocks in a group,
+     * concurrently
+     *
+     * If the group name is empty, all blocks are configured. The configure
+     * results are logged.
+     */
+    bool configureBlocks(
+        const std::string &group_name,
+        const unsigned int max_threads);
+
+    //\}
+
+    ///////////////////////////////////////////////////////////////////////////
+    /** \name Block IDs
+     *
+     * Each block and group is issued an integer ID when it is added to the
+     * scheme. IDs are never reused, even after their block or group is
+     * removed.
+     *
+     * The operations which take IDs instead of names do not look up, compare,
+     * or copy strings. Once a group has been expanded, they also do not
+     * allocate memory unless they fail and log an error, so they can be used
+     * by high-rate supervisors and realtime callers.
+     *
+     * Like the operations which modify the scheme, they are executed in the
+     * scheme's thread, so they can't race with blocks or groups being added
+     * or removed.
+     */
+    //\{
+
+    //! Get the ID of a block or group, or INVALID_BLOCK_ID if there is none
+    conman::BlockID getBlockID(const std::string &name) const;
+    //! Get the name of a block or group by ID, or an empty string
+    std::string getBlockName(const conman::BlockID id) const;
+
+    //! Check if a list of blocks (or groups) can be enabled by ID
+    bool enableable(const std::vector<conman::BlockID> &block_ids) const;
+    //! Enable multiple blocks (or groups) by ID, see \ref enableBlocks
+    bool enableBlocks(
+        const std::vector<conman::BlockID> &block_ids,
+        const bool strict,
+        const bool force);
+    //! Disable multiple blocks (or groups) by ID
+    bool disableBlocks(
+        const std::vector<conman::BlockID> &block_ids,
+        const bool strict);
+    //! Disable and enable blocks (or groups) by ID, see \ref switchBlocks
+    bool switchBlocks(
+        const std::vector<conman::BlockID> &disable_block_ids,
+        const std::vector<conman::BlockID> &enable_block_ids,
+        const bool strict,
+        const bool force);
+
+    /** \brief Get the execution ordering of the blocks by ID
+     *
+     * This doesn't allocate memory if the ID vector has enough capacity.
+     * Returns false if the scheme isn't executable.
+     */
+    bool getExecutionOrder(std::vector<conman::BlockID> &order) const;
+
+    //! Check if a block is enabled by ID
+    bool isEnabled(const conman::BlockID id) const;
+    //! Get the execution statistics of a block by ID
+    bool getBlockStats(
+        const conman::BlockID id,
+        conman::BlockStats &stats) const;
+
+    //\}
+
     /** \brief (Re)generates an internal model of the RTT port connection graph
      *
      * This will populate the Data Flow Graph (DFG), the Execution Scheduling
      * Graph (ESG), and the Runtime Conflict Graph (RCG). The scheme must be 
      *
+     * Connections between ports whose declared shapes differ (see the conman
+     * hook's port contracts) are left connected but aren't modeled, and this
+     * returns false until they're removed.
      */
     bool regenerateModel();
 
+    /** \brief Incrementally update the model with changed port connections
+     *
+     * This only models the connections of output ports whose number of
+     * connections changed since they were last modeled, instead of rescanning
+     * every connection in the scheme. This is called when the scheme is
+     * started. The connections which are already modeled are checked against
+     * their ports' declared shapes again, since blocks can declare them
+     * whenever they're configured. Returns false if the updated ESG cannot be
+     * scheduled, or if any connection doesn't match its ports' shapes.
+     */
+    bool updateModel();
+
     ///////////////////////////////////////////////////////////////////////////
     //! \name Orocos RTT Hooks
     //\{
@@ -421,11 +854,45 @@ namespace conman
      * fast access)
      */
     std::map<std::string,conman::graph::DataFlowVertex::Ptr> blocks_;
-    //! A list of blocks ordered by index (for linear re-indexing)
-    std::list<conman::graph::DataFlowVertex::Ptr> block_indices_;
+    //! The blocks ordered by index (for linear re-indexing)
+    std::vector<conman::graph::DataFlowVertex::Ptr> block_indices_;
     //! A map of block group names to block names
     conman::GroupMap block_groups_;
 
+    //! The name of each block or group, by ID (empty if it was removed)
+    std::vector<std::string> id_names_;
+    //! The vertex of each block, by ID (NULL for groups and removed blocks)
+    std::vector<conman::graph::DataFlowVertex::Ptr> id_vertices_;
+    //! The ID of each block and group, by name
+    std::map<std::string, conman::BlockID> ids_;
+    //! The maximum number of blocks, or 0 if unbounded
+    unsigned int max_blocks_;
+    //! The maximum number of groups, or 0 if unbounded
+    unsigned int max_groups_;
+
+    //! The flattened membership of a group
+    struct GroupExpansion
+    {
+      GroupExpansion() : expanded(false), complete(false) { }
+
+      //! True if this expansion is up-to-date
+      bool expanded;
+      //! False if any of the members could not be expanded
+      bool complete;
+      //! The names of the member blocks, in sorted order
+      std::vector<std::string> members;
+      //! The member blocks, by vertex index
+      conman::graph::ConflictSet blocks;
+    };
+
+    /** \brief Flattened group memberships by ID, computed when a group is
+     * first expanded
+     *
+     * These are invalidated whenever a group's membership changes or a block
+     * is added to or removed from the scheme.
+     */
+    mutable std::vector<GroupExpansion> group_expansions_;
+
     //! \name Data Flow Graph Structures
     //\{
     //! Data Flow Graph (DFG) 
@@ -435,32 +902,264 @@ namespace conman
 
     //! \name Execution Sampling Graph Structures
     //\{
-    //! Execution Scheduling Graph (ESG)
-    conman::graph::DataFlowGraph exec_graph_;
-    //! Mappings from TaskContext pointers to boost vertex descriptors
-    conman::graph::DataFlowVertexTaskMap exec_vertex_map_;
+    //! Execution Scheduling Graph (ESG), a view of the DFG without latched edges
+    conman::graph::ExecutionGraph exec_graph_;
     //! Topologically sorted ordering of each graph
     conman::graph::ExecutionOrdering exec_ordering_;
+    //! The model version for which the execution ordering was computed
+    unsigned long exec_ordering_version_;
+    //! The ports connected to each output port when it was last modeled
+    std::map<RTT::base::PortInterface*, std::vector<RTT::base::PortInterface*> > port_peers_;
+    //! False if a connection was left out of the model because its ports'
+    //! declared shapes differ
+    bool contracts_satisfied_;
     //\}
 
     //! \name Runtime Conflict Graph Structures
     //\{
-    /** \brief Graph representing block conflicts 
+    /** \brief Matrix representing block conflicts 
      *
-     * Adjacent vertices in the Rtunime Conflict Graph represent components
-     * that can't run simultaneously.
+     * Set bits in the Runtime Conflict Graph matrix represent pairs of
+     * components (by vertex index) that can't run simultaneously.
      */
-    conman::graph::ConflictGraph conflict_graph_;
-    /** \brief A map from RTT TaskContext pointers to vertex identifiers in the
-     * conflict graph
+    conman::graph::ConflictMatrix conflict_matrix_;
+    /** \brief The exclusivity of each input port of the blocks in the scheme,
+     * cached when the block is added
+     */
+    std::map<const RTT::base::PortInterface*, conman::Exclusivity::Mode> input_exclusivity_;
+    /** \brief The blocks (by vertex index) which are running
+     *
+     * This is updated when blocks are enabled or disabled through the scheme,
+     * and on every scheme update. Blocks can also be started or stopped
+     * directly, so the bits of the blocks involved in a conflict check are
+     * resynchronized with syncRunningBlocks() before each check.
+     */
+    mutable conman::graph::ConflictSet running_blocks_;
+    //\}
+
+    //! \name Demand-Driven Execution Structures
+    //\{
+    //! True if blocks which don't contribute to a sink are skipped
+    bool demand_driven_;
+    //! The blocks (by vertex index) which are marked as required sinks
+    conman::graph::ConflictSet required_blocks_;
+    //! The running blocks (by vertex index) which contribute to a sink
+    mutable conman::graph::ConflictSet demanded_blocks_;
+    //! The running blocks for which the demanded blocks were computed
+    mutable conman::graph::ConflictSet demand_running_blocks_;
+    //! The model version for which the demanded blocks were computed
+    mutable unsigned long demand_version_;
+    //! Scratch stack of vertex indices for computing the demanded blocks
+    mutable std::vector<unsigned int> demand_stack_;
+
+    //! Recompute the demanded blocks if the running blocks or model changed
+    void updateDemand() const;
+    //\}
+
+    //! \name Local Connection Structures
+    //\{
+    //! True if the connections between blocks are unsynchronized
+    bool local_connections_;
+    //! The original lock policy of each unsynchronized connection
+    std::map<std::pair<RTT::base::PortInterface*, RTT::base::PortInterface*>, int> local_lock_policies_;
+
+    /** \brief Reconnect a connection without locking, or with its original
+     * lock policy
      */
-    conman::graph::ConflictVertexMap conflict_vertex_map_;
+    bool localizeConnection(
+        RTT::base::PortInterface *source_port,
+        RTT::base::PortInterface *sink_port,
+        const bool local);
     //\}
     
+    /** \brief The version of the DFG and ESG model
+     *
+     * This is incremented whenever the topology or latching of the model
+     * changes.
+     */
+    unsigned long model_version_;
+
+    //! The number of open edit transactions
+    unsigned int edit_depth_;
+    //! True if the model was modified since the outermost transaction began
+    bool model_update_pending_;
+    //! Computed model which can be restored without recomputing it
+    struct ModelSnapshot
+    {
+      //! Hash of the blocks, connections, latches, and groups which were modeled
+      boost::uint64_t model_hash;
+      //! The names of the blocks in execution order
+      std::vector<std::string> ordering;
+      //! Pairs of names of conflicting blocks
+      std::vector<std::pair<std::string, std::string> > conflicts;
+      //! Pairs of names of the source and sink blocks of latched arcs
+      std::vector<std::pair<std::string, std::string> > latches;
+      //! The flattened block members of each group
+      std::map<std::string, std::vector<std::string> > groups;
+    };
+
+    //! A snapshot to restore when the current transaction is committed
+    boost::shared_ptr<ModelSnapshot> pending_snapshot_;
+
+    //! The parts of the scheme which a scheme file can modify
+    struct SchemeCheckpoint
+    {
+      //! The names of the blocks in the scheme
+      std::set<std::string> blocks;
+      //! The block groups
+      conman::GroupMap groups;
+      //! The input and output latch flags of each block
+      std::map<std::string, std::pair<bool, bool> > block_latches;
+      //! The latch flag of each arc
+      std::map<std::pair<RTT::TaskContext*, RTT::TaskContext*>, bool> arc_latches;
+      //! The latches which were pending
+      std::map<std::pair<RTT::TaskContext*, RTT::TaskContext*>, bool> pending_latches;
+      //! The latch flags of the arcs which were removed
+      std::map<std::pair<RTT::TaskContext*, RTT::TaskContext*>, bool> removed_latches;
+      //! The desired minimum periods of blocks whose periods were set
+      std::map<std::string, RTT::Seconds> periods;
+    };
+
+    //! The settings of a block's activity before it was added to the scheme
+    struct ActivitySettings
+    {
+      int scheduler;
+      int priority;
+      RTT::Seconds period;
+      unsigned int cpu_affinity;
+    };
+
+    //! The activity settings of each block, so they can be restored on rollback
+    std::map<RTT::TaskContext*, ActivitySettings> block_activities_;
+
+    //! Record the parts of the scheme which a scheme file can modify
+    void checkpoint(SchemeCheckpoint &checkpoint) const;
+    //! Undo modifications made since a checkpoint (must be called in a transaction)
+    void rollback(const SchemeCheckpoint &checkpoint);
+
+    //! Compute a hash of the modeled blocks, connections, latches, and groups
+    boost::uint64_t computeModelHash() const;
+    //! Model the connections and restore a snapshot if it still matches
+    bool restoreSnapshot(const ModelSnapshot &snapshot);
+
+    //! Latches requested during a transaction on connections not yet in the DFG
+    std::map<std::pair<RTT::TaskContext*, RTT::TaskContext*>, bool> pending_latches_;
+
+    /** \brief The latch flags of DFG edges which were removed
+     *
+     * An edge is removed when all of the connections between its blocks are
+     * removed, so its latch flag is kept here (keyed by the source and sink
+     * blocks) and restored if they're connected again.
+     */
+    std::map<std::pair<RTT::TaskContext*, RTT::TaskContext*>, bool> removed_latches_;
+
+    //! Remove a DFG edge and remember its latch flag
+    void removeFlowEdge(const conman::graph::DataFlowEdgeDescriptor &edge);
+
+    /** \brief Defer regenerating the model if an edit transaction is open
+     *
+     * Returns true (and marks the model as needing an update) if the caller
+     * should skip regenerating the model.
+     */
+    bool deferModelUpdate();
+
+    //! States of the arc between two blocks in the latch analysis
+    enum ArcState { ARC_NONE = 0, ARC_UNLATCHED, ARC_LATCHED };
+
+    /** \brief Cached results of the latch analysis
+     *
+     * Blocks are identified by their vertex index, and the analysis is only
+     * recomputed when the model version changes.
+     */
+    struct LatchAnalysis
+    {
+      //! The model version for which this analysis was computed
+      unsigned long model_version;
+      //! The blocks, by vertex index
+      std::vector<conman::graph::DataFlowVertex::Ptr> vertices;
+      //! Dense matrix of \ref ArcState from each source (row) to each sink
+      std::vector<char> arcs;
+      //! All simple cycles in the DFG
+      std::vector<std::vector<unsigned int> > cycles;
+      //! The number of latches in each cycle (including the closing arc)
+      std::vector<int> latch_counts;
+      //! The minimum and maximum number of latches in any cycle
+      int min_latch_count, max_latch_count;
+    };
+
+    //! The cached latch analysis
+    mutable LatchAnalysis latch_analysis_;
+
+    //! Get the latch analysis for the current model version
+    const LatchAnalysis& getLatchAnalysis() const;
+
+    //! Add blocks and latches to a fork of the scheme for a what-if query
+    bool modifyFork(
+        conman::SchemeFork &fork,
+        const std::vector<std::string> &add_blocks,
+        const std::vector<std::string> &latch_sources,
+        const std::vector<std::string> &latch_sinks) const;
+
+    //! The model shared with forks of the scheme
+    mutable conman::SchemeFork::Model::ConstPtr fork_model_;
+    //! The model version of the model shared with forks
+    mutable unsigned long fork_model_version_;
+    //! Guards the model shared with forks
+    mutable RTT::os::Mutex fork_mutex_;
+
     //! Get a block vertex by name
     const conman::graph::DataFlowVertex::Ptr getBlockVertex(const std::string &name) const;
-    //! Get a conflict vertex by task
-    const conman::graph::ConflictVertexDescriptor getConflictVertex(RTT::TaskContext* task) const;
+    //! Get the exclusivity of an input port, using the cache if possible
+    conman::Exclusivity::Mode getInputExclusivity(
+        const conman::graph::DataFlowVertex::Ptr &sink_vertex,
+        const RTT::base::PortInterface *sink_port);
+    /** \brief Check if the shapes declared for two connected ports (through
+     * their blocks' hooks) are compatible
+     */
+    bool checkPortContract(
+        const conman::graph::DataFlowVertex::Ptr &source_vertex,
+        const RTT::base::PortInterface *source_port,
+        const conman::graph::DataFlowVertex::Ptr &sink_vertex,
+        const RTT::base::PortInterface *sink_port,
+        const bool quiet = false);
+    //! Check if two blocks conflict according to the conflict matrix
+    bool conflicting(
+        const conman::graph::DataFlowVertex::Ptr &first,
+        const conman::graph::DataFlowVertex::Ptr &second) const;
+    //! Cache the exclusivity of all of the input ports of a block
+    void cacheInputExclusivity(const conman::graph::DataFlowVertex::Ptr &vertex);
+    /** \brief Get the set of blocks (by vertex index) in a list of blocks or
+     * groups
+     *
+     * Returns false if any of the names are not blocks or groups in the scheme.
+     */
+    bool getBlockSet(
+        const std::vector<std::string> &block_names,
+        conman::graph::ConflictSet &block_set) const;
+    //! Get the set of blocks (by vertex index) in a list of block or group IDs
+    bool getBlockSet(
+        const std::vector<conman::BlockID> &block_ids,
+        conman::graph::ConflictSet &block_set) const;
+    //! Get the set of blocks which conflict with any block in a set of blocks
+    conman::graph::ConflictSet getConflictSet(
+        const conman::graph::ConflictSet &block_set) const;
+    //! Get the set of blocks which conflict with any block in a set of blocks
+    void getConflictSet(
+        const conman::graph::ConflictSet &block_set,
+        conman::graph::ConflictSet &conflict_set) const;
+    //! Preallocated block sets used by the ID-based operations
+    mutable conman::graph::ConflictSet id_block_set_, id_conflict_set_;
+
+    //! Enable a block in the scheme
+    bool enableVertex(
+        const conman::graph::DataFlowVertex::Ptr &block_vertex,
+        const bool force);
+    //! Disable a block in the scheme
+    bool disableVertex(const conman::graph::DataFlowVertex::Ptr &block_vertex);
+    //! Update the running state of a block in the set of running blocks
+    void updateRunningBlock(RTT::TaskContext *block);
+    //! Update the running state of a set of blocks (by vertex index)
+    void syncRunningBlocks(const conman::graph::ConflictSet &block_set) const;
 
     /** \brief Connect a block in the graph structures
      *
@@ -473,9 +1172,26 @@ namespace conman
      */
     bool removeBlockFromGraph(conman::graph::DataFlowVertex::Ptr vertex);
 
+    /** \brief Get the flattened membership of a group
+     *
+     * Returns NULL if the group doesn't exist.
+     */
+    const GroupExpansion* expandGroup(const std::string &group_name) const;
+    //! Get the flattened membership of a group by ID
+    const GroupExpansion* expandGroup(const conman::BlockID id) const;
+    //! Invalidate all of the flattened group memberships
+    void invalidateGroupExpansions();
+
+    //! Issue a new ID for a block or group
+    conman::BlockID issueBlockID(
+        const std::string &name,
+        const conman::graph::DataFlowVertex::Ptr &vertex);
+    //! Retire the ID of a removed block or group
+    void retireBlockID(const std::string &name);
+
     /** \brief Recursively get a flattened list of all members in a group
      *
-     * This is the internal function used by the public \ref getGroupMembers.
+     * This is the internal function used by \ref expandGroup.
      */
     bool getGroupMembers(
         const std::string &group_name,
@@ -487,12 +1203,43 @@ namespace conman
         const conman::graph::DataFlowGraph &data_flow_graph,
         std::vector<conman::graph::DataFlowPath> &cycles) const;
 
-    //! Compute the schedule without modifying the scheme
+    /** \brief Compute the schedule without modifying the scheme
+     *
+     * Among the valid topological orderings of the ESG, this chooses one which
+     * schedules each block soon after the blocks which produce its inputs.
+     */
     bool computeSchedule(
-        const conman::graph::DataFlowGraph &data_flow_graph,
+        const conman::graph::ExecutionGraph &exec_graph,
         conman::graph::ExecutionOrdering &ordering, 
         const bool quiet) const;
 
+    /** \brief Check that the current schedule delays a latch by a cycle
+     *
+     * This returns false only if the connection from \p source to \p sink
+     * is latched and the current schedule runs the sink after the source.
+     * It also logs why.
+     */
+    bool checkLatchDelayed(
+        RTT::TaskContext *source,
+        RTT::TaskContext *sink) const;
+
+    /** \brief Model the connections from all blocks in the DFG
+     *
+     * Connections between ports whose declared shapes differ are left
+     * connected, but they aren't modeled. This returns false if there are
+     * any.
+     */
+    bool modelConnections(bool &topology_modified);
+
+    //! Model the connections from a single output port in the DFG
+    bool modelConnections(
+        conman::graph::DataFlowVertex::Ptr source_vertex,
+        RTT::base::PortInterface *port,
+        bool &topology_modified);
+
+    //! Recompute the execution ordering if the model changed
+    bool updateSchedule(const bool topology_modified);
+
     //! Print out the current execution ordering
     void printExecutionOrdering() const;
 
@@ -0,0 +1,143 @@
+/** Copyright (c) 2013, Jonathan Bohren, all rights reserved.
+ * This software is released under the BSD 3-clause license, for the details of
+ * this license, please see LICENSE.txt at the root of this repository.
+ */
+
+#ifndef __CONMAN_SCHEME_FORK_H
+#define __CONMAN_SCHEME_FORK_H
+
+#include <conman/conman.h>
+
+namespace conman
+{
+  /** \brief Copy-on-write fork of a scheme model for what-if queries
+   *
+   * A fork holds the topology, latches, conflicts, groups, and enabled blocks
+   * of a conman::Scheme at the time it was forked. It supports the scheme's
+   * edit and analysis operations, but these only modify the fork, so they can
+   * be evaluated without stopping or otherwise touching the scheme.
+   *
+   * Forks share their model until one of them is modified, so creating,
+   * copying, and discarding forks is cheap. See conman::Scheme::fork().
+   */
+  class SchemeFork
+  {
+  public:
+    //! Compact model of the blocks in a scheme and their relationships
+    struct Model
+    {
+      typedef boost::shared_ptr<Model> Ptr;
+      typedef boost::shared_ptr<const Model> ConstPtr;
+
+      //! The set of connections from one block to another
+      struct Arc
+      {
+        //! Index of the source block
+        unsigned int source;
+        //! Index of the sink block
+        unsigned int sink;
+        //! If true, execution scheduling does not consider this arc
+        bool latched;
+        //! The port connections which this arc represents
+        std::vector<conman::graph::DataFlowEdge::Connection> connections;
+      };
+
+      //! The blocks, indexed by their position
+      std::vector<conman::graph::DataFlowVertex::Ptr> vertices;
+      //! Map from block names to indices
+      std::map<std::string, unsigned int> indices;
+      //! The arcs of the DFG
+      std::vector<Arc> arcs;
+      //! The indices of the blocks which conflict with each block
+      std::vector<std::set<unsigned int> > conflicts;
+      //! A map of block group names to block names
+      conman::GroupMap groups;
+    };
+
+    /** \brief Construct a fork from a shared model
+     *
+     * \param model The model to share until the fork is modified
+     * \param enabled The enabled state of each block in the model
+     */
+    SchemeFork(
+        Model::ConstPtr model,
+        const std::vector<bool> &enabled);
+
+    ///////////////////////////////////////////////////////////////////////////
+    /** \name Fork Modification
+     *
+     * These mirror the corresponding conman::Scheme operations.
+     */
+    //\{
+
+    //! Check if a block is in the fork
+    bool hasBlock(const std::string &block_name) const;
+    //! Get the names of all the blocks in the fork
+    std::vector<std::string> getBlocks() const;
+    //! Get the blocks in a group (or a single block)
+    bool getGroupMembers(
+        const std::string &group_name,
+        std::vector<std::string> &members) const;
+
+    /** \brief Add a block to the fork
+     *
+     * The block's port connections to the other blocks in the fork are modeled,
+     * but the block is not modified.
+     */
+    bool addBlock(RTT::TaskContext *new_block);
+
+    //! Latch or unlatch the connections between two blocks or groups
+    bool latchConnections(
+        const std::string &source_name,
+        const std::string &sink_name,
+        const bool latch);
+
+    /** \brief Enable a block or group
+     *
+     * If force is true, conflicting blocks are disabled, otherwise this fails
+     * if any enabled blocks conflict.
+     */
+    bool enableBlock(const std::string &block_name, const bool force);
+    //! Disable a block or group
+    bool disableBlock(const std::string &block_name);
+    //\}
+
+    ///////////////////////////////////////////////////////////////////////////
+    //! \name Fork Analysis
+    //\{
+
+    //! Returns true if the fork's ESG has no cycles
+    bool executable() const;
+    //! Get the execution ordering, returns false if it's not executable
+    bool getExecutionOrder(std::vector<std::string> &order) const;
+    //! Get the names of the blocks which conflict with a given block
+    bool getConflicts(
+        const std::string &block_name,
+        std::vector<std::string> &conflicts) const;
+    //! Check if a block would be enabled
+    bool isEnabled(const std::string &block_name) const;
+    //! Get the names of the blocks which would be enabled
+    std::vector<std::string> getEnabledBlocks() const;
+    //\}
+
+  private:
+    //! The model, which may be shared with the scheme and other forks
+    Model::ConstPtr model_;
+    //! The enabled state of each block
+    std::vector<bool> enabled_;
+
+    //! Get a modifiable model, copying it if it is shared
+    Model& editModel();
+
+    //! Expand a group recursively
+    bool getGroupMembers(
+        const std::string &name,
+        std::set<std::string> &members,
+        std::set<std::string> &visited) const;
+
+    //! Compute the execution ordering of block indices
+    bool computeOrdering(std::vector<unsigned int> &ordering) const;
+  };
+}
+
+#endif // ifndef __CONMAN_SCHEME_FORK_H
@@ -7,4 +7,9 @@
 
 const conman::Exclusivity::Mode conman::Exclusivity::UNRESTRICTED;
 const conman::Exclusivity::Mode conman::Exclusivity::EXCLUSIVE;
+const conman::LatchCost::Mode conman::LatchCost::UNIFORM;
+const conman::LatchCost::Mode conman::LatchCost::CONNECTIONS;
+const conman::ConfigureStatus::Mode conman::ConfigureStatus::FAILED;
+const conman::ConfigureStatus::Mode conman::ConfigureStatus::CONFIGURED;
+const conman::ConfigureStatus::Mode conman::ConfigureStatus::SKIPPED;
 
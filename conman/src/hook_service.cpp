@@ -5,6 +5,8 @@
 
 #include <rtt/plugin/ServicePlugin.hpp>
 
+#include <rtt/os/MutexLock.hpp>
+
 #include <conman/hook_service.h>
 
 #include <boost/algorithm/string.hpp>
@@ -70,6 +72,19 @@ HookService::HookService(RTT::TaskContext* owner) :
   this->addOperation("setInputExclusivity",&HookService::setInputExclusivity,this,RTT::ClientThread);
   this->addOperation("getInputExclusivity",&HookService::getInputExclusivity,this,RTT::ClientThread);
   this->addOperation("getRegisteredInputPorts",&HookService::getRegisteredInputPorts,this,RTT::ClientThread);
+  this->addOperation("setPortDimension",&HookService::setPortDimension,this,RTT::ClientThread);
+  this->addOperation("getPortDimension",&HookService::getPortDimension,this,RTT::ClientThread);
+  this->addOperation("setPortJointNames",&HookService::setPortJointNames,this,RTT::ClientThread);
+  this->addOperation("getPortJointNames",&HookService::getPortJointNames,this,RTT::ClientThread);
+
+  // Payload Pool Introspection Interface
+  // Note: Registration is refused while the owner is running, and the pool
+  // map is guarded by a mutex, so these can all be client-thread-based
+  this->addOperation("registerPayloadPool",&HookService::registerPayloadPool,this,RTT::ClientThread);
+  this->addOperation("getPayloadPools",&HookService::getPayloadPools,this,RTT::ClientThread);
+  this->addOperation("getPayloadPoolCapacity",&HookService::getPayloadPoolCapacity,this,RTT::ClientThread);
+  this->addOperation("getPayloadPoolAvailable",&HookService::getPayloadPoolAvailable,this,RTT::ClientThread);
+  this->addOperation("getPayloadPoolExhausted",&HookService::getPayloadPoolExhausted,this,RTT::ClientThread);
 
 
   // Conman Introspection interface
@@ -124,6 +139,7 @@ bool HookService::setInputExclusivity(
   // Make sure that the port is an input port
   if(dynamic_cast<RTT::base::InputPortInterface*>(port)) {
     // Add to the input port map
+    RTT::os::MutexLock lock(config_mutex_);
     input_ports_[port_name].exclusivity = Exclusivity::Mode(mode); 
   } else if(port) {
     // Complain
@@ -143,6 +159,8 @@ bool HookService::setInputExclusivity(
 unsigned int HookService::getInputExclusivity(
     const std::string &port_name)
 {
+  RTT::os::MutexLock lock(config_mutex_);
+
   // Get the port
   std::map<std::string,InputProperties>::const_iterator props = 
     input_ports_.find(port_name);
@@ -157,6 +175,8 @@ unsigned int HookService::getInputExclusivity(
 }
 
 std::vector<std::string> HookService::getRegisteredInputPorts() const {
+  RTT::os::MutexLock lock(config_mutex_);
+
   std::vector<std::string> port_names;
   port_names.reserve(input_ports_.size());
 
@@ -170,6 +190,141 @@ std::vector<std::string> HookService::getRegisteredInputPorts() const {
   return port_names;
 }
 
+bool HookService::setPortDimension(
+    const std::string &port_name,
+    const unsigned int dimension)
+{
+  if(this->getOwnerPort(port_name) == NULL) {
+    RTT::log(RTT::Error) << "Tried to set the dimension of an unknown port." << RTT::endlog();
+    return false;
+  }
+
+  RTT::os::MutexLock lock(config_mutex_);
+  PortShape &shape = port_shapes_[port_name];
+
+  // The dimension has to agree with the joint names
+  if(!shape.joint_names.empty() && shape.joint_names.size() != dimension) {
+    RTT::log(RTT::Error) << "Tried to set the dimension of port \"" << port_name
+      << "\" to " << dimension << " but it has " << shape.joint_names.size()
+      << " joint names." << RTT::endlog();
+    return false;
+  }
+
+  shape.dimension = dimension;
+
+  return true;
+}
+
+unsigned int HookService::getPortDimension(
+    const std::string &port_name)
+{
+  RTT::os::MutexLock lock(config_mutex_);
+
+  std::map<std::string, PortShape>::const_iterator shape_it = 
+    port_shapes_.find(port_name);
+
+  return (shape_it != port_shapes_.end()) ? shape_it->second.dimension : 0;
+}
+
+bool HookService::setPortJointNames(
+    const std::string &port_name,
+    const std::vector<std::string> &joint_names)
+{
+  if(this->getOwnerPort(port_name) == NULL) {
+    RTT::log(RTT::Error) << "Tried to set the joint names of an unknown port." << RTT::endlog();
+    return false;
+  }
+
+  RTT::os::MutexLock lock(config_mutex_);
+  PortShape &shape = port_shapes_[port_name];
+  shape.joint_names = joint_names;
+  shape.dimension = joint_names.size();
+
+  return true;
+}
+
+std::vector<std::string> HookService::getPortJointNames(
+    const std::string &port_name)
+{
+  RTT::os::MutexLock lock(config_mutex_);
+
+  std::map<std::string, PortShape>::const_iterator shape_it = 
+    port_shapes_.find(port_name);
+
+  return (shape_it != port_shapes_.end()) ? shape_it->second.joint_names : std::vector<std::string>();
+}
+
+bool HookService::registerPayloadPool(
+    const std::string &pool_name,
+    conman::PayloadPoolBase::Ptr pool)
+{
+  if(!pool) {
+    RTT::log(RTT::Error) << "Tried to register a NULL payload pool named \"" << pool_name << "\"." << RTT::endlog();
+    return false;
+  }
+
+  if(this->getOwner()->isRunning()) {
+    RTT::log(RTT::Error) << "Tried to register the payload pool \"" << pool_name << "\" while \"" << this->getOwner()->getName() << "\" is running. Payload pools should be registered when the block is configured." << RTT::endlog();
+    return false;
+  }
+
+  RTT::os::MutexLock lock(pools_mutex_);
+  payload_pools_[pool_name] = pool;
+
+  return true;
+}
+
+std::vector<std::string> HookService::getPayloadPools() const
+{
+  RTT::os::MutexLock lock(pools_mutex_);
+
+  std::vector<std::string> pool_names;
+  pool_names.reserve(payload_pools_.size());
+
+  for(std::map<std::string, conman::PayloadPoolBase::Ptr>::const_iterator it = payload_pools_.begin();
+      it != payload_pools_.end();
+      ++it)
+  {
+    pool_names.push_back(it->first);
+  }
+
+  return pool_names;
+}
+
+conman::PayloadPoolBase* HookService::getPayloadPool(const std::string &pool_name) const
+{
+  std::map<std::string, conman::PayloadPoolBase::Ptr>::const_iterator it = 
+    payload_pools_.find(pool_name);
+
+  if(it == payload_pools_.end()) {
+    RTT::log(RTT::Error) << "No payload pool named \"" << pool_name << "\" has been registered." << RTT::endlog();
+    return NULL;
+  }
+
+  return it->second.get();
+}
+
+unsigned int HookService::getPayloadPoolCapacity(const std::string &pool_name) const
+{
+  RTT::os::MutexLock lock(pools_mutex_);
+  conman::PayloadPoolBase *pool = this->getPayloadPool(pool_name);
+  return pool ? pool->capacity() : 0;
+}
+
+unsigned int HookService::getPayloadPoolAvailable(const std::string &pool_name) const
+{
+  RTT::os::MutexLock lock(pools_mutex_);
+  conman::PayloadPoolBase *pool = this->getPayloadPool(pool_name);
+  return pool ? pool->available() : 0;
+}
+
+unsigned long HookService::getPayloadPoolExhausted(const std::string &pool_name) const
+{
+  RTT::os::MutexLock lock(pools_mutex_);
+  conman::PayloadPoolBase *pool = this->getPayloadPool(pool_name);
+  return pool ? pool->exhausted() : 0;
+}
+
 RTT::Seconds HookService::getTime() 
 {
   return last_exec_time_;
@@ -1,7 +1,9 @@
 #include <boost/bind.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <rtt/Activity.hpp>
 #include <rtt/extras/SlaveActivity.hpp>
+#include <rtt/os/MutexLock.hpp>
 
 #include <conman/scheme.h>
 #include <conman/hook.h>
@@ -24,12 +26,49 @@
 #include <boost/graph/tiernan_all_cycles.hpp>
 #endif
 
+#include <boost/graph/strong_components.hpp>
+#include <boost/property_map/property_map.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
 
 using namespace conman;
 
+//! Reserve storage for a number of bits without changing the size of a set
+static void ReserveBits(
+    conman::graph::ConflictSet &bits,
+    const conman::graph::ConflictSet::size_type n_bits)
+{
+  const conman::graph::ConflictSet::size_type size = bits.size();
+  if(n_bits > size) {
+    bits.resize(n_bits);
+    bits.resize(size);
+  }
+}
+
 Scheme::Scheme(std::string name) 
- : RTT::TaskContext(name)
+ : RTT::TaskContext(name),
+   max_blocks_(0),
+   max_groups_(0),
+   exec_graph_(flow_graph_, conman::graph::UnlatchedEdgePredicate(&flow_graph_)),
+   exec_ordering_version_(0),
+   contracts_satisfied_(true),
+   model_version_(1),
+   edit_depth_(0),
+   model_update_pending_(false),
+   demand_driven_(false),
+   demand_version_(0),
+   local_connections_(false)
 {
+  // The latch analysis hasn't been computed for any model
+  latch_analysis_.model_version = 0;
+  fork_model_version_ = 0;
+
   // Modifying blocks in the scheme
   this->addOperation("hasBlock", &Scheme::hasBlock, this, RTT::OwnThread)
     .doc("Check if a conman block is in this scheme by name.");
@@ -39,6 +78,25 @@ Scheme::Scheme(std::string name)
     .doc("Add a conman block into this scheme.");
   this->addOperation("removeBlock", (bool (Scheme::*)(const std::string&))&Scheme::removeBlock, this, RTT::OwnThread)
     .doc("Remove a conman block from this scheme.");
+  this->addOperation("addBlocks", &Scheme::addBlocks, this, RTT::OwnThread)
+    .doc("Add several conman blocks into this scheme, regenerating the model once.");
+
+  // Edit transactions
+  this->addOperation("beginEdit", &Scheme::beginEdit, this, RTT::OwnThread)
+    .doc("Begin a transaction of scheme modifications. The model is only regenerated when the transaction is committed.");
+  this->addOperation("commit", &Scheme::commit, this, RTT::OwnThread)
+    .doc("Commit a transaction of scheme modifications and regenerate the model.");
+  this->addOperation("isEditing", &Scheme::isEditing, this, RTT::OwnThread)
+    .doc("Check if a transaction of scheme modifications is open.");
+
+  // Scheme description files
+  this->addOperation("loadScheme", &Scheme::loadScheme, this, RTT::OwnThread)
+    .doc("Load a scheme description file, restoring the model from a snapshot if it matches.")
+    .arg("scheme_file","The scheme description file.")
+    .arg("snapshot_file","The binary model snapshot file, or an empty string.");
+  this->addOperation("saveSnapshot", &Scheme::saveSnapshot, this, RTT::OwnThread)
+    .doc("Save a binary snapshot of the computed model.")
+    .arg("snapshot_file","The binary model snapshot file.");
 
   // Group management
   this->addOperation("hasGroup", &Scheme::hasGroup, this, RTT::OwnThread)
@@ -60,15 +118,41 @@ Scheme::Scheme(std::string name)
 
   // Latch management
   this->addOperation("latchConnections", (bool (Scheme::*)(const std::string&, const std::string&, const bool))&Scheme::latchConnections, this, RTT::OwnThread)
-    .doc("Latch all the connections between two components.");
+    .doc("Latch all the connections between two components. Returns false if the latch can't delay the connections by a cycle.");
   this->addOperation("latchInputs", (bool (Scheme::*)(const std::string&, const bool))&Scheme::latchInputs, this, RTT::OwnThread)
     .doc("Latch all the inputs to a given component.");
   this->addOperation("latchOutputs", (bool (Scheme::*)(const std::string&, const bool))&Scheme::latchOutputs, this, RTT::OwnThread)
     .doc("Latch all the outputs to a given component.");
+  this->addOperation("autoLatch", &Scheme::autoLatch, this, RTT::OwnThread)
+    .doc("Compute a set of latches which makes the scheme executable.")
+    .arg("cost","The latch cost model (0: number of latches, 1: number of delayed connections).")
+    .arg("apply","If true, latch the proposed connections.");
 
   // Execution introspection
   this->addOperation("executable", &Scheme::executable, this, RTT::OwnThread)
     .doc("Returns true if the graph can be executed with the current latches.");
+  this->addOperation("latchesDelayed", &Scheme::latchesDelayed, this, RTT::OwnThread)
+    .doc("Returns true if the sink of every latched connection reads the sample written in the previous cycle.");
+  this->addOperation("getModelVersion", &Scheme::getModelVersion, this, RTT::OwnThread)
+    .doc("Get the version of the scheme model, which changes whenever the topology or latching changes.");
+  this->addOperation("updateModel", &Scheme::updateModel, this, RTT::OwnThread)
+    .doc("Update the scheme model with the port connections which changed since they were last modeled.");
+
+  // What-if analysis
+  this->addOperation("whatIfExecutable", &Scheme::whatIfExecutable, this, RTT::OwnThread)
+    .doc("Returns true if the scheme would be executable with more blocks or latches. The scheme is not modified.")
+    .arg("add_blocks","The names of peers of the scheme to add.")
+    .arg("latch_sources","The sources of the connections to latch.")
+    .arg("latch_sinks","The sinks of the connections to latch (one for each source).");
+  this->addOperation("whatIfExecutionOrder", &Scheme::whatIfExecutionOrder, this, RTT::OwnThread)
+    .doc("Get the execution ordering with more blocks or latches (empty if it would not be executable). The scheme is not modified.")
+    .arg("add_blocks","The names of peers of the scheme to add.")
+    .arg("latch_sources","The sources of the connections to latch.")
+    .arg("latch_sinks","The sinks of the connections to latch (one for each source).");
+  this->addOperation("whatIfEnableBlocks", &Scheme::whatIfEnableBlocks, this, RTT::OwnThread)
+    .doc("Get the blocks which would be enabled after enabling blocks or groups (empty if they could not be enabled). The scheme is not modified.")
+    .arg("enable_names","The blocks or groups to enable.")
+    .arg("force","If true, conflicting blocks would be disabled.");
 
   // Block runtime management
   this->addOperation("enableBlock", (bool (Scheme::*)(const std::string&, const bool))&Scheme::enableBlock, this, RTT::OwnThread)
@@ -78,12 +162,83 @@ Scheme::Scheme(std::string name)
   this->addOperation("disableBlock", (bool (Scheme::*)(const std::string&))&Scheme::disableBlock, this, RTT::OwnThread)
     .doc("Disable a block in this scheme.")
     .arg("name","The block to disable.");
-  this->addOperation("switchBlocks", &Scheme::switchBlocks, this, RTT::OwnThread)
+  this->addOperation("switchBlocks", (bool (Scheme::*)(const std::vector<std::string>&, const std::vector<std::string>&, const bool, const bool))&Scheme::switchBlocks, this, RTT::OwnThread)
     .doc("Simultaneousy enable and disable a list of blocks, any block not in either list will remain in its current state.");
 
   this->addOperation("setEnabledBlocks", &Scheme::setEnabledBlocks, this, RTT::OwnThread)
     .doc("Set the list of running blocks, any block not on the list will be disabled.");
 
+  this->addOperation("setDemandDriven", &Scheme::setDemandDriven, this, RTT::OwnThread)
+    .doc("Only update enabled blocks which contribute to an enabled sink.")
+    .arg("demand_driven","If true, blocks which don't contribute to a sink are skipped.");
+  this->addOperation("isDemandDriven", &Scheme::isDemandDriven, this, RTT::ClientThread)
+    .doc("Check if demand-driven execution is enabled.");
+  this->addOperation("setRequired", &Scheme::setRequired, this, RTT::OwnThread)
+    .doc("Mark a block (or the blocks in a group) as a required sink for demand-driven execution.")
+    .arg("block_name","The block or group name.")
+    .arg("required","If true, the blocks are always updated while they are enabled.");
+  this->addOperation("isRequired", &Scheme::isRequired, this, RTT::OwnThread)
+    .doc("Check if a block is marked as a required sink.")
+    .arg("block_name","The block name.");
+  this->addOperation("isDemanded", &Scheme::isDemanded, this, RTT::OwnThread)
+    .doc("Check if an enabled block contributes to an enabled sink.")
+    .arg("block_name","The block name.");
+
+  this->addOperation("setLocalConnections", &Scheme::setLocalConnections, this, RTT::OwnThread)
+    .doc("Reconnect the connections between blocks in this scheme without locking.")
+    .arg("local","If true, the connections are unsynchronized, otherwise their original lock policies are restored.");
+  this->addOperation("hasLocalConnections", &Scheme::hasLocalConnections, this, RTT::ClientThread)
+    .doc("Check if the connections between blocks in this scheme are unsynchronized.");
+
+  this->addOperation("optimizeConnections", (int (Scheme::*)(const bool))&Scheme::optimizeConnections, this, RTT::OwnThread)
+    .doc("Recommend the cheapest correct policy for each connection between blocks in this scheme, and report buffers which can overflow. Returns the number of connections which would change, or -1 on failure.")
+    .arg("apply","If true, rewire the connections with the recommended policies (the scheme must be stopped).");
+
+  this->addOperation("setCapacity", &Scheme::setCapacity, this, RTT::OwnThread)
+    .doc("Reserve storage for a maximum number of blocks and groups, and prevent adding more.")
+    .arg("max_blocks","The maximum number of blocks.")
+    .arg("max_groups","The maximum number of groups.");
+
+  // Block configuration
+  this->addOperation("configureBlocks", (bool (Scheme::*)(const std::string&, const unsigned int))&Scheme::configureBlocks, this, RTT::OwnThread)
+    .doc("Configure all of the blocks, or the blocks in a group, concurrently.")
+    .arg("group","The group to configure, or an empty string to configure all blocks.")
+    .arg("max_threads","The maximum number of threads to use, or 0 to use one per core.");
+  this->addOperation("configureBlocksWithReport", (bool (Scheme::*)(const std::vector<std::string>&, const unsigned int, std::vector<std::string>&, std::vector<int>&, std::vector<double>&))&Scheme::configureBlocks, this, RTT::OwnThread)
+    .doc("Configure blocks and groups concurrently, and get the result for each block.")
+    .arg("block_names","The blocks and groups to configure.")
+    .arg("max_threads","The maximum number of threads to use, or 0 to use one per core.")
+    .arg("configured_blocks","The name of each configured block.")
+    .arg("status","The configure_status of each block.")
+    .arg("durations","The time it took to configure each block.");
+
+  // Block runtime management by ID
+  this->addOperation("getBlockID", &Scheme::getBlockID, this, RTT::OwnThread)
+    .doc("Get the integer ID of a block or group by name.")
+    .arg("name","The block or group.");
+  this->addOperation("getBlockName", &Scheme::getBlockName, this, RTT::OwnThread)
+    .doc("Get the name of a block or group by ID.")
+    .arg("id","The block or group ID.");
+  this->addOperation("enableableByID", (bool (Scheme::*)(const std::vector<conman::BlockID>&) const)&Scheme::enableable, this, RTT::OwnThread)
+    .doc("Check if a list of blocks or groups can be enabled without disabling any running blocks.")
+    .arg("ids","The block or group IDs.");
+  this->addOperation("enableBlocksByID", (bool (Scheme::*)(const std::vector<conman::BlockID>&, const bool, const bool))&Scheme::enableBlocks, this, RTT::OwnThread)
+    .doc("Enable a list of blocks or groups by ID.");
+  this->addOperation("disableBlocksByID", (bool (Scheme::*)(const std::vector<conman::BlockID>&, const bool))&Scheme::disableBlocks, this, RTT::OwnThread)
+    .doc("Disable a list of blocks or groups by ID.");
+  this->addOperation("switchBlocksByID", (bool (Scheme::*)(const std::vector<conman::BlockID>&, const std::vector<conman::BlockID>&, const bool, const bool))&Scheme::switchBlocks, this, RTT::OwnThread)
+    .doc("Simultaneousy enable and disable a list of blocks or groups by ID.");
+  this->addOperation("isEnabled", &Scheme::isEnabled, this, RTT::OwnThread)
+    .doc("Check if a block is enabled by ID.")
+    .arg("id","The block ID.");
+
+  // Constants
+  this->provides("latch_cost")->addConstant("UNIFORM",LatchCost::UNIFORM);
+  this->provides("latch_cost")->addConstant("CONNECTIONS",LatchCost::CONNECTIONS);
+  this->provides("configure_status")->addConstant("FAILED",ConfigureStatus::FAILED);
+  this->provides("configure_status")->addConstant("CONFIGURED",ConfigureStatus::CONFIGURED);
+  this->provides("configure_status")->addConstant("SKIPPED",ConfigureStatus::SKIPPED);
+
   this->addProperty("last_exec_period",last_exec_period_)
     .doc("The last period between two consecutive executions.");
   this->addProperty("min_exec_period",min_exec_period_)
@@ -121,7 +276,20 @@ std::vector<std::string> Scheme::getBlocks() const
 
 void Scheme::getBlocks(std::vector<std::string> &blocks) const
 {
-  blocks = this->getBlocks();
+  using namespace conman::graph;
+
+  // Assign the names in place so that the strings' storage is reused
+  blocks.resize(blocks_.size());
+
+  std::vector<std::string>::iterator str_it = blocks.begin();
+  std::map<std::string,DataFlowVertex::Ptr>::const_iterator block_it =
+    blocks_.begin();
+
+  for(; str_it != blocks.end() && block_it != blocks_.end();
+      ++str_it, ++block_it)
+  {
+    str_it->assign(block_it->first);
+  }
 }
 
 bool Scheme::addBlock(const std::string &block_name)
@@ -174,6 +342,14 @@ bool Scheme::addBlock(RTT::TaskContext *new_block)
     return false;
   }
 
+  // Make sure the scheme has room for the block
+  if(max_blocks_ > 0 && blocks_.size() >= max_blocks_) {
+    RTT::log(RTT::Error) << "Could not add block \"" << new_block->getName()
+      << "\" because the scheme is at its capacity of " << max_blocks_
+      << " blocks." << RTT::endlog();
+    return false;
+  }
+
   // Make sure the block has the conman hook service
   if(!conman::Hook::GetHook(new_block)) {
     RTT::log(RTT::Error) << "Requested block to add does not have the conman"
@@ -202,9 +378,24 @@ bool Scheme::addBlock(RTT::TaskContext *new_block)
 
   // Add this block to the set of blocks
   blocks_[block_name] = new_vertex;
+  new_vertex->id = this->issueBlockID(block_name, new_vertex);
   // Add this block to the block index (used for re-indexing)
   block_indices_.push_back(new_vertex);
 
+  // Cache the exclusivity of the block's input ports for computing conflicts
+  this->cacheInputExclusivity(new_vertex);
+
+  // Add this block to the set of running blocks
+  running_blocks_.resize(block_indices_.size());
+  running_blocks_[new_vertex->index] = new_block->isRunning();
+
+  // New blocks are not required sinks
+  required_blocks_.resize(block_indices_.size());
+  demand_stack_.reserve(block_indices_.size());
+
+  // The group expansions need to be resized for the new block
+  this->invalidateGroupExpansions();
+
   // Model the block in the DFG and ESG structures
   if(!addBlockToGraph(new_vertex)) {
     // Cleanup on failure
@@ -220,8 +411,16 @@ bool Scheme::addBlock(RTT::TaskContext *new_block)
     return false;
   }
   
-  // Compute conflicts for this block and represent them in the RCG
-  this->computeConflicts(new_vertex);
+  // Record the block's activity so that it can be restored if the block is
+  // added by a scheme file which is rolled back
+  RTT::base::ActivityInterface *activity = new_block->getActivity();
+  if(activity) {
+    ActivitySettings &settings = block_activities_[new_block];
+    settings.scheduler = activity->getScheduler();
+    settings.priority = activity->getPriority();
+    settings.period = activity->getPeriod();
+    settings.cpu_affinity = activity->getCpuAffinity();
+  }
 
   // Set the block's activity to be a slave to the scheme's
   new_block->setActivity(
@@ -229,1577 +428,4658 @@ bool Scheme::addBlock(RTT::TaskContext *new_block)
           this->getActivity(),
           new_block->engine()));
 
+  // Conflicts are computed for all blocks when the transaction is committed
+  if(this->deferModelUpdate()) {
+    return true;
+  }
+
+  // Compute conflicts for this block and represent them in the RCG
+  this->computeConflicts(new_vertex);
+
   // Print out the ordering
   this->printExecutionOrdering();
 
   return true;
 }
 
-void Scheme::printExecutionOrdering() const
+bool Scheme::addBlocks(const std::vector<std::string> &block_names)
 {
-  using namespace conman::graph;
+  RTT::Logger::In in("Scheme::addBlocks");
 
-  std::vector<std::string> ordered_names;
-  ordered_names.reserve(exec_ordering_.size());
+  if(!this->beginEdit()) {
+    return false;
+  }
 
-  for(ExecutionOrdering::const_iterator it = exec_ordering_.begin();
-      it != exec_ordering_.end();
-      ++it) 
+  bool success = true;
+  for(std::vector<std::string>::const_iterator it = block_names.begin();
+      it != block_names.end();
+      ++it)
   {
-    ordered_names.push_back(flow_graph_[*it]->block->getName());
+    success &= this->addBlock(*it);
   }
 
-  RTT::log(RTT::Info) << "Scheme ordering: [ " <<
-    boost::algorithm::join(ordered_names, ", ") << " ] " << RTT::endlog();
+  return this->commit() && success;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-
-bool Scheme::removeBlock(const std::string &block_name)
+bool Scheme::setCapacity(
+    const unsigned int max_blocks,
+    const unsigned int max_groups)
 {
-  RTT::Logger::In in("Scheme::removeBlock(string)");
+  using namespace conman::graph;
 
-  // Make sure the block exists as a peer of the scheme
-  if(!this->hasPeer(block_name)) {
-    RTT::TaskContext::PeerList peers = this->getPeerList();
+  RTT::Logger::In in("Scheme::setCapacity");
 
-    RTT::log(RTT::Error)
-      << "Requested block to remove named \"" << block_name << "\" was not a"
-      " peer of this Scheme." << std::endl << "  Available blocks include:"
-      << std::endl;
+  if(blocks_.size() > max_blocks || block_groups_.size() > max_groups) {
+    RTT::log(RTT::Error) << "Could not set the scheme capacity to " << max_blocks
+      << " blocks and " << max_groups << " groups because it already has "
+      << blocks_.size() << " blocks and " << block_groups_.size() << " groups."
+      << RTT::endlog();
+    return false;
+  }
 
-    for(RTT::TaskContext::PeerList::iterator it = peers.begin();
-        it != peers.end();
-        ++it) 
-    {
-      RTT::log(RTT::Error) << "    " << *it << std::endl;
-    }
+  max_blocks_ = max_blocks;
+  max_groups_ = max_groups;
+
+  // Reserve the block structures
+  block_indices_.reserve(max_blocks_);
+  ReserveBits(running_blocks_, max_blocks_);
+  ReserveBits(id_block_set_, max_blocks_);
+  ReserveBits(id_conflict_set_, max_blocks_);
+  ReserveBits(required_blocks_, max_blocks_);
+  ReserveBits(demanded_blocks_, max_blocks_);
+  ReserveBits(demand_running_blocks_, max_blocks_);
+  demand_stack_.reserve(max_blocks_);
+
+  conflict_matrix_.reserve(max_blocks_);
+  for(ConflictMatrix::iterator row_it = conflict_matrix_.begin();
+      row_it != conflict_matrix_.end();
+      ++row_it)
+  {
+    ReserveBits(*row_it, max_blocks_);
+  }
 
-    RTT::log(RTT::Error) << RTT::endlog();
+  // Reserve the IDs (these are not reused, so removing and re-adding blocks
+  // consumes more)
+  id_names_.reserve(max_blocks_ + max_groups_);
+  id_vertices_.reserve(max_blocks_ + max_groups_);
+  group_expansions_.reserve(max_blocks_ + max_groups_);
 
-    return false;
+  for(std::vector<GroupExpansion>::iterator it = group_expansions_.begin();
+      it != group_expansions_.end();
+      ++it)
+  {
+    it->members.reserve(max_blocks_);
+    ReserveBits(it->blocks, max_blocks_);
   }
 
-  // Get the newly loaded block
-  RTT::TaskContext *block = this->getPeer(block_name);
-
-  // Add the block to the graphs
-  return this->removeBlock(block);
+  return true;
 }
 
-bool Scheme::removeBlock(
-    RTT::TaskContext *block)
-{
-  using namespace conman::graph;
+///////////////////////////////////////////////////////////////////////////////
 
-  RTT::Logger::In in("Scheme::removeBlock");
+bool Scheme::beginEdit()
+{
+  RTT::Logger::In in("Scheme::beginEdit");
 
-  // Removeing blocks posible only when scheme is stoped
+  // Editing the model is posible only when scheme is stoped
   if(this->getTaskState() != Stopped) {
-    RTT::log(RTT::Error) << "Scheme is in running state. Removing blocks forbidden." << RTT::endlog();
+    RTT::log(RTT::Error) << "Scheme is in running state. Editing model forbidden." << RTT::endlog();
     return false;
   }
 
-  if(block == NULL) {
+  edit_depth_++;
+
+  return true;
+}
+
+bool Scheme::commit()
+{
+  RTT::Logger::In in("Scheme::commit");
+
+  if(edit_depth_ == 0) {
+    RTT::log(RTT::Error) << "Cannot commit because no transaction was begun." << RTT::endlog();
     return false;
   }
 
-  RTT::log(RTT::Debug) << "Removing block " << block->getName() << "." <<
-    RTT::endlog();
-
-  // Succeed if the block isn't already in the scheme
-  if(blocks_.find(block->getName()) == blocks_.end()) {
+  // Only the outermost transaction updates the model
+  if(--edit_depth_ > 0 || !model_update_pending_) {
     return true;
   }
 
-  // Make sure the block has the conman hook
-  if(!Hook::HasHook(block)) {
-    return false;
+  model_update_pending_ = false;
+
+  // Restore the model from a snapshot if one is being loaded and it matches
+  if(pending_snapshot_ && this->restoreSnapshot(*pending_snapshot_)) {
+    pending_latches_.clear();
+    this->printExecutionOrdering();
+    return true;
   }
 
-  // Check if the block is in the scheme
-  if(flow_vertex_map_.find(block) != flow_vertex_map_.end()) {
-    // Get the vertex properties pointer
-    DataFlowVertex::Ptr vertex = flow_graph_[flow_vertex_map_[block]];
-    // Remove the vertex from the graph
-    if(!this->removeBlockFromGraph(vertex)) {
-      // Complain
-      RTT::log(RTT::Fatal) << "Failed to remove block \"" << block->getName()
-        << "\" from scheme." <<
-        RTT::endlog();
-      // Set failure
-      return false;
-    }
+  // Regenerate the model once for all of the modifications
+  const bool success = this->regenerateModel();
+  pending_latches_.clear();
+
+  if(!success) {
+    RTT::log(RTT::Warning) << "The modified scheme has one or more cycles." << RTT::endlog();
   }
 
-  // Remove the block from the block map
-  blocks_.erase(block->getName());
+  // Compute conflicts for all blocks and represent them in the RCG
+  this->computeConflicts();
 
-  // Re-index the vertices 
-  unsigned int i=0;
-  std::list<DataFlowVertex::Ptr>::iterator it = block_indices_.begin();
-  for(; it != block_indices_.end(); )
-  {
-    // Remove the block when we get to it
-    if((*it)->block == block) {
-      it = block_indices_.erase(it);
-    } else {
-      // Update index of the blocks we don't remove
-      (*it)->index = i;
-      // Increment the iterator
-      ++it;
-      // Increment the index
-      ++i;
-    }
+  // Print out the ordering
+  this->printExecutionOrdering();
+
+  return success;
+}
+
+bool Scheme::isEditing() const
+{
+  return edit_depth_ > 0;
+}
+
+bool Scheme::deferModelUpdate()
+{
+  if(edit_depth_ > 0) {
+    model_update_pending_ = true;
+    return true;
   }
 
-  return true;
+  return false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool Scheme::hasGroup(const std::string &group_name) const
-{ 
-  return block_groups_.find(group_name) != block_groups_.end();
+//! Identifies conman model snapshot files
+static const char SNAPSHOT_MAGIC[8] = "CONMANS";
+//! The snapshot format version, incremented whenever the format changes
+static const boost::uint32_t SNAPSHOT_VERSION = 2;
+
+//! Write an unsigned integer in little-endian byte order
+template <typename T>
+static void WriteSnapshotValue(std::ostream &out, const T value)
+{
+  for(size_t i=0; i < sizeof(T); i++) {
+    out.put(static_cast<char>((value >> (8*i)) & 0xFF));
+  }
 }
 
-std::vector<std::string> Scheme::getGroups() const
+static void WriteSnapshotString(std::ostream &out, const std::string &str)
 {
-  std::vector<std::string> group_names;
+  WriteSnapshotValue<boost::uint32_t>(out, str.size());
+  out.write(str.data(), str.size());
+}
 
-  for(conman::GroupMap::const_iterator it = block_groups_.begin();
-      it != block_groups_.end();
+static void WriteSnapshotStrings(std::ostream &out, const std::vector<std::string> &strs)
+{
+  WriteSnapshotValue<boost::uint32_t>(out, strs.size());
+  for(std::vector<std::string>::const_iterator it = strs.begin();
+      it != strs.end();
       ++it)
   {
-    group_names.push_back(it->first);
+    WriteSnapshotString(out, *it);
   }
+}
 
-  return group_names;
+static void WriteSnapshotPairs(
+    std::ostream &out,
+    const std::vector<std::pair<std::string, std::string> > &pairs)
+{
+  WriteSnapshotValue<boost::uint32_t>(out, pairs.size());
+  for(std::vector<std::pair<std::string, std::string> >::const_iterator it = pairs.begin();
+      it != pairs.end();
+      ++it)
+  {
+    WriteSnapshotString(out, it->first);
+    WriteSnapshotString(out, it->second);
+  }
 }
 
-bool Scheme::addGroup(const std::string &group_name) 
-{ 
-  // Check if the group name collides with a real block
-  if(this->hasBlock(group_name)) {
-    RTT::log(RTT::Error) << "Block group named \"" << group_name << "\" "
-      "cannot be created because a block with the same name already exists." <<
-      RTT::endlog();
+//! Read an unsigned integer in little-endian byte order
+template <typename T>
+static bool ReadSnapshotValue(std::istream &in, T &value)
+{
+  char bytes[sizeof(T)];
+  if(in.read(bytes, sizeof(T)).fail()) {
     return false;
   }
 
-  // Check if the group exists
-  if(this->hasGroup(group_name)) {
-    return true;
+  value = 0;
+  for(size_t i=0; i < sizeof(T); i++) {
+    value |= static_cast<T>(static_cast<unsigned char>(bytes[i])) << (8*i);
   }
 
-  // Create an empty group
-  std::set<std::string> no_members;
-  block_groups_[group_name] = no_members;
-
   return true;
 }
 
-bool Scheme::setGroupMembers(
-    const std::string &group_name,
-    const std::string &member_name) 
-{ 
-  std::vector<std::string> members;
-  members.push_back(member_name);
-  return this->setGroupMembers(group_name, members);
+//! Get the number of bytes after the read position of a stream
+static std::streamoff RemainingSnapshotBytes(std::istream &in)
+{
+  const std::streampos position = in.tellg();
+  if(position < 0 || in.seekg(0, std::ios::end).fail()) {
+    return 0;
+  }
+
+  const std::streamoff remaining = in.tellg() - position;
+  in.seekg(position);
+
+  return remaining;
 }
 
-bool Scheme::setGroupMembers(
-    const std::string &group_name,
-    const std::vector<std::string> &members)
-{ 
-  RTT::Logger::In in("Scheme::createGroup");
+static bool ReadSnapshotString(std::istream &in, std::string &str)
+{
+  boost::uint32_t size;
+  if(!ReadSnapshotValue(in, size)) {
+    return false;
+  }
 
-  // Check if the group already exists
-  if(this->hasGroup(group_name)) {
-    RTT::log(RTT::Warning) << "Block group named \"" << group_name << "\""
-      " already exists. Over-writing." << RTT::endlog();
+  // Don't allocate more than the rest of a truncated or corrupt file
+  if(static_cast<std::streamoff>(size) > RemainingSnapshotBytes(in)) {
+    return false;
   }
 
-  // Ensure the group exists
-  if(!this->addGroup(group_name)) {
+  str.resize(size);
+  return size == 0 || !in.read(&str[0], size).fail();
+}
+
+static bool ReadSnapshotStrings(std::istream &in, std::vector<std::string> &strs)
+{
+  boost::uint32_t size;
+  if(!ReadSnapshotValue(in, size)) {
     return false;
   }
 
-  // Make sure all the blocks are in the scheme before adding any of them
-  for(std::vector<std::string>::const_iterator it=members.begin();
-      it != members.end();
-      ++it)
-  {
-    // Check if the block is in the scheme
-    if(!this->hasBlock(*it) && !this->hasGroup(*it)) {
-      RTT::log(RTT::Error) << "Block named \"" << *it << "\" is not in the "
-      "scheme and it is not a group name." << RTT::endlog();
+  strs.clear();
+  for(boost::uint32_t i=0; i < size; i++) {
+    strs.push_back(std::string());
+    if(!ReadSnapshotString(in, strs.back())) {
       return false;
     }
   }
 
-  // Set the group membership
-  block_groups_[group_name] = std::set<std::string>(members.begin(),members.end());
-
-  return true; 
+  return true;
 }
 
-bool Scheme::addToGroup(
-    const std::string &new_name,
-    const std::string &group_name) 
+static bool ReadSnapshotPairs(
+    std::istream &in,
+    std::vector<std::pair<std::string, std::string> > &pairs)
 {
-  RTT::Logger::In in("Scheme::addToGroup");
-
-  // Check if the group exists
-  std::map<std::string, std::set<std::string> >::iterator group =
-    block_groups_.find(group_name);
-
-  if(group == block_groups_.end()) {
-    RTT::log(RTT::Error) << "Group named \"" << group_name << "\" is not"
-      " in the scheme." << RTT::endlog();
+  boost::uint32_t size;
+  if(!ReadSnapshotValue(in, size)) {
     return false;
   }
 
-  // Check if the block is in the scheme
-  if(!this->hasBlock(new_name) &&
-     !this->hasGroup(new_name) &&
-     !this->addBlock(new_name)) 
-  {
-    RTT::log(RTT::Error) << "Block or group named \"" << new_name << "\" is not"
-      " in the scheme and could not be added to the scheme." << RTT::endlog();
-    return false;
+  pairs.clear();
+  for(boost::uint32_t i=0; i < size; i++) {
+    pairs.push_back(std::pair<std::string, std::string>());
+    if(!ReadSnapshotString(in, pairs.back().first) ||
+       !ReadSnapshotString(in, pairs.back().second))
+    {
+      return false;
+    }
   }
 
-  // Add the new name to the group
-  group->second.insert(new_name);
+  return true;
+}
 
-  return true; 
-}
-
-bool Scheme::removeFromGroup(
-    const std::string &block,
-    const std::string &group_name) 
+//! Hash a string with the 64-bit FNV-1a hash
+static void HashString(boost::uint64_t &hash, const std::string &str)
 {
-  // Check if the group exists
-  std::map<std::string, std::set<std::string> >::iterator group = 
-    block_groups_.find(group_name);
-
-  if(group == block_groups_.end()) {
-    return false;
-  }
-
-  // Check if the block is in the group
-  if( group->second.find(block) == group->second.end()) {
-    // It's already gone
-    return true;
+  for(size_t i=0; i <= str.size(); i++) {
+    // Include the terminating null to separate consecutive strings
+    hash ^= static_cast<unsigned char>(i < str.size() ? str[i] : '\0');
+    hash *= 1099511628211ULL;
   }
-
-  // Remove the block from the group
-  group->second.erase(block);
-
-  return true; 
 }
 
-bool Scheme::emptyGroup( const std::string &group_name) 
+bool Scheme::loadScheme(
+    const std::string &scheme_file,
+    const std::string &snapshot_file)
 {
-  // Check if the group exists
-  if(!this->hasGroup(group_name)) {
+  RTT::Logger::In in("Scheme::loadScheme");
+
+  std::ifstream scheme_stream(scheme_file.c_str());
+  if(!scheme_stream) {
+    RTT::log(RTT::Error) << "Could not open scheme file \"" << scheme_file << "\"" << RTT::endlog();
     return false;
   }
 
-  // Remove the elments from the group
-  block_groups_[group_name].clear();
-
-  return true; 
-}
-
-bool Scheme::removeGroup( const std::string &group_name) 
-{
-  // Check if the group exists
-  if(this->hasGroup(group_name)) {
-    // Remove this group
-    block_groups_.erase(group_name);
+  // Read the snapshot of the model, if there is one
+  boost::shared_ptr<ModelSnapshot> snapshot;
+
+  if(!snapshot_file.empty()) {
+    std::ifstream snapshot_stream(snapshot_file.c_str(), std::ios::binary);
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    boost::uint32_t version, n_groups;
+
+    snapshot = boost::make_shared<ModelSnapshot>();
+
+    bool valid = 
+      !snapshot_stream.read(magic, sizeof(magic)).fail() &&
+      std::equal(magic, magic + sizeof(magic), SNAPSHOT_MAGIC) &&
+      ReadSnapshotValue(snapshot_stream, version) &&
+      version == SNAPSHOT_VERSION &&
+      ReadSnapshotValue(snapshot_stream, snapshot->model_hash) &&
+      ReadSnapshotStrings(snapshot_stream, snapshot->ordering) &&
+      ReadSnapshotPairs(snapshot_stream, snapshot->conflicts) &&
+      ReadSnapshotPairs(snapshot_stream, snapshot->latches) &&
+      ReadSnapshotValue(snapshot_stream, n_groups);
+
+    for(boost::uint32_t i=0; valid && i < n_groups; i++) {
+      std::string group_name;
+      valid =
+        ReadSnapshotString(snapshot_stream, group_name) &&
+        ReadSnapshotStrings(snapshot_stream, snapshot->groups[group_name]);
+    }
 
-    // Remove references to this group from all other groups
-    for(conman::GroupMap::iterator it = block_groups_.begin();
-        it != block_groups_.end();
-        ++it)
-    {
-      this->removeFromGroup(it->first, group_name);
+    if(!valid) {
+      RTT::log(RTT::Info) << "Could not read model snapshot \"" << snapshot_file
+        << "\", the model will be computed." << RTT::endlog();
+      snapshot.reset();
     }
   }
-  
-  return true; 
-}
 
-std::vector<std::string> Scheme::getGroupMembers(
-    const std::string &group_name) 
-  const
-{
-  std::vector<std::string> block_names;
+  // Declare the whole scheme in a single transaction
+  if(!this->beginEdit()) {
+    return false;
+  }
 
-  this->getGroupMembers(group_name, block_names);
+  pending_snapshot_ = snapshot;
 
-  return block_names;
-}
+  // Record the scheme so that it can be restored if the file can't be loaded
+  SchemeCheckpoint checkpoint;
+  this->checkpoint(checkpoint);
 
+  bool success = true;
+  std::vector<std::string> enabled_names;
+  std::string line;
 
-bool Scheme::getGroupMembers(
-    const std::string &group_name,
-    std::vector<std::string> &members) 
-  const
-{
-  // Expand the group recursively
-  std::set<std::string> member_set, visited;
-  bool success = getGroupMembers(group_name, member_set, visited);
+  for(unsigned int line_number = 1; std::getline(scheme_stream, line); line_number++) {
+    // Strip comments and split the declaration into tokens
+    std::string declaration = line.substr(0, line.find('#'));
+    boost::algorithm::trim(declaration);
 
-  // Copy the set to vector
-  members.assign(member_set.begin(), member_set.end());
+    if(declaration.empty()) {
+      continue;
+    }
 
-  return success;
-}
+    std::vector<std::string> tokens;
+    boost::algorithm::split(
+        tokens, declaration,
+        boost::algorithm::is_space(),
+        boost::algorithm::token_compress_on);
 
-bool Scheme::getGroupMembers(
-    const std::string &name,
-    std::set<std::string> &member_set,
-    std::set<std::string> &visited) 
-  const
-{
-  bool success = true;
+    const std::string &keyword = tokens[0];
+    bool declared = true;
 
-  // Avoid loops in group membership
-  if(visited.find(name) == visited.end()) {
-    // Add this group to the visited list
-    visited.insert(name);
-  } else {
-    // Already found this member
-    return true;
+    if(keyword == "block" && tokens.size() >= 2) {
+      for(size_t i=1; i < tokens.size(); i++) {
+        declared &= this->addBlock(tokens[i]);
+      }
+    } else if(keyword == "group" && tokens.size() >= 2) {
+      declared &= this->addGroup(tokens[1]);
+      for(size_t i=2; i < tokens.size(); i++) {
+        declared &= this->addToGroup(tokens[i], tokens[1]);
+      }
+    } else if(keyword == "latch" && tokens.size() == 3) {
+      declared = this->latchConnections(tokens[1], tokens[2], true);
+    } else if(keyword == "latch_inputs" && tokens.size() == 2) {
+      declared = this->latchInputs(tokens[1], true);
+    } else if(keyword == "latch_outputs" && tokens.size() == 2) {
+      declared = this->latchOutputs(tokens[1], true);
+    } else if(keyword == "period" && tokens.size() == 3) {
+      std::vector<std::string> members;
+      RTT::Seconds period;
+      std::istringstream period_stream(tokens[2]);
+
+      declared = (period_stream >> period) && this->getGroupMembers(tokens[1], members);
+
+      for(std::vector<std::string>::const_iterator it = members.begin();
+          declared && it != members.end();
+          ++it)
+      {
+        // Record the period from before the scheme file was loaded
+        if(checkpoint.periods.find(*it) == checkpoint.periods.end()) {
+          checkpoint.periods[*it] = blocks_[*it]->hook->getDesiredMinPeriod();
+        }
+        declared &= blocks_[*it]->hook->setDesiredMinPeriod(period);
+      }
+    } else if(keyword == "enable" && tokens.size() >= 2) {
+      enabled_names.insert(enabled_names.end(), tokens.begin() + 1, tokens.end());
+    } else {
+      declared = false;
+    }
+
+    if(!declared) {
+      RTT::log(RTT::Error) << "Could not load line " << line_number << " of "
+        "scheme file \"" << scheme_file << "\": " << line << RTT::endlog();
+      success = false;
+    }
   }
 
-  // Check if the group is a single block
-  if(this->hasBlock(name)) {
-    member_set.insert(name);
-    return true;
+  // Undo the whole scheme file if any of it couldn't be loaded
+  if(!success) {
+    RTT::log(RTT::Error) << "Could not load scheme file \"" << scheme_file
+      << "\", the scheme has been restored." << RTT::endlog();
+    pending_snapshot_.reset();
+    this->rollback(checkpoint);
+    this->commit();
+    return false;
   }
 
-  // Check if the group exists
-  GroupMap::const_iterator group = block_groups_.find(name);
-  if(group == block_groups_.end()) {
+  // Model the scheme once, restoring the snapshot if it matches
+  const bool executable = this->commit();
+  pending_snapshot_.reset();
+
+  // Undo the whole scheme file if it has cycles
+  if(!executable) {
+    RTT::log(RTT::Error) << "Scheme file \"" << scheme_file << "\" has one "
+      "or more cycles, the scheme has been restored." << RTT::endlog();
+    if(this->beginEdit()) {
+      this->rollback(checkpoint);
+      this->commit();
+    }
     return false;
   }
 
-  // Return the group members
-  success = true;
-  for(std::set<std::string>::const_iterator it=group->second.begin();
-      it != group->second.end();
+  // Update the snapshot if it didn't match
+  if(!snapshot_file.empty() && (!snapshot || snapshot->model_hash != this->computeModelHash())) {
+    success &= this->saveSnapshot(snapshot_file);
+  }
+
+  // Enable the declared blocks
+  for(std::vector<std::string>::const_iterator it = enabled_names.begin();
+      it != enabled_names.end();
       ++it)
   {
-    success &= this->getGroupMembers(*it, member_set, visited);
+    success &= this->enableBlock(*it, false);
   }
 
-  return success; 
+  return success;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-
-bool Scheme::latchConnections(
-    const std::string &source_name,
-    const std::string &sink_name,
-    const bool latch)
+bool Scheme::saveSnapshot(const std::string &snapshot_file) const
 {
-  // Self-loops are implicitly latched
-  if(source_name == sink_name) {
-    return true;
-  }
-
-  // Check if the source is a group name
-  std::vector<std::string> sources, sinks;
-
-  this->getGroupMembers(source_name, sources);
-  this->getGroupMembers(sink_name, sinks);
+  using namespace conman::graph;
 
-  return this->latchConnections(sources, sinks, latch);
-}
+  RTT::Logger::In in("Scheme::saveSnapshot");
 
-bool Scheme::latchConnections(
-    const std::vector<std::string> &source_names,
-    const std::vector<std::string> &sink_names,
-    const bool latch)
-{
-  // Latching blocks posible only when scheme is stoped
-  if(this->getTaskState() != Stopped) {
-    RTT::log(RTT::Error) << "Scheme is in running state. Latching blocks forbidden." << RTT::endlog();
+  std::ofstream out(snapshot_file.c_str(), std::ios::binary | std::ios::trunc);
+  if(!out) {
+    RTT::log(RTT::Error) << "Could not open model snapshot \"" << snapshot_file
+      << "\" for writing." << RTT::endlog();
     return false;
   }
-  
-  // Latch connections between all sources and sinks
-  bool success = true;
-  for(std::vector<std::string>::const_iterator source_it = source_names.begin();
-      source_it != source_names.end();
-      ++source_it)
+
+  out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  WriteSnapshotValue(out, SNAPSHOT_VERSION);
+  WriteSnapshotValue(out, this->computeModelHash());
+
+  // Save the execution ordering if there is a valid one
+  std::vector<std::string> ordering;
+  this->getExecutionOrder(ordering);
+  WriteSnapshotStrings(out, ordering);
+
+  // Save the conflicts (each pair once)
+  std::vector<std::pair<std::string, std::string> > conflicts;
+  for(std::vector<DataFlowVertex::Ptr>::const_iterator first_it = block_indices_.begin();
+      first_it != block_indices_.end();
+      ++first_it)
   {
-    for(std::vector<std::string>::const_iterator sink_it = sink_names.begin();
-        sink_it != sink_names.end();
-        ++sink_it)
+    for(std::vector<DataFlowVertex::Ptr>::const_iterator second_it = first_it;
+        second_it != block_indices_.end();
+        ++second_it)
     {
-      RTT::TaskContext* source = this->getPeer(*source_it);
-      RTT::TaskContext* sink = this->getPeer(*sink_it);
-      success &= this->latchConnections(source, sink, latch, false);
+      if(this->conflicting(*first_it, *second_it)) {
+        conflicts.push_back(std::make_pair((*first_it)->block->getName(), (*second_it)->block->getName()));
+      }
     }
   }
 
-  return success;
-}
-
-bool Scheme::latchConnections(
-    RTT::TaskContext *source,
-    RTT::TaskContext *sink,
-    const bool latch,
-    const bool strict)
-{
-  using namespace conman::graph;
+  WriteSnapshotPairs(out, conflicts);
 
-  // Make sure source and sink are valid
-  if(!source || !sink) {
-    return false;
+  // Save the latched arcs
+  std::vector<std::pair<std::string, std::string> > latches;
+  DataFlowEdgeIterator edge_it, edge_end;
+  for(boost::tie(edge_it, edge_end) = boost::edges(flow_graph_);
+      edge_it != edge_end;
+      ++edge_it)
+  {
+    if(flow_graph_[*edge_it]->latched) {
+      latches.push_back(std::make_pair(
+              flow_graph_[boost::source(*edge_it, flow_graph_)]->block->getName(),
+              flow_graph_[boost::target(*edge_it, flow_graph_)]->block->getName()));
+    }
   }
+  std::sort(latches.begin(), latches.end());
 
-  RTT::log(RTT::Debug) << "Latching connections between \"" << source->getName()
-    << "\" and \"" << sink->getName() << "\"" << RTT::endlog();
-
-  // Get edge between the source and sink
-  DataFlowEdgeDescriptor edge;
-  bool edge_found;
-  boost::tie(edge, edge_found) = boost::edge(
-      flow_vertex_map_[source], 
-      flow_vertex_map_[sink], 
-      flow_graph_);
+  WriteSnapshotPairs(out, latches);
 
-  // Latch the edge
-  if(edge_found) {
-    // Set the latch flag
-    flow_graph_[edge]->latched = latch;
-
-    // Either remove or add the edge in the execution graph
-    if(latch) {
-      boost::remove_edge(
-          exec_vertex_map_[source],
-          exec_vertex_map_[sink],
-          exec_graph_);
-    } else {
-      boost::add_edge(
-          exec_vertex_map_[source],
-          exec_vertex_map_[sink],
-          flow_graph_[edge],
-          exec_graph_);
-    }
+  // Save the flattened groups
+  WriteSnapshotValue<boost::uint32_t>(out, block_groups_.size());
+  for(conman::GroupMap::const_iterator group_it = block_groups_.begin();
+      group_it != block_groups_.end();
+      ++group_it)
+  {
+    std::vector<std::string> members;
+    this->getGroupMembers(group_it->first, members);
 
-    // Regenerate the graphs
-    this->regenerateModel();
+    WriteSnapshotString(out, group_it->first);
+    WriteSnapshotStrings(out, members);
+  }
 
-    // Print out the ordering
-    this->printExecutionOrdering();
-  } else if(strict) {
-    // Only error if strict
-    RTT::log(RTT::Error) << "Tried to " << 
-      ((latch) ? ("latch") : ("un_latch"))
-      << " a non-existent connection." <<
-      RTT::endlog();
+  if(!out) {
+    RTT::log(RTT::Error) << "Could not write model snapshot \"" << snapshot_file
+      << "\"" << RTT::endlog();
     return false;
   }
 
   return true;
 }
 
-bool Scheme::latchInputs(const std::string &sink_name, const bool latch)
+void Scheme::checkpoint(SchemeCheckpoint &checkpoint) const
 {
-  std::vector<std::string> sources, sinks;
+  using namespace conman::graph;
 
-  // Get the sources (all blocks)
-  this->getBlocks(sources);
-  // Get the sinks (potentially a group)
-  this->getGroupMembers(sink_name, sinks);
-  
-  // Set latching flags for all vertices
-  for(std::vector<std::string>::const_iterator it=sinks.begin();
-      it != sinks.end();
+  for(std::map<std::string, DataFlowVertex::Ptr>::const_iterator it = blocks_.begin();
+      it != blocks_.end();
       ++it)
   {
-    blocks_[*it]->latched_input = latch;
+    checkpoint.blocks.insert(it->first);
+    checkpoint.block_latches[it->first] = std::make_pair(it->second->latched_input, it->second->latched_output);
   }
 
-  return this->latchConnections(sources, sinks, latch);
-}
+  checkpoint.groups = block_groups_;
 
-bool Scheme::latchInputs(RTT::TaskContext *block, const bool latch)
-{
-  return block && this->latchInputs(block->getName(), latch);
+  DataFlowEdgeIterator edge_it, edge_end;
+  for(boost::tie(edge_it, edge_end) = boost::edges(flow_graph_);
+      edge_it != edge_end;
+      ++edge_it)
+  {
+    checkpoint.arc_latches[std::make_pair(
+        flow_graph_[boost::source(*edge_it, flow_graph_)]->block,
+        flow_graph_[boost::target(*edge_it, flow_graph_)]->block)] = flow_graph_[*edge_it]->latched;
+  }
+
+  checkpoint.pending_latches = pending_latches_;
+  checkpoint.removed_latches = removed_latches_;
 }
 
-bool Scheme::latchOutputs(const std::string &source_name, const bool latch)
+void Scheme::rollback(const SchemeCheckpoint &checkpoint)
 {
-  std::vector<std::string> sources, sinks;
+  using namespace conman::graph;
 
-  // Get the sources (potentially a group)
-  this->getGroupMembers(source_name, sources);
-  // Get the sinks (all blocks)
-  this->getBlocks(sinks);
-  
-  // Set latching flags for all vertices
-  for(std::vector<std::string>::const_iterator it=sources.begin();
-      it != sources.end();
+  // Remove the blocks which were added
+  std::vector<std::string> added_blocks;
+  for(std::map<std::string, DataFlowVertex::Ptr>::const_iterator it = blocks_.begin();
+      it != blocks_.end();
       ++it)
   {
-    blocks_[*it]->latched_output = latch;
+    if(checkpoint.blocks.find(it->first) == checkpoint.blocks.end()) {
+      added_blocks.push_back(it->first);
+    }
   }
 
-  return this->latchConnections(sources, sinks, latch);
-}
+  for(std::vector<std::string>::const_iterator it = added_blocks.begin();
+      it != added_blocks.end();
+      ++it)
+  {
+    RTT::TaskContext *block = blocks_[*it]->block;
+
+    // Get the block's activity from before it was added
+    std::map<RTT::TaskContext*, ActivitySettings>::const_iterator activity_it =
+      block_activities_.find(block);
+    const bool restore_activity = activity_it != block_activities_.end();
+    const ActivitySettings settings = restore_activity ? activity_it->second : ActivitySettings();
+
+    if(this->removeBlock(block) && restore_activity) {
+      block->setActivity(
+          new RTT::Activity(
+              settings.scheduler,
+              settings.priority,
+              settings.period,
+              settings.cpu_affinity,
+              0,
+              block->getName()));
+    }
+  }
 
-bool Scheme::latchOutputs(RTT::TaskContext *source, const bool latch)
-{
-  return source && this->latchOutputs(source->getName(), latch);
-}
+  // Remove the groups which were added and restore the others
+  std::vector<std::string> added_groups;
+  for(GroupMap::const_iterator it = block_groups_.begin();
+      it != block_groups_.end();
+      ++it)
+  {
+    if(checkpoint.groups.find(it->first) == checkpoint.groups.end()) {
+      added_groups.push_back(it->first);
+    }
+  }
 
-///////////////////////////////////////////////////////////////////////////////
+  for(std::vector<std::string>::const_iterator it = added_groups.begin();
+      it != added_groups.end();
+      ++it)
+  {
+    this->removeGroup(*it);
+  }
 
-int Scheme::latchCount(
-    const std::vector<std::string> &path)
-  const
-{
-  using namespace conman::graph;
+  block_groups_ = checkpoint.groups;
+  this->invalidateGroupExpansions();
 
-  // If there are fewer than two vertices, there are no edges on the path
-  if(path.size() < 2) {
-    return 0;
+  // Restore the latches
+  for(std::map<std::string, std::pair<bool, bool> >::const_iterator it = checkpoint.block_latches.begin();
+      it != checkpoint.block_latches.end();
+      ++it)
+  {
+    std::map<std::string, DataFlowVertex::Ptr>::const_iterator block_it = blocks_.find(it->first);
+    if(block_it != blocks_.end()) {
+      block_it->second->latched_input = it->second.first;
+      block_it->second->latched_output = it->second.second;
+    }
   }
 
-  int latch_count = 0;
-
-  // Iterate over pairs of vertices
-  std::vector<std::string>::const_iterator
-    source_name = path.begin(), 
-    sink_name = ++path.begin();
-  for( ;source_name != path.end() && sink_name != path.end();
-       ++source_name, ++sink_name)
+  DataFlowEdgeIterator edge_it, edge_end;
+  for(boost::tie(edge_it, edge_end) = boost::edges(flow_graph_);
+      edge_it != edge_end;
+      ++edge_it)
   {
-    // Get the blocks corresponding to the names
-    std::map<std::string, DataFlowVertex::Ptr>::const_iterator
-      source, 
-      sink;
-
-    source = blocks_.find(*source_name);
-    sink = blocks_.find(*sink_name);
-
-    // Make sure the blocks are valid
-    if(source == blocks_.end() || sink == blocks_.end()) {
-      RTT::log(RTT::Error) << "Could not compute latch count because path"
-        " elements aren't in the graph." << RTT::endlog();
-      return 0;
-    }
-
-    // Get the vertex descriptors for these blocks
-    DataFlowVertexDescriptor u = flow_vertex_map_.find(source->second->block)->second;
-    DataFlowVertexDescriptor v = flow_vertex_map_.find(sink->second->block)->second;
-
-    // Get the edge between these blocks
-    DataFlowEdgeDescriptor edge;
-    bool edge_found;
-    boost::tie(edge,edge_found) = boost::edge(u,v,flow_graph_);
-    
-    if(!edge_found) {
-      RTT::log(RTT::Error) << "Could not compute latch count because path"
-        " elements aren't connected." << RTT::endlog();
-      return 0;
-    }
+    std::map<std::pair<RTT::TaskContext*, RTT::TaskContext*>, bool>::const_iterator latch_it =
+      checkpoint.arc_latches.find(std::make_pair(
+              flow_graph_[boost::source(*edge_it, flow_graph_)]->block,
+              flow_graph_[boost::target(*edge_it, flow_graph_)]->block));
 
-    // Increment latch count
-    if(flow_graph_[edge]->latched) {
-      latch_count++;
+    if(latch_it != checkpoint.arc_latches.end()) {
+      flow_graph_[*edge_it]->latched = latch_it->second;
     }
   }
 
-  return latch_count;
-}
-
-int Scheme::maxLatchCount() const
-{
-  int max_latch_count = 0;
-
-  std::vector<std::vector<std::string> > cycles;
-  this->getFlowCycles(cycles);
+  pending_latches_ = checkpoint.pending_latches;
+  removed_latches_ = checkpoint.removed_latches;
 
-  for(std::vector<std::vector<std::string> >::const_iterator it = cycles.begin();
-      it != cycles.end();
+  // Restore the periods
+  for(std::map<std::string, RTT::Seconds>::const_iterator it = checkpoint.periods.begin();
+      it != checkpoint.periods.end();
       ++it)
   {
-    std::vector<std::string> closed_path;
-    if(it->size() >= 2) {
-      closed_path.push_back((*it)[it->size()-1]);
-      closed_path.push_back((*it)[0]);
+    std::map<std::string, DataFlowVertex::Ptr>::const_iterator block_it = blocks_.find(it->first);
+    if(block_it != blocks_.end()) {
+      block_it->second->hook->setDesiredMinPeriod(it->second);
     }
-    max_latch_count = std::max(max_latch_count, this->latchCount(*it) + this->latchCount(closed_path));
   }
 
-  return max_latch_count;
+  // Regenerate the model when the transaction is committed
+  model_version_++;
+  model_update_pending_ = true;
 }
 
-int Scheme::minLatchCount() const
+boost::uint64_t Scheme::computeModelHash() const
 {
-  int min_latch_count = std::numeric_limits<int>::max();
+  using namespace conman::graph;
 
-  std::vector<std::vector<std::string> > cycles;
-  if(this->getFlowCycles(cycles) == 0) {
-    return 0;
-  }
+  boost::uint64_t hash = 14695981039346656037ULL;
 
-  for(std::vector<std::vector<std::string> >::const_iterator it = cycles.begin();
-      it != cycles.end();
-      ++it)
+  // Blocks are hashed in name order, and arcs and connections are sorted so
+  // that the hash doesn't depend on the order in which they were modeled
+  for(std::map<std::string, DataFlowVertex::Ptr>::const_iterator block_it = blocks_.begin();
+      block_it != blocks_.end();
+      ++block_it)
   {
-    std::vector<std::string> closed_path;
-    if(it->size() >= 2) {
-      closed_path.push_back((*it)[it->size()-1]);
-      closed_path.push_back((*it)[0]);
-    }
-    min_latch_count = std::min(min_latch_count, this->latchCount(*it) + this->latchCount(closed_path));
-  }
+    HashString(hash, block_it->first);
 
-  return min_latch_count;
-}
+    // Block latches apply to arcs which are modeled later, so they're part of
+    // the model even if the block has no arcs yet
+    HashString(hash, block_it->second->latched_input ? "latched_input" : "");
+    HashString(hash, block_it->second->latched_output ? "latched_output" : "");
 
-int Scheme::getFlowCycles(
-    std::vector<std::vector<std::string> > &cycle_strs)
-  const
-{
-  using namespace conman::graph;
+    DataFlowVertexTaskMap::const_iterator flow_vertex_it = flow_vertex_map_.find(block_it->second->block);
+    if(flow_vertex_it == flow_vertex_map_.end()) {
+      continue;
+    }
 
-  cycle_strs.clear();
+    std::vector<std::string> arcs;
 
-  std::vector<DataFlowPath> cycles;
-  this->computeCycles(flow_graph_, cycles);
+    DataFlowOutEdgeIterator out_edge_it, out_edge_end;
+    for(boost::tie(out_edge_it, out_edge_end) = boost::out_edges(flow_vertex_it->second, flow_graph_);
+        out_edge_it != out_edge_end;
+        ++out_edge_it)
+    {
+      const DataFlowEdge::Ptr edge = flow_graph_[*out_edge_it];
+      const DataFlowVertex::Ptr sink_vertex = flow_graph_[boost::target(*out_edge_it, flow_graph_)];
+
+      // The exclusivity of each sink port determines the conflicts
+      std::vector<std::string> connections;
+      for(std::vector<DataFlowEdge::Connection>::const_iterator conn_it = edge->connections.begin();
+          conn_it != edge->connections.end();
+          ++conn_it)
+      {
+        const std::string sink_port_path = ResolvePortPath(conn_it->sink_service, conn_it->sink_port);
+
+        // The exclusivity is cached when the sink block is added
+        std::map<const RTT::base::PortInterface*, conman::Exclusivity::Mode>::const_iterator mode_it =
+          input_exclusivity_.find(conn_it->sink_port);
+        const unsigned int mode = (mode_it != input_exclusivity_.end())
+          ? mode_it->second
+          : sink_vertex->hook->getInputExclusivity(sink_port_path);
+
+        std::ostringstream connection;
+        connection << ResolvePortPath(conn_it->source_service, conn_it->source_port)
+          << " -> " << sink_port_path
+          << " " << mode;
+        connections.push_back(connection.str());
+      }
+      std::sort(connections.begin(), connections.end());
+
+      std::ostringstream arc;
+      arc << sink_vertex->block->getName()
+        << (edge->latched ? " latched" : "");
+      for(std::vector<std::string>::const_iterator it = connections.begin();
+          it != connections.end();
+          ++it)
+      {
+        arc << " " << *it;
+      }
+      arcs.push_back(arc.str());
+    }
+    std::sort(arcs.begin(), arcs.end());
 
-  // Clear cycle component names
-  cycle_strs.resize(cycles.size());
+    for(std::vector<std::string>::const_iterator it = arcs.begin();
+        it != arcs.end();
+        ++it)
+    {
+      HashString(hash, *it);
+    }
+  }
 
-  // Copy the names of the components associated with the verticies for each
-  // cycle
-  for(size_t c=0; c < cycles.size(); c++) {
-    for(DataFlowPath::const_iterator v_it=cycles[c].begin();
-        v_it != cycles[c].end();
-        ++v_it) 
+  // Groups are hashed in name order with their direct members
+  for(GroupMap::const_iterator group_it = block_groups_.begin();
+      group_it != block_groups_.end();
+      ++group_it)
+  {
+    HashString(hash, group_it->first);
+
+    for(std::set<std::string>::const_iterator it = group_it->second.begin();
+        it != group_it->second.end();
+        ++it)
     {
-      cycle_strs[c].push_back(flow_graph_[*v_it]->block->getName());
+      HashString(hash, *it);
     }
+
+    // Separate the members of consecutive groups
+    HashString(hash, "");
   }
 
-  return cycle_strs.size();
+  return hash;
 }
 
-int Scheme::computeCycles(
-    const conman::graph::DataFlowGraph &data_flow_graph,
-    std::vector<conman::graph::DataFlowPath> &cycles)
-  const
+bool Scheme::restoreSnapshot(const ModelSnapshot &snapshot)
 {
   using namespace conman::graph;
 
-  // Clear the output variable
-  cycles.clear();
+  RTT::Logger::In in("Scheme::restoreSnapshot");
 
-  // Construct a cycle visitor for extracting cycles
-  FlowCycleVisitor visitor(cycles);
+  // The connections need to be modeled to validate the snapshot
+  bool topology_modified = false;
+  contracts_satisfied_ = this->modelConnections(topology_modified);
 
-  try {
-    // Find all cycles 
-#ifdef USE_HAWICK
-    boost::hawick_circuits( data_flow_graph, visitor);
-#else
-    boost::tiernan_all_cycles( data_flow_graph, visitor);
-#endif
-  } catch( std::runtime_error &ex) {
-    RTT::log(RTT::Error) << "Could not compute cycles for data flow graph." <<
-      RTT::endlog();
-    return 0;
+  if(!contracts_satisfied_) {
+    return false;
   }
 
-  return cycles.size();
-}
+  if(this->computeModelHash() != snapshot.model_hash) {
+    RTT::log(RTT::Info) << "The model snapshot doesn't match the scheme, the "
+      "model will be computed." << RTT::endlog();
+    return false;
+  }
 
-bool Scheme::computeSchedule(
-    const conman::graph::DataFlowGraph &data_flow_graph,
-    conman::graph::ExecutionOrdering &ordering, 
-    const bool quiet)
-  const
-{
-  using namespace conman::graph;
+  // The latched arcs are part of the hash, but they're checked explicitly
+  // since they determine the execution ordering
+  size_t n_latches = 0;
+  DataFlowEdgeIterator edge_it, edge_end;
+  for(boost::tie(edge_it, edge_end) = boost::edges(flow_graph_);
+      edge_it != edge_end;
+      ++edge_it)
+  {
+    if(flow_graph_[*edge_it]->latched) {
+      n_latches++;
+    }
+  }
 
-  // Clear the ordering
-  ordering.clear();
+  if(n_latches != snapshot.latches.size()) {
+    return false;
+  }
 
-  try{
-    // Recompute the topological sort
-    // NOTE: We need to use an external vertex index property for this
-    // algorithm to work since our adjacency_list uses a list as the underlying
-    // vertex data structure. See the documentation for DataFlowVertexIndex for
-    // more info.
-    boost::topological_sort( 
-        data_flow_graph, 
-        std::front_inserter(ordering));/**,
-        boost::vertex_index_map(
-            boost::make_function_property_map<DataFlowVertexDescriptor>(
-                boost::bind(&DataFlowVertexIndex,_1,data_flow_graph))));**/
+  for(std::vector<std::pair<std::string, std::string> >::const_iterator it = snapshot.latches.begin();
+      it != snapshot.latches.end();
+      ++it)
+  {
+    std::map<std::string, DataFlowVertex::Ptr>::const_iterator
+      source_it = blocks_.find(it->first),
+      sink_it = blocks_.find(it->second);
 
-  } catch(std::exception &ex) {
-    // Complain unless quiet flag is true
-    if(!quiet) {
-      RTT::log(RTT::Error)
-        << "Cannot regenerate topological ordering in conman scheme because: "
-        << ex.what() << RTT::endlog();
+    if(source_it == blocks_.end() || sink_it == blocks_.end()) {
+      return false;
+    }
+
+    DataFlowEdgeDescriptor edge;
+    bool edge_found;
+    boost::tie(edge, edge_found) = boost::edge(
+        flow_vertex_map_[source_it->second->block],
+        flow_vertex_map_[sink_it->second->block],
+        flow_graph_);
+
+    if(!edge_found || !flow_graph_[edge]->latched) {
+      return false;
     }
-    return false;
   }
 
-  return true;
-}
+  // Restore the execution ordering (snapshots of schemes which could not be
+  // executed have none)
+  ExecutionOrdering ordering;
+  for(std::vector<std::string>::const_iterator it = snapshot.ordering.begin();
+      it != snapshot.ordering.end();
+      ++it)
+  {
+    std::map<std::string, DataFlowVertex::Ptr>::const_iterator block_it = blocks_.find(*it);
+    if(block_it == blocks_.end()) {
+      return false;
+    }
+    ordering.push_back(flow_vertex_map_[block_it->second->block]);
+  }
 
+  if(ordering.size() != blocks_.size()) {
+    return false;
+  }
 
-///////////////////////////////////////////////////////////////////////////////
+  exec_ordering_ = ordering;
+  exec_ordering_version_ = model_version_;
 
-bool Scheme::executable() const
-{
-  using namespace conman::graph;
+  // Restore the conflicts
+  conflict_matrix_.assign(blocks_.size(), ConflictSet(blocks_.size()));
 
-  // Compute the schedule on a throw-away ordering
-  ExecutionOrdering ordering;
-  return this->computeSchedule(exec_graph_, ordering, true);
-}
+  for(std::vector<std::pair<std::string, std::string> >::const_iterator it = snapshot.conflicts.begin();
+      it != snapshot.conflicts.end();
+      ++it)
+  {
+    std::map<std::string, DataFlowVertex::Ptr>::const_iterator
+      first_it = blocks_.find(it->first),
+      second_it = blocks_.find(it->second);
 
-int Scheme::getExecutionCycles(
-    std::vector<std::vector<std::string> > &cycle_strs)
-  const
-{
-  using namespace conman::graph;
+    if(first_it == blocks_.end() || second_it == blocks_.end()) {
+      continue;
+    }
 
-  cycle_strs.clear();
+    conflict_matrix_[first_it->second->index].set(second_it->second->index);
+    conflict_matrix_[second_it->second->index].set(first_it->second->index);
+  }
 
-  std::vector<DataFlowPath> cycles;
-  this->computeCycles(exec_graph_, cycles);
+  // Restore the flattened groups
+  for(std::map<std::string, std::vector<std::string> >::const_iterator group_it = snapshot.groups.begin();
+      group_it != snapshot.groups.end();
+      ++group_it)
+  {
+    std::map<std::string, conman::BlockID>::const_iterator id_it = ids_.find(group_it->first);
+    if(id_it == ids_.end() || id_vertices_[id_it->second]) {
+      continue;
+    }
 
-  // Clear cycle component names
-  cycle_strs.resize(cycles.size());
+    GroupExpansion &expansion = group_expansions_[id_it->second];
+    expansion.members.clear();
+    expansion.blocks.resize(block_indices_.size());
+    expansion.blocks.reset();
+    expansion.complete = true;
 
-  // Copy the names of the components associated with the verticies for each
-  // cycle
-  for(size_t c=0; c < cycles.size(); c++) {
-    for(DataFlowPath::const_iterator v_it=cycles[c].begin();
-        v_it != cycles[c].end();
-        ++v_it) 
+    for(std::vector<std::string>::const_iterator it = group_it->second.begin();
+        it != group_it->second.end();
+        ++it)
     {
-      cycle_strs[c].push_back(exec_graph_[*v_it]->block->getName());
+      std::map<std::string, DataFlowVertex::Ptr>::const_iterator block_it = blocks_.find(*it);
+      if(block_it == blocks_.end()) {
+        expansion.complete = false;
+        continue;
+      }
+      expansion.members.push_back(*it);
+      expansion.blocks.set(block_it->second->index);
     }
+
+    expansion.expanded = expansion.complete;
   }
 
-  return cycle_strs.size();
+  RTT::log(RTT::Debug) << "Restored model snapshot." << RTT::endlog();
+
+  return true;
 }
 
-bool Scheme::getExecutionOrder(std::vector<std::string> &order) const
+void Scheme::printExecutionOrdering() const
 {
-  // Reset the order return argument
-  order.clear();
+  using namespace conman::graph;
 
-  // Check if there is a valid order
-  if(!this->executable()) {
-    return false;
-  }
+  std::vector<std::string> ordered_names;
+  ordered_names.reserve(exec_ordering_.size());
 
-  // Fill the order with 
-  for(conman::graph::ExecutionOrdering::const_iterator it = exec_ordering_.begin();
+  for(ExecutionOrdering::const_iterator it = exec_ordering_.begin();
       it != exec_ordering_.end();
-      ++it)
+      ++it) 
   {
-    order.push_back(exec_graph_[*it]->block->getName());
+    ordered_names.push_back(flow_graph_[*it]->block->getName());
   }
 
-  return true;
+  RTT::log(RTT::Info) << "Scheme ordering: [ " <<
+    boost::algorithm::join(ordered_names, ", ") << " ] " << RTT::endlog();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void Scheme::computeConflicts() 
+bool Scheme::removeBlock(const std::string &block_name)
 {
-  std::map<std::string,graph::DataFlowVertex::Ptr>::iterator it;
-  for(it = blocks_.begin(); it != blocks_.end(); ++it) {
-    this->computeConflicts(it->second->block->getName());
-  }
-}
+  RTT::Logger::In in("Scheme::removeBlock(string)");
 
-void Scheme::computeConflicts(const std::string &block_name) 
-{
-  if(blocks_.find(block_name) != blocks_.end()) {
-    this->computeConflicts(blocks_[block_name]);
-  }
-}
+  // Make sure the block exists as a peer of the scheme
+  if(!this->hasPeer(block_name)) {
+    RTT::TaskContext::PeerList peers = this->getPeerList();
 
-void Scheme::computeConflicts(const std::vector<std::string> &block_names)
-{
-  for(std::vector<std::string>::const_iterator it = block_names.begin();
-      it != block_names.end();
-      ++it)
-  {
-    this->computeConflicts(*it);
+    RTT::log(RTT::Error)
+      << "Requested block to remove named \"" << block_name << "\" was not a"
+      " peer of this Scheme." << std::endl << "  Available blocks include:"
+      << std::endl;
+
+    for(RTT::TaskContext::PeerList::iterator it = peers.begin();
+        it != peers.end();
+        ++it) 
+    {
+      RTT::log(RTT::Error) << "    " << *it << std::endl;
+    }
+
+    RTT::log(RTT::Error) << RTT::endlog();
+
+    return false;
   }
+
+  // Get the newly loaded block
+  RTT::TaskContext *block = this->getPeer(block_name);
+
+  // Add the block to the graphs
+  return this->removeBlock(block);
 }
 
-void Scheme::computeConflicts(conman::graph::DataFlowVertex::Ptr seed_vertex)
+bool Scheme::removeBlock(
+    RTT::TaskContext *block)
 {
   using namespace conman::graph;
 
-  RTT::Logger::In in("Scheme::computeConflicts");
-
-  // The seed block is the block whose sinks we're inspecting for conflicts
-  // i.e. the seed block has output ports, this gets all of the input ports
-  // that those output ports connect to, and determines if there are other
-  // output ports which are connected to them
-  RTT::TaskContext *& seed_block = seed_vertex->block;
-
-  RTT::log(RTT::Debug) << "Computing conflicts for " << seed_block->getName() << "..." << RTT::endlog();
+  RTT::Logger::In in("Scheme::removeBlock");
 
-  // Add this block to the conflict graph / map if it isn't already in it
-  if(conflict_vertex_map_.find(seed_block) == conflict_vertex_map_.end()) {
-    conflict_vertex_map_[seed_block] = boost::add_vertex(seed_vertex,conflict_graph_);
+  // Removeing blocks posible only when scheme is stoped
+  if(this->getTaskState() != Stopped) {
+    RTT::log(RTT::Error) << "Scheme is in running state. Removing blocks forbidden." << RTT::endlog();
+    return false;
   }
 
-  // Iterator for out edges (from the seed block)
-  DataFlowOutEdgeIterator out_edge_it, out_edge_end;
+  if(block == NULL) {
+    return false;
+  }
+
+  RTT::log(RTT::Debug) << "Removing block " << block->getName() << "." <<
+    RTT::endlog();
+
+  // Succeed if the block isn't already in the scheme
+  if(blocks_.find(block->getName()) == blocks_.end()) {
+    return true;
+  }
+
+  // Make sure the block has the conman hook
+  if(!Hook::HasHook(block)) {
+    return false;
+  }
+
+  // Check if the block is in the scheme
+  if(flow_vertex_map_.find(block) != flow_vertex_map_.end()) {
+    // Get the vertex properties pointer
+    DataFlowVertex::Ptr vertex = flow_graph_[flow_vertex_map_[block]];
+    // Remove the vertex from the graph
+    if(!this->removeBlockFromGraph(vertex)) {
+      // Complain
+      RTT::log(RTT::Fatal) << "Failed to remove block \"" << block->getName()
+        << "\" from scheme." <<
+        RTT::endlog();
+      // Set failure
+      return false;
+    }
+  }
+
+  block_activities_.erase(block);
+
+  // Remove the block from the block map
+  blocks_.erase(block->getName());
+  this->retireBlockID(block->getName());
+
+  // Re-index the vertices 
+  unsigned int i=0;
+  std::vector<DataFlowVertex::Ptr>::iterator it = block_indices_.begin();
+  for(; it != block_indices_.end(); )
+  {
+    // Remove the block when we get to it
+    if((*it)->block == block) {
+      it = block_indices_.erase(it);
+    } else {
+      // Update index of the blocks we don't remove
+      (*it)->index = i;
+      // Increment the iterator
+      ++it;
+      // Increment the index
+      ++i;
+    }
+  }
+
+  // The vertex indices have changed
+  model_version_++;
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Scheme::hasGroup(const std::string &group_name) const
+{ 
+  return block_groups_.find(group_name) != block_groups_.end();
+}
+
+std::vector<std::string> Scheme::getGroups() const
+{
+  std::vector<std::string> group_names;
+
+  for(conman::GroupMap::const_iterator it = block_groups_.begin();
+      it != block_groups_.end();
+      ++it)
+  {
+    group_names.push_back(it->first);
+  }
+
+  return group_names;
+}
+
+bool Scheme::addGroup(const std::string &group_name) 
+{ 
+  // Check if the group name collides with a real block
+  if(this->hasBlock(group_name)) {
+    RTT::log(RTT::Error) << "Block group named \"" << group_name << "\" "
+      "cannot be created because a block with the same name already exists." <<
+      RTT::endlog();
+    return false;
+  }
+
+  // Check if the group exists
+  if(this->hasGroup(group_name)) {
+    return true;
+  }
+
+  // Make sure the scheme has room for the group
+  if(max_groups_ > 0 && block_groups_.size() >= max_groups_) {
+    RTT::log(RTT::Error) << "Block group named \"" << group_name << "\" "
+      "cannot be created because the scheme is at its capacity of "
+      << max_groups_ << " groups." << RTT::endlog();
+    return false;
+  }
+
+  // Create an empty group
+  std::set<std::string> no_members;
+  block_groups_[group_name] = no_members;
+  this->issueBlockID(group_name, conman::graph::DataFlowVertex::Ptr());
+
+  return true;
+}
+
+bool Scheme::setGroupMembers(
+    const std::string &group_name,
+    const std::string &member_name) 
+{ 
+  std::vector<std::string> members;
+  members.push_back(member_name);
+  return this->setGroupMembers(group_name, members);
+}
+
+bool Scheme::setGroupMembers(
+    const std::string &group_name,
+    const std::vector<std::string> &members)
+{ 
+  RTT::Logger::In in("Scheme::createGroup");
+
+  // Check if the group already exists
+  if(this->hasGroup(group_name)) {
+    RTT::log(RTT::Warning) << "Block group named \"" << group_name << "\""
+      " already exists. Over-writing." << RTT::endlog();
+  }
+
+  // Ensure the group exists
+  if(!this->addGroup(group_name)) {
+    return false;
+  }
+
+  // Make sure all the blocks are in the scheme before adding any of them
+  for(std::vector<std::string>::const_iterator it=members.begin();
+      it != members.end();
+      ++it)
+  {
+    // Check if the block is in the scheme
+    if(!this->hasBlock(*it) && !this->hasGroup(*it)) {
+      RTT::log(RTT::Error) << "Block named \"" << *it << "\" is not in the "
+      "scheme and it is not a group name." << RTT::endlog();
+      return false;
+    }
+  }
+
+  // Set the group membership
+  block_groups_[group_name] = std::set<std::string>(members.begin(),members.end());
+  this->invalidateGroupExpansions();
+
+  return true; 
+}
+
+bool Scheme::addToGroup(
+    const std::string &new_name,
+    const std::string &group_name) 
+{
+  RTT::Logger::In in("Scheme::addToGroup");
+
+  // Check if the group exists
+  std::map<std::string, std::set<std::string> >::iterator group =
+    block_groups_.find(group_name);
+
+  if(group == block_groups_.end()) {
+    RTT::log(RTT::Error) << "Group named \"" << group_name << "\" is not"
+      " in the scheme." << RTT::endlog();
+    return false;
+  }
+
+  // Check if the block is in the scheme
+  if(!this->hasBlock(new_name) &&
+     !this->hasGroup(new_name) &&
+     !this->addBlock(new_name)) 
+  {
+    RTT::log(RTT::Error) << "Block or group named \"" << new_name << "\" is not"
+      " in the scheme and could not be added to the scheme." << RTT::endlog();
+    return false;
+  }
+
+  // Add the new name to the group
+  group->second.insert(new_name);
+  this->invalidateGroupExpansions();
+
+  return true; 
+}
+
+bool Scheme::removeFromGroup(
+    const std::string &block,
+    const std::string &group_name) 
+{
+  // Check if the group exists
+  std::map<std::string, std::set<std::string> >::iterator group = 
+    block_groups_.find(group_name);
+
+  if(group == block_groups_.end()) {
+    return false;
+  }
+
+  // Check if the block is in the group
+  if( group->second.find(block) == group->second.end()) {
+    // It's already gone
+    return true;
+  }
+
+  // Remove the block from the group
+  group->second.erase(block);
+  this->invalidateGroupExpansions();
+
+  return true; 
+}
+
+bool Scheme::emptyGroup( const std::string &group_name) 
+{
+  // Check if the group exists
+  if(!this->hasGroup(group_name)) {
+    return false;
+  }
+
+  // Remove the elments from the group
+  block_groups_[group_name].clear();
+  this->invalidateGroupExpansions();
+
+  return true; 
+}
+
+bool Scheme::removeGroup( const std::string &group_name) 
+{
+  // Check if the group exists
+  if(this->hasGroup(group_name)) {
+    // Remove this group
+    block_groups_.erase(group_name);
+    this->retireBlockID(group_name);
+    this->invalidateGroupExpansions();
+
+    // Remove references to this group from all other groups
+    for(conman::GroupMap::iterator it = block_groups_.begin();
+        it != block_groups_.end();
+        ++it)
+    {
+      this->removeFromGroup(group_name, it->first);
+    }
+  }
+  
+  return true; 
+}
+
+std::vector<std::string> Scheme::getGroupMembers(
+    const std::string &group_name) 
+  const
+{
+  std::vector<std::string> block_names;
+
+  this->getGroupMembers(group_name, block_names);
+
+  return block_names;
+}
+
+
+bool Scheme::getGroupMembers(
+    const std::string &group_name,
+    std::vector<std::string> &members) 
+  const
+{
+  // A single block is its only member
+  if(this->hasBlock(group_name)) {
+    members.assign(1, group_name);
+    return true;
+  }
+
+  // Get the flattened group
+  const GroupExpansion *expansion = this->expandGroup(group_name);
+
+  if(expansion == NULL) {
+    members.clear();
+    return false;
+  }
+
+  members = expansion->members;
+
+  return expansion->complete;
+}
+
+const Scheme::GroupExpansion* Scheme::expandGroup(
+    const std::string &group_name)
+  const
+{
+  std::map<std::string, conman::BlockID>::const_iterator id_it = ids_.find(group_name);
+
+  if(id_it == ids_.end()) {
+    return NULL;
+  }
+
+  return this->expandGroup(id_it->second);
+}
+
+const Scheme::GroupExpansion* Scheme::expandGroup(
+    const conman::BlockID id)
+  const
+{
+  // Check if the ID is a group
+  if(id >= id_names_.size() || id_vertices_[id] || id_names_[id].empty()) {
+    return NULL;
+  }
+
+  GroupExpansion &expansion = group_expansions_[id];
+
+  // Check if the group has already been expanded
+  if(expansion.expanded) {
+    return &expansion;
+  }
+
+  // Expand the group recursively
+  std::set<std::string> member_set, visited;
+  expansion.complete = this->getGroupMembers(id_names_[id], member_set, visited);
+
+  // Copy the set to vector
+  expansion.members.assign(member_set.begin(), member_set.end());
+
+  // Get the indices of the members
+  expansion.blocks.resize(block_indices_.size());
+  expansion.blocks.reset();
+
+  for(std::vector<std::string>::const_iterator it = expansion.members.begin();
+      it != expansion.members.end();
+      ++it)
+  {
+    expansion.blocks.set(blocks_.find(*it)->second->index);
+  }
+
+  expansion.expanded = true;
+
+  return &expansion;
+}
+
+bool Scheme::getGroupMembers(
+    const std::string &name,
+    std::set<std::string> &member_set,
+    std::set<std::string> &visited) 
+  const
+{
+  bool success = true;
+
+  // Avoid loops in group membership
+  if(visited.find(name) == visited.end()) {
+    // Add this group to the visited list
+    visited.insert(name);
+  } else {
+    // Already found this member
+    return true;
+  }
+
+  // Check if the group is a single block
+  if(this->hasBlock(name)) {
+    member_set.insert(name);
+    return true;
+  }
+
+  // Check if the group exists
+  GroupMap::const_iterator group = block_groups_.find(name);
+  if(group == block_groups_.end()) {
+    return false;
+  }
+
+  // Return the group members
+  success = true;
+  for(std::set<std::string>::const_iterator it=group->second.begin();
+      it != group->second.end();
+      ++it)
+  {
+    success &= this->getGroupMembers(*it, member_set, visited);
+  }
+
+  return success; 
+}
+
+void Scheme::invalidateGroupExpansions()
+{
+  for(std::vector<GroupExpansion>::iterator it = group_expansions_.begin();
+      it != group_expansions_.end();
+      ++it)
+  {
+    it->expanded = false;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+conman::BlockID Scheme::issueBlockID(
+    const std::string &name,
+    const conman::graph::DataFlowVertex::Ptr &vertex)
+{
+  const conman::BlockID id = id_names_.size();
+
+  id_names_.push_back(name);
+  id_vertices_.push_back(vertex);
+  group_expansions_.resize(id_names_.size());
+  ids_[name] = id;
+
+  // Reserve the group's expansion
+  if(!vertex && max_blocks_ > 0) {
+    group_expansions_.back().members.reserve(max_blocks_);
+    ReserveBits(group_expansions_.back().blocks, max_blocks_);
+  }
+
+  return id;
+}
+
+void Scheme::retireBlockID(const std::string &name)
+{
+  std::map<std::string, conman::BlockID>::iterator id_it = ids_.find(name);
+
+  if(id_it != ids_.end()) {
+    id_names_[id_it->second].clear();
+    id_vertices_[id_it->second].reset();
+    group_expansions_[id_it->second] = GroupExpansion();
+    ids_.erase(id_it);
+  }
+}
+
+conman::BlockID Scheme::getBlockID(const std::string &name) const
+{
+  std::map<std::string, conman::BlockID>::const_iterator id_it = ids_.find(name);
+
+  return (id_it != ids_.end()) ? id_it->second : conman::INVALID_BLOCK_ID;
+}
+
+std::string Scheme::getBlockName(const conman::BlockID id) const
+{
+  return (id < id_names_.size()) ? id_names_[id] : std::string();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Scheme::latchConnections(
+    const std::string &source_name,
+    const std::string &sink_name,
+    const bool latch)
+{
+  // Self-loops are implicitly latched
+  if(source_name == sink_name) {
+    return true;
+  }
+
+  // Check if the source is a group name
+  std::vector<std::string> sources, sinks;
+
+  this->getGroupMembers(source_name, sources);
+  this->getGroupMembers(sink_name, sinks);
+
+  return this->latchConnections(sources, sinks, latch);
+}
+
+bool Scheme::latchConnections(
+    const std::vector<std::string> &source_names,
+    const std::vector<std::string> &sink_names,
+    const bool latch)
+{
+  // Latching blocks posible only when scheme is stoped
+  if(this->getTaskState() != Stopped) {
+    RTT::log(RTT::Error) << "Scheme is in running state. Latching blocks forbidden." << RTT::endlog();
+    return false;
+  }
+  
+  // Regenerate the model once after latching all connections
+  if(!this->beginEdit()) {
+    return false;
+  }
+
+  // Latch connections between all sources and sinks
+  bool success = true;
+  for(std::vector<std::string>::const_iterator source_it = source_names.begin();
+      source_it != source_names.end();
+      ++source_it)
+  {
+    for(std::vector<std::string>::const_iterator sink_it = sink_names.begin();
+        sink_it != sink_names.end();
+        ++sink_it)
+    {
+      RTT::TaskContext* source = this->getPeer(*source_it);
+      RTT::TaskContext* sink = this->getPeer(*sink_it);
+      success &= this->latchConnections(source, sink, latch, false);
+    }
+  }
+
+  // Whether the latched scheme is executable is reported by executable()
+  this->commit();
+
+  // Check that the new latches delay their connections, once the model has
+  // been regenerated
+  if(latch && edit_depth_ == 0) {
+    for(std::vector<std::string>::const_iterator source_it = source_names.begin();
+        source_it != source_names.end();
+        ++source_it)
+    {
+      for(std::vector<std::string>::const_iterator sink_it = sink_names.begin();
+          sink_it != sink_names.end();
+          ++sink_it)
+      {
+        success &= this->checkLatchDelayed(this->getPeer(*source_it), this->getPeer(*sink_it));
+      }
+    }
+  }
+
+  return success;
+}
+
+bool Scheme::latchConnections(
+    RTT::TaskContext *source,
+    RTT::TaskContext *sink,
+    const bool latch,
+    const bool strict)
+{
+  using namespace conman::graph;
+
+  // Make sure source and sink are valid
+  if(!source || !sink) {
+    return false;
+  }
+
+  RTT::log(RTT::Debug) << "Latching connections between \"" << source->getName()
+    << "\" and \"" << sink->getName() << "\"" << RTT::endlog();
+
+  // Get edge between the source and sink
+  DataFlowEdgeDescriptor edge;
+  bool edge_found;
+  boost::tie(edge, edge_found) = boost::edge(
+      flow_vertex_map_[source], 
+      flow_vertex_map_[sink], 
+      flow_graph_);
+
+  // Latch the edge
+  if(edge_found) {
+    // Set the latch flag, which removes or adds the edge in the ESG view
+    if(flow_graph_[edge]->latched != latch) {
+      flow_graph_[edge]->latched = latch;
+      model_version_++;
+    }
+
+    // Regenerate the graphs and print out the ordering
+    if(!this->deferModelUpdate()) {
+      this->regenerateModel();
+      this->printExecutionOrdering();
+
+      if(latch && !this->checkLatchDelayed(source, sink)) {
+        return false;
+      }
+    }
+  } else if(edit_depth_ > 0) {
+    // The connection may not be modeled until the transaction is committed
+    pending_latches_[std::make_pair(source, sink)] = latch;
+    model_update_pending_ = true;
+  }
+
+  // If the blocks were disconnected, this is applied if they're reconnected
+  std::map<std::pair<RTT::TaskContext*, RTT::TaskContext*>, bool>::iterator removed_it =
+    removed_latches_.find(std::make_pair(source, sink));
+  if(removed_it != removed_latches_.end()) {
+    removed_it->second = latch;
+  } else if(!edge_found && edit_depth_ == 0 && strict) {
+    // Only error if strict
+    RTT::log(RTT::Error) << "Tried to " << 
+      ((latch) ? ("latch") : ("un_latch"))
+      << " a non-existent connection." <<
+      RTT::endlog();
+    return false;
+  }
+
+  return true;
+}
+
+bool Scheme::latchInputs(const std::string &sink_name, const bool latch)
+{
+  std::vector<std::string> sources, sinks;
+
+  // Get the sources (all blocks)
+  this->getBlocks(sources);
+  // Get the sinks (potentially a group)
+  this->getGroupMembers(sink_name, sinks);
+  
+  // Set latching flags for all vertices
+  for(std::vector<std::string>::const_iterator it=sinks.begin();
+      it != sinks.end();
+      ++it)
+  {
+    blocks_[*it]->latched_input = latch;
+  }
+
+  return this->latchConnections(sources, sinks, latch);
+}
+
+bool Scheme::latchInputs(RTT::TaskContext *block, const bool latch)
+{
+  return block && this->latchInputs(block->getName(), latch);
+}
+
+bool Scheme::latchOutputs(const std::string &source_name, const bool latch)
+{
+  std::vector<std::string> sources, sinks;
+
+  // Get the sources (potentially a group)
+  this->getGroupMembers(source_name, sources);
+  // Get the sinks (all blocks)
+  this->getBlocks(sinks);
+  
+  // Set latching flags for all vertices
+  for(std::vector<std::string>::const_iterator it=sources.begin();
+      it != sources.end();
+      ++it)
+  {
+    blocks_[*it]->latched_output = latch;
+  }
+
+  return this->latchConnections(sources, sinks, latch);
+}
+
+bool Scheme::latchOutputs(RTT::TaskContext *source, const bool latch)
+{
+  return source && this->latchOutputs(source->getName(), latch);
+}
+
+//! A weighted arc between two vertices of a strongly-connected component
+struct ComponentArc
+{
+  int source;
+  int sink;
+  int weight;
+
+  ComponentArc(int source_, int sink_, int weight_) :
+    source(source_), sink(sink_), weight(weight_) { }
+
+  //! Comparison used to order arcs from heaviest to lightest
+  static bool Heavier(const ComponentArc &a, const ComponentArc &b) {
+    return a.weight > b.weight;
+  }
+};
+
+/** \brief Order the vertices of a component with the Eades-Lin-Smyth heuristic
+ *
+ * Sinks are repeatedly moved to the end of the ordering and sources to the
+ * front. When neither exist, the vertex with the largest difference between
+ * its outgoing and incoming arc weights is moved to the front. Arcs which point
+ * backwards in the resulting ordering form a feedback arc set.
+ */
+static void EadesLinSmythOrdering(
+    const int n_vertices,
+    const std::vector<ComponentArc> &arcs,
+    std::vector<int> &positions)
+{
+  std::vector<int> in_weight(n_vertices, 0), out_weight(n_vertices, 0);
+  std::vector<std::vector<int> > in_arcs(n_vertices), out_arcs(n_vertices);
+  std::vector<bool> removed(n_vertices, false);
+
+  for(size_t a=0; a < arcs.size(); a++) {
+    out_weight[arcs[a].source] += arcs[a].weight;
+    in_weight[arcs[a].sink] += arcs[a].weight;
+    out_arcs[arcs[a].source].push_back(a);
+    in_arcs[arcs[a].sink].push_back(a);
+  }
+
+  std::vector<int> head, tail;
+  int n_remaining = n_vertices;
+
+  while(n_remaining > 0) {
+    // Pick the next vertex to move
+    int next = -1;
+    bool to_tail = false;
+    int max_delta = std::numeric_limits<int>::min();
+
+    for(int v=0; v < n_vertices; v++) {
+      if(removed[v]) {
+        continue;
+      }
+
+      // Sinks go to the back
+      if(out_weight[v] == 0) {
+        next = v;
+        to_tail = true;
+        break;
+      }
+
+      // Sources go to the front, followed by the vertex with the largest delta
+      const int delta = (in_weight[v] == 0) ?
+        std::numeric_limits<int>::max() :
+        out_weight[v] - in_weight[v];
+
+      if(next < 0 || delta > max_delta) {
+        next = v;
+        max_delta = delta;
+      }
+    }
+
+    if(to_tail) {
+      tail.push_back(next);
+    } else {
+      head.push_back(next);
+    }
+
+    // Remove the vertex and its arcs
+    removed[next] = true;
+    n_remaining--;
+
+    for(std::vector<int>::const_iterator it = out_arcs[next].begin();
+        it != out_arcs[next].end();
+        ++it)
+    {
+      in_weight[arcs[*it].sink] -= arcs[*it].weight;
+    }
+    for(std::vector<int>::const_iterator it = in_arcs[next].begin();
+        it != in_arcs[next].end();
+        ++it)
+    {
+      out_weight[arcs[*it].source] -= arcs[*it].weight;
+    }
+  }
+
+  // The ordering is the head followed by the reversed tail
+  head.insert(head.end(), tail.rbegin(), tail.rend());
+
+  positions.resize(n_vertices);
+  for(size_t p=0; p < head.size(); p++) {
+    positions[head[p]] = p;
+  }
+}
+
+//! Check if \p target can be reached from \p source along the given arcs
+static bool ComponentPathExists(
+    const int source,
+    const int target,
+    const std::vector<std::vector<int> > &successors)
+{
+  std::vector<bool> visited(successors.size(), false);
+  std::vector<int> stack(1, source);
+
+  while(!stack.empty()) {
+    const int v = stack.back();
+    stack.pop_back();
+
+    if(v == target) {
+      return true;
+    }
+    if(visited[v]) {
+      continue;
+    }
+    visited[v] = true;
+    stack.insert(stack.end(), successors[v].begin(), successors[v].end());
+  }
+
+  return false;
+}
+
+int Scheme::proposeLatches(
+    std::vector<std::string> &sources,
+    std::vector<std::string> &sinks,
+    const conman::LatchCost::Mode cost)
+  const
+{
+  using namespace conman::graph;
+
+  RTT::Logger::In in("Scheme::proposeLatches");
+
+  sources.clear();
+  sinks.clear();
+
+  // Assign contiguous indices to the ESG vertices
+  std::vector<DataFlowVertexDescriptor> vertices;
+  std::map<DataFlowVertexDescriptor, int> vertex_indices;
+
+  ExecutionVertexIterator vert_it, vert_end;
+  for(boost::tie(vert_it, vert_end) = boost::vertices(exec_graph_);
+      vert_it != vert_end;
+      ++vert_it)
+  {
+    vertex_indices[*vert_it] = vertices.size();
+    vertices.push_back(*vert_it);
+  }
+
+  // Partition the ESG into strongly-connected components
+  std::map<DataFlowVertexDescriptor, int> components;
+  const int n_components = boost::strong_components(
+      exec_graph_,
+      boost::make_assoc_property_map(components),
+      boost::vertex_index_map(boost::make_assoc_property_map(vertex_indices)));
+
+  // Assign indices to the vertices within each component
+  std::vector<int> component_sizes(n_components, 0), local_indices(vertices.size());
+  std::vector<std::vector<DataFlowVertexDescriptor> > component_vertices(n_components);
+
+  for(size_t v=0; v < vertices.size(); v++) {
+    const int c = components[vertices[v]];
+    local_indices[v] = component_sizes[c]++;
+    component_vertices[c].push_back(vertices[v]);
+  }
+
+  // Collect the weighted arcs inside each component (self-loops are implicitly
+  // latched)
+  std::vector<std::vector<ComponentArc> > component_arcs(n_components);
+
+  for(size_t v=0; v < vertices.size(); v++) {
+    ExecutionOutEdgeIterator out_edge_it, out_edge_end;
+    for(boost::tie(out_edge_it, out_edge_end) = boost::out_edges(vertices[v], exec_graph_);
+        out_edge_it != out_edge_end;
+        ++out_edge_it)
+    {
+      const int sink = vertex_indices[boost::target(*out_edge_it, exec_graph_)];
+      const int c = components[vertices[v]];
+
+      if(sink == int(v) || components[vertices[sink]] != c) {
+        continue;
+      }
+
+      int weight = 1;
+      if(cost == LatchCost::CONNECTIONS) {
+        weight = std::max(1, static_cast<int>(exec_graph_[*out_edge_it]->connections.size()));
+      }
+
+      component_arcs[c].push_back(ComponentArc(local_indices[v], local_indices[sink], weight));
+    }
+  }
+
+  // Compute a feedback arc set for each non-trivial component
+  for(int c=0; c < n_components; c++) {
+    if(component_sizes[c] < 2) {
+      continue;
+    }
+
+    const std::vector<ComponentArc> &arcs = component_arcs[c];
+
+    std::vector<int> positions;
+    EadesLinSmythOrdering(component_sizes[c], arcs, positions);
+
+    // Split the arcs into forward arcs and backward (feedback) arcs
+    std::vector<std::vector<int> > successors(component_sizes[c]);
+    std::vector<ComponentArc> feedback_arcs;
+
+    for(std::vector<ComponentArc>::const_iterator it = arcs.begin();
+        it != arcs.end();
+        ++it)
+    {
+      if(positions[it->source] < positions[it->sink]) {
+        successors[it->source].push_back(it->sink);
+      } else {
+        feedback_arcs.push_back(*it);
+      }
+    }
+
+    // Restore the most expensive feedback arcs which don't close a cycle
+    std::stable_sort(feedback_arcs.begin(), feedback_arcs.end(), ComponentArc::Heavier);
+
+    for(std::vector<ComponentArc>::const_iterator it = feedback_arcs.begin();
+        it != feedback_arcs.end();
+        ++it)
+    {
+      if(!ComponentPathExists(it->sink, it->source, successors)) {
+        successors[it->source].push_back(it->sink);
+      } else {
+        sources.push_back(exec_graph_[component_vertices[c][it->source]]->block->getName());
+        sinks.push_back(exec_graph_[component_vertices[c][it->sink]]->block->getName());
+      }
+    }
+  }
+
+  return sources.size();
+}
+
+int Scheme::autoLatch(const conman::LatchCost::Mode cost, const bool apply)
+{
+  RTT::Logger::In in("Scheme::autoLatch");
+
+  std::vector<std::string> sources, sinks;
+  const int n_latches = this->proposeLatches(sources, sinks, cost);
+
+  for(int i=0; i < n_latches; i++) {
+    RTT::log(RTT::Info) << "Proposed latch: \"" << sources[i] << "\" -> \""
+      << sinks[i] << "\"" << RTT::endlog();
+  }
+
+  if(apply && n_latches > 0) {
+    // Apply all of the latches before regenerating the model, since the
+    // scheme is only acyclic once all of them are applied
+    if(!this->beginEdit()) {
+      return -1;
+    }
+
+    for(int i=0; i < n_latches; i++) {
+      if(!this->latchConnections(sources[i], sinks[i], true)) {
+        RTT::log(RTT::Error) << "Could not apply latch \"" << sources[i] <<
+          "\" -> \"" << sinks[i] << "\"" << RTT::endlog();
+        this->commit();
+        return -1;
+      }
+    }
+
+    if(!this->commit()) {
+      RTT::log(RTT::Error) << "Could not regenerate the model after applying the latches." << RTT::endlog();
+      return -1;
+    }
+  }
+
+  return n_latches;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int Scheme::latchCount(
+    const std::vector<std::string> &path)
+  const
+{
+  using namespace conman::graph;
+
+  // If there are fewer than two vertices, there are no edges on the path
+  if(path.size() < 2) {
+    return 0;
+  }
+
+  // Resolve the path elements to vertex indices
+  std::vector<unsigned int> index_path;
+  index_path.reserve(path.size());
+
+  for(std::vector<std::string>::const_iterator name_it = path.begin();
+      name_it != path.end();
+      ++name_it)
+  {
+    std::map<std::string, DataFlowVertex::Ptr>::const_iterator block =
+      blocks_.find(*name_it);
+
+    // Make sure the blocks are valid
+    if(block == blocks_.end()) {
+      RTT::log(RTT::Error) << "Could not compute latch count because path"
+        " elements aren't in the graph." << RTT::endlog();
+      return 0;
+    }
+
+    index_path.push_back(block->second->index);
+  }
+
+  return this->latchCount(index_path);
+}
+
+int Scheme::latchCount(
+    const std::vector<unsigned int> &path)
+  const
+{
+  // If there are fewer than two vertices, there are no edges on the path
+  if(path.size() < 2) {
+    return 0;
+  }
+
+  const LatchAnalysis &analysis = this->getLatchAnalysis();
+  const size_t n_blocks = analysis.vertices.size();
+
+  int latch_count = 0;
+
+  // Iterate over pairs of vertices
+  for(size_t i=1; i < path.size(); i++) {
+    const unsigned int source = path[i-1], sink = path[i];
+
+    // Make sure the blocks are valid
+    if(source >= n_blocks || sink >= n_blocks) {
+      RTT::log(RTT::Error) << "Could not compute latch count because path"
+        " elements aren't in the graph." << RTT::endlog();
+      return 0;
+    }
+
+    // Get the arc between these blocks
+    switch(analysis.arcs[source*n_blocks + sink]) {
+      case ARC_NONE:
+        RTT::log(RTT::Error) << "Could not compute latch count because path"
+          " elements aren't connected." << RTT::endlog();
+        return 0;
+      case ARC_LATCHED:
+        latch_count++;
+        break;
+      default:
+        break;
+    }
+  }
+
+  return latch_count;
+}
+
+int Scheme::maxLatchCount() const
+{
+  return this->getLatchAnalysis().max_latch_count;
+}
+
+int Scheme::minLatchCount() const
+{
+  return this->getLatchAnalysis().min_latch_count;
+}
+
+unsigned long Scheme::getModelVersion() const
+{
+  return model_version_;
+}
+
+const Scheme::LatchAnalysis& Scheme::getLatchAnalysis() const
+{
+  using namespace conman::graph;
+
+  LatchAnalysis &analysis = latch_analysis_;
+
+  // Only recompute the analysis if the model has changed
+  if(analysis.model_version == model_version_) {
+    return analysis;
+  }
+
+  RTT::log(RTT::Debug) << "Recomputing latch analysis for model version "
+    << model_version_ << RTT::endlog();
+
+  // Get the blocks by vertex index
+  const size_t n_blocks = block_indices_.size();
+  analysis.vertices.assign(block_indices_.begin(), block_indices_.end());
+
+  // Store the state of each arc in the DFG
+  analysis.arcs.assign(n_blocks * n_blocks, ARC_NONE);
+
+  DataFlowVertexIterator vert_it, vert_end;
+  for(boost::tie(vert_it, vert_end) = boost::vertices(flow_graph_);
+      vert_it != vert_end;
+      ++vert_it)
+  {
+    const unsigned int source = flow_graph_[*vert_it]->index;
+
+    DataFlowOutEdgeIterator out_edge_it, out_edge_end;
+    for(boost::tie(out_edge_it, out_edge_end) = boost::out_edges(*vert_it, flow_graph_);
+        out_edge_it != out_edge_end;
+        ++out_edge_it)
+    {
+      const unsigned int sink = flow_graph_[boost::target(*out_edge_it, flow_graph_)]->index;
+      analysis.arcs[source*n_blocks + sink] =
+        (flow_graph_[*out_edge_it]->latched) ? ARC_LATCHED : ARC_UNLATCHED;
+    }
+  }
+
+  // Compute all the cycles in the DFG
+  std::vector<DataFlowPath> cycles;
+  this->computeCycles(flow_graph_, cycles);
+
+  analysis.cycles.resize(cycles.size());
+  analysis.latch_counts.resize(cycles.size());
+
+  // Mark the analysis as valid before counting latches, since that uses it
+  analysis.model_version = model_version_;
+
+  for(size_t c=0; c < cycles.size(); c++) {
+    std::vector<unsigned int> &cycle = analysis.cycles[c];
+    cycle.clear();
+    cycle.reserve(cycles[c].size());
+
+    for(DataFlowPath::const_iterator v_it=cycles[c].begin();
+        v_it != cycles[c].end();
+        ++v_it) 
+    {
+      cycle.push_back(flow_graph_[*v_it]->index);
+    }
+
+    // Count the latches along the cycle, including the closing arc
+    std::vector<unsigned int> closed_path;
+    if(cycle.size() >= 2) {
+      closed_path.push_back(cycle.back());
+      closed_path.push_back(cycle.front());
+    }
+
+    analysis.latch_counts[c] = this->latchCount(cycle) + this->latchCount(closed_path);
+  }
+
+  // Compute the latch count extrema
+  if(analysis.latch_counts.empty()) {
+    analysis.min_latch_count = 0;
+    analysis.max_latch_count = 0;
+  } else {
+    analysis.min_latch_count = *std::min_element(analysis.latch_counts.begin(), analysis.latch_counts.end());
+    analysis.max_latch_count = *std::max_element(analysis.latch_counts.begin(), analysis.latch_counts.end());
+  }
+
+  return analysis;
+}
+
+int Scheme::getFlowCycles(
+    std::vector<std::vector<std::string> > &cycle_strs)
+  const
+{
+  const LatchAnalysis &analysis = this->getLatchAnalysis();
+
+  // Clear cycle component names
+  cycle_strs.clear();
+  cycle_strs.resize(analysis.cycles.size());
+
+  // Copy the names of the components associated with the verticies for each
+  // cycle
+  for(size_t c=0; c < analysis.cycles.size(); c++) {
+    for(std::vector<unsigned int>::const_iterator v_it=analysis.cycles[c].begin();
+        v_it != analysis.cycles[c].end();
+        ++v_it) 
+    {
+      cycle_strs[c].push_back(analysis.vertices[*v_it]->block->getName());
+    }
+  }
+
+  return cycle_strs.size();
+}
+
+int Scheme::computeCycles(
+    const conman::graph::DataFlowGraph &data_flow_graph,
+    std::vector<conman::graph::DataFlowPath> &cycles)
+  const
+{
+  using namespace conman::graph;
+
+  // Clear the output variable
+  cycles.clear();
+
+  // Construct a cycle visitor for extracting cycles
+  FlowCycleVisitor visitor(cycles);
+
+  try {
+    // Find all cycles 
+#ifdef USE_HAWICK
+    boost::hawick_circuits( data_flow_graph, visitor);
+#else
+    boost::tiernan_all_cycles( data_flow_graph, visitor);
+#endif
+  } catch( std::runtime_error &ex) {
+    RTT::log(RTT::Error) << "Could not compute cycles for data flow graph." <<
+      RTT::endlog();
+    return 0;
+  }
+
+  return cycles.size();
+}
+
+/** \brief Reorder a topological ordering to keep consumers near their producers
+ *
+ * This is a list scheduling pass over the ESG: among all of the blocks whose
+ * producers have already been scheduled, it always picks the one which became
+ * ready most recently, so a block tends to run right after the last block
+ * which writes to it, while its data is still in the cache. Ties are broken by
+ * the position in the given ordering, so the result is deterministic.
+ *
+ * Additional (before, after) precedences can also be given. If they can't be
+ * satisfied along with the ESG, the ordering is left unchanged and this
+ * returns false, so they should be checked with MustPrecede() first.
+ */
+static bool LocalityOrdering(
+    const conman::graph::ExecutionGraph &exec_graph,
+    conman::graph::ExecutionOrdering &ordering,
+    const std::vector<std::pair<conman::graph::DataFlowVertexDescriptor, conman::graph::DataFlowVertexDescriptor> > &precedences)
+{
+  using namespace conman::graph;
+
+  // Index the vertices by their position in the given ordering
+  std::vector<DataFlowVertexDescriptor> vertices(ordering.begin(), ordering.end());
+  std::map<DataFlowVertexDescriptor, int> positions;
+  for(size_t v=0; v < vertices.size(); v++) {
+    positions[vertices[v]] = v;
+  }
+
+  // Count the unscheduled producers of each block
+  std::vector<int> in_degrees(vertices.size(), 0);
+  for(size_t v=0; v < vertices.size(); v++) {
+    ExecutionOutEdgeIterator out_edge_it, out_edge_end;
+    for(boost::tie(out_edge_it, out_edge_end) = boost::out_edges(vertices[v], exec_graph);
+        out_edge_it != out_edge_end;
+        ++out_edge_it)
+    {
+      in_degrees[positions[boost::target(*out_edge_it, exec_graph)]]++;
+    }
+  }
+
+  // Count the additional precedences
+  std::vector<std::vector<int> > successors(vertices.size());
+  for(size_t p=0; p < precedences.size(); p++) {
+    const int after = positions[precedences[p].second];
+    successors[positions[precedences[p].first]].push_back(after);
+    in_degrees[after]++;
+  }
+
+  // Ready blocks keyed by (minus) the slot at which they became ready
+  std::set<std::pair<int, int> > ready;
+  for(size_t v=0; v < vertices.size(); v++) {
+    if(in_degrees[v] == 0) {
+      ready.insert(std::make_pair(0, v));
+    }
+  }
+
+  ExecutionOrdering scheduled;
+
+  for(int slot = 1; !ready.empty(); slot++) {
+    const int v = ready.begin()->second;
+    ready.erase(ready.begin());
+    scheduled.push_back(vertices[v]);
+
+    // Release the consumers of this block
+    ExecutionOutEdgeIterator out_edge_it, out_edge_end;
+    for(boost::tie(out_edge_it, out_edge_end) = boost::out_edges(vertices[v], exec_graph);
+        out_edge_it != out_edge_end;
+        ++out_edge_it)
+    {
+      const int sink = positions[boost::target(*out_edge_it, exec_graph)];
+      if(--in_degrees[sink] == 0) {
+        ready.insert(std::make_pair(-slot, sink));
+      }
+    }
+
+    // Release the blocks which need to run after this block
+    for(std::vector<int>::const_iterator it = successors[v].begin();
+        it != successors[v].end();
+        ++it)
+    {
+      if(--in_degrees[*it] == 0) {
+        ready.insert(std::make_pair(-slot, *it));
+      }
+    }
+  }
+
+  // Check if the precedences formed a cycle
+  if(scheduled.size() != vertices.size()) {
+    return false;
+  }
+
+  ordering.swap(scheduled);
+
+  return true;
+}
+
+/** \brief Check if one block needs to run before another
+ *
+ * This is true if there is a path from the first block to the second through
+ * the ESG or the given additional (before, after) precedences.
+ */
+static bool MustPrecede(
+    const conman::graph::ExecutionGraph &exec_graph,
+    const std::vector<std::pair<conman::graph::DataFlowVertexDescriptor, conman::graph::DataFlowVertexDescriptor> > &precedences,
+    const conman::graph::DataFlowVertexDescriptor first,
+    const conman::graph::DataFlowVertexDescriptor second)
+{
+  using namespace conman::graph;
+
+  std::set<DataFlowVertexDescriptor> visited;
+  std::vector<DataFlowVertexDescriptor> frontier(1, first);
+
+  while(!frontier.empty()) {
+    const DataFlowVertexDescriptor v = frontier.back();
+    frontier.pop_back();
+
+    if(v == second) {
+      return true;
+    }
+
+    if(!visited.insert(v).second) {
+      continue;
+    }
+
+    ExecutionOutEdgeIterator out_edge_it, out_edge_end;
+    for(boost::tie(out_edge_it, out_edge_end) = boost::out_edges(v, exec_graph);
+        out_edge_it != out_edge_end;
+        ++out_edge_it)
+    {
+      frontier.push_back(boost::target(*out_edge_it, exec_graph));
+    }
+
+    for(size_t p=0; p < precedences.size(); p++) {
+      if(precedences[p].first == v) {
+        frontier.push_back(precedences[p].second);
+      }
+    }
+  }
+
+  return false;
+}
+
+bool Scheme::computeSchedule(
+    const conman::graph::ExecutionGraph &exec_graph,
+    conman::graph::ExecutionOrdering &ordering, 
+    const bool quiet)
+  const
+{
+  using namespace conman::graph;
+
+  // Clear the ordering
+  ordering.clear();
+
+  try{
+    // Recompute the topological sort
+    // NOTE: We need to use an external vertex index property for this
+    // algorithm to work since our adjacency_list uses a list as the underlying
+    // vertex data structure. See the documentation for DataFlowVertexIndex for
+    // more info.
+    boost::topological_sort( 
+        exec_graph, 
+        std::front_inserter(ordering));/**,
+        boost::vertex_index_map(
+            boost::make_function_property_map<DataFlowVertexDescriptor>(
+                boost::bind(&DataFlowVertexIndex,_1,exec_graph))));**/
+
+    // Run the sink of each latched connection before its source, so that it
+    // reads the sample written in the previous cycle. Each precedence is only
+    // added if the source doesn't already need to run before the sink, so the
+    // precedences which can't be satisfied don't affect the others.
+    std::vector<std::pair<DataFlowVertexDescriptor, DataFlowVertexDescriptor> > latch_precedences;
+    size_t n_undelayed = 0;
+    DataFlowEdgeIterator edge_it, edge_end;
+    for(boost::tie(edge_it, edge_end) = boost::edges(flow_graph_);
+        edge_it != edge_end;
+        ++edge_it)
+    {
+      const DataFlowVertexDescriptor
+        source = boost::source(*edge_it, flow_graph_),
+        sink = boost::target(*edge_it, flow_graph_);
+
+      if(!flow_graph_[*edge_it]->latched || source == sink) {
+        continue;
+      }
+
+      if(MustPrecede(exec_graph, latch_precedences, source, sink)) {
+        n_undelayed++;
+      } else {
+        latch_precedences.push_back(std::make_pair(sink, source));
+      }
+    }
+
+    if(n_undelayed > 0 && !quiet) {
+      RTT::log(RTT::Warning) << n_undelayed << " latched connections will be "
+        "read in the same cycle they are written, since their sinks depend on "
+        "their sources through unlatched connections." << RTT::endlog();
+    }
+
+    // Choose the valid ordering which keeps consumers near their producers
+    LocalityOrdering(exec_graph, ordering, latch_precedences);
+
+  } catch(std::exception &ex) {
+    // Complain unless quiet flag is true
+    if(!quiet) {
+      RTT::log(RTT::Error)
+        << "Cannot regenerate topological ordering in conman scheme because: "
+        << ex.what() << RTT::endlog();
+    }
+    return false;
+  }
+
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Scheme::latchesDelayed() const
+{
+  using namespace conman::graph;
+
+  // Check if the current ordering is valid
+  if(exec_ordering_version_ != model_version_) {
+    return false;
+  }
+
+  // Get the position of each block in the ordering
+  std::map<DataFlowVertexDescriptor, size_t> positions;
+  size_t position = 0;
+  for(ExecutionOrdering::const_iterator it = exec_ordering_.begin();
+      it != exec_ordering_.end();
+      ++it)
+  {
+    positions[*it] = position++;
+  }
+
+  // Check if each latched sink runs before its source
+  DataFlowEdgeIterator edge_it, edge_end;
+  for(boost::tie(edge_it, edge_end) = boost::edges(flow_graph_);
+      edge_it != edge_end;
+      ++edge_it)
+  {
+    const DataFlowVertexDescriptor
+      source = boost::source(*edge_it, flow_graph_),
+      sink = boost::target(*edge_it, flow_graph_);
+
+    if(flow_graph_[*edge_it]->latched && positions[sink] > positions[source]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool Scheme::checkLatchDelayed(
+    RTT::TaskContext *source,
+    RTT::TaskContext *sink) const
+{
+  using namespace conman::graph;
+
+  if(!source || !sink || source == sink) {
+    return true;
+  }
+
+  DataFlowVertexTaskMap::const_iterator
+    source_it = flow_vertex_map_.find(source),
+    sink_it = flow_vertex_map_.find(sink);
+
+  if(source_it == flow_vertex_map_.end() || sink_it == flow_vertex_map_.end()) {
+    return true;
+  }
+
+  // Only latched connections are delayed
+  DataFlowEdgeDescriptor edge;
+  bool edge_found;
+  boost::tie(edge, edge_found) = boost::edge(source_it->second, sink_it->second, flow_graph_);
+
+  if(!edge_found || !flow_graph_[edge]->latched) {
+    return true;
+  }
+
+  // The delay can only be checked if there is a current ordering
+  if(exec_ordering_version_ != model_version_ || exec_ordering_.size() != block_indices_.size()) {
+    return true;
+  }
+
+  // Check if the source runs before the sink
+  const ExecutionOrdering::const_iterator sink_pos =
+    std::find(exec_ordering_.begin(), exec_ordering_.end(), sink_it->second);
+
+  if(std::find(exec_ordering_.begin(), sink_pos, source_it->second) == sink_pos) {
+    return true;
+  }
+
+  RTT::log(RTT::Error) << "The latch from \"" << source->getName() << "\" to \""
+    << sink->getName() << "\" can't delay its connections by a cycle, since \""
+    << sink->getName() << "\" depends on \"" << source->getName()
+    << "\" through unlatched connections." << RTT::endlog();
+
+  return false;
+}
+
+bool Scheme::executable() const
+{
+  using namespace conman::graph;
+
+  // Compute the schedule on a throw-away ordering
+  ExecutionOrdering ordering;
+  return this->computeSchedule(exec_graph_, ordering, true);
+}
+
+int Scheme::getExecutionCycles(
+    std::vector<std::vector<std::string> > &cycle_strs)
+  const
+{
+  // The cycles in the ESG are exactly the cycles in the DFG without latches
+  const LatchAnalysis &analysis = this->getLatchAnalysis();
+
+  cycle_strs.clear();
+
+  // Copy the names of the components associated with the verticies for each
+  // cycle
+  for(size_t c=0; c < analysis.cycles.size(); c++) {
+    if(analysis.latch_counts[c] > 0) {
+      continue;
+    }
+
+    cycle_strs.push_back(std::vector<std::string>());
+
+    for(std::vector<unsigned int>::const_iterator v_it=analysis.cycles[c].begin();
+        v_it != analysis.cycles[c].end();
+        ++v_it) 
+    {
+      cycle_strs.back().push_back(analysis.vertices[*v_it]->block->getName());
+    }
+  }
+
+  return cycle_strs.size();
+}
+
+bool Scheme::getExecutionOrder(std::vector<std::string> &order) const
+{
+  // Check if the current ordering is valid (this doesn't recompute the
+  // schedule like executable() does, since that allocates)
+  if(exec_ordering_version_ != model_version_ || exec_ordering_.size() != block_indices_.size()) {
+    order.clear();
+    return false;
+  }
+
+  // Fill the order in place so that the strings' storage is reused
+  order.resize(exec_ordering_.size());
+
+  std::vector<std::string>::iterator str_it = order.begin();
+  for(conman::graph::ExecutionOrdering::const_iterator it = exec_ordering_.begin();
+      it != exec_ordering_.end();
+      ++it, ++str_it)
+  {
+    str_it->assign(exec_graph_[*it]->block->getName());
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+conman::SchemeFork Scheme::fork() const
+{
+  using namespace conman::graph;
+
+  // Serialize concurrent forks, which share the cached model
+  RTT::os::MutexLock lock(fork_mutex_);
+
+  // Only copy the model if it changed since it was last forked
+  if(!fork_model_ || fork_model_version_ != model_version_ || fork_model_->groups != block_groups_) {
+    SchemeFork::Model::Ptr model = boost::make_shared<SchemeFork::Model>();
+
+    // Copy the blocks in index order
+    std::map<RTT::TaskContext*, unsigned int> indices;
+    for(std::vector<DataFlowVertex::Ptr>::const_iterator it = block_indices_.begin();
+        it != block_indices_.end();
+        ++it)
+    {
+      indices[(*it)->block] = model->vertices.size();
+      model->indices[(*it)->block->getName()] = model->vertices.size();
+      model->vertices.push_back(*it);
+    }
+
+    // Copy the DFG arcs and the RCG adjacencies
+    model->conflicts.resize(model->vertices.size());
+
+    for(size_t i=0; i < model->vertices.size(); i++) {
+      RTT::TaskContext *block = model->vertices[i]->block;
+
+      DataFlowVertexTaskMap::const_iterator flow_vertex_it = flow_vertex_map_.find(block);
+      if(flow_vertex_it != flow_vertex_map_.end()) {
+        DataFlowOutEdgeIterator out_edge_it, out_edge_end;
+        for(boost::tie(out_edge_it, out_edge_end) = boost::out_edges(flow_vertex_it->second, flow_graph_);
+            out_edge_it != out_edge_end;
+            ++out_edge_it)
+        {
+          const DataFlowEdge::Ptr edge = flow_graph_[*out_edge_it];
+
+          SchemeFork::Model::Arc arc;
+          arc.source = i;
+          arc.sink = indices[flow_graph_[boost::target(*out_edge_it, flow_graph_)]->block];
+          arc.latched = edge->latched;
+          arc.connections = edge->connections;
+          model->arcs.push_back(arc);
+        }
+      }
+
+      if(model->vertices[i]->index < conflict_matrix_.size()) {
+        const ConflictSet &row = conflict_matrix_[model->vertices[i]->index];
+        for(ConflictSet::size_type c = row.find_first(); c != ConflictSet::npos; c = row.find_next(c)) {
+          model->conflicts[i].insert(c);
+        }
+      }
+    }
+
+    model->groups = block_groups_;
+
+    fork_model_ = model;
+    fork_model_version_ = model_version_;
+  }
+
+  // The enabled blocks are the running blocks
+  std::vector<bool> enabled(fork_model_->vertices.size());
+  for(size_t i=0; i < enabled.size(); i++) {
+    enabled[i] = fork_model_->vertices[i]->block->isRunning();
+  }
+
+  return SchemeFork(fork_model_, enabled);
+}
+
+bool Scheme::modifyFork(
+    conman::SchemeFork &fork,
+    const std::vector<std::string> &add_blocks,
+    const std::vector<std::string> &latch_sources,
+    const std::vector<std::string> &latch_sinks) const
+{
+  RTT::Logger::In in("Scheme::modifyFork");
+
+  if(latch_sources.size() != latch_sinks.size()) {
+    RTT::log(RTT::Error) << "There are " << latch_sources.size() << " latch sources but "
+      << latch_sinks.size() << " latch sinks." << RTT::endlog();
+    return false;
+  }
+
+  for(std::vector<std::string>::const_iterator it = add_blocks.begin();
+      it != add_blocks.end();
+      ++it)
+  {
+    if(!fork.hasBlock(*it) && !fork.addBlock(this->getPeer(*it))) {
+      RTT::log(RTT::Error) << "Could not add \"" << *it << "\" to the fork." << RTT::endlog();
+      return false;
+    }
+  }
+
+  for(size_t i=0; i < latch_sources.size(); i++) {
+    if(!fork.latchConnections(latch_sources[i], latch_sinks[i], true)) {
+      RTT::log(RTT::Error) << "Could not latch \"" << latch_sources[i] << "\" -> \""
+        << latch_sinks[i] << "\" in the fork." << RTT::endlog();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool Scheme::whatIfExecutable(
+    const std::vector<std::string> &add_blocks,
+    const std::vector<std::string> &latch_sources,
+    const std::vector<std::string> &latch_sinks) const
+{
+  conman::SchemeFork fork = this->fork();
+
+  return this->modifyFork(fork, add_blocks, latch_sources, latch_sinks) && fork.executable();
+}
+
+std::vector<std::string> Scheme::whatIfExecutionOrder(
+    const std::vector<std::string> &add_blocks,
+    const std::vector<std::string> &latch_sources,
+    const std::vector<std::string> &latch_sinks) const
+{
+  std::vector<std::string> order;
+  conman::SchemeFork fork = this->fork();
+
+  if(!this->modifyFork(fork, add_blocks, latch_sources, latch_sinks) ||
+     !fork.getExecutionOrder(order))
+  {
+    order.clear();
+  }
+
+  return order;
+}
+
+std::vector<std::string> Scheme::whatIfEnableBlocks(
+    const std::vector<std::string> &enable_names,
+    const bool force) const
+{
+  conman::SchemeFork fork = this->fork();
+
+  for(std::vector<std::string>::const_iterator it = enable_names.begin();
+      it != enable_names.end();
+      ++it)
+  {
+    if(!fork.enableBlock(*it, force)) {
+      return std::vector<std::string>();
+    }
+  }
+
+  return fork.getEnabledBlocks();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void Scheme::computeConflicts() 
+{
+  std::map<std::string,graph::DataFlowVertex::Ptr>::iterator it;
+  for(it = blocks_.begin(); it != blocks_.end(); ++it) {
+    this->computeConflicts(it->second->block->getName());
+  }
+}
+
+void Scheme::computeConflicts(const std::string &block_name) 
+{
+  if(blocks_.find(block_name) != blocks_.end()) {
+    this->computeConflicts(blocks_[block_name]);
+  }
+}
+
+void Scheme::computeConflicts(const std::vector<std::string> &block_names)
+{
+  for(std::vector<std::string>::const_iterator it = block_names.begin();
+      it != block_names.end();
+      ++it)
+  {
+    this->computeConflicts(*it);
+  }
+}
+
+void Scheme::computeConflicts(conman::graph::DataFlowVertex::Ptr seed_vertex)
+{
+  using namespace conman::graph;
+
+  RTT::Logger::In in("Scheme::computeConflicts");
+
+  // The seed block is the block whose sinks we're inspecting for conflicts
+  // i.e. the seed block has output ports, this gets all of the input ports
+  // that those output ports connect to, and determines if there are other
+  // output ports which are connected to them. The seed block's own exclusive
+  // input ports are also inspected.
+  RTT::TaskContext *& seed_block = seed_vertex->block;
+
+  RTT::log(RTT::Debug) << "Computing conflicts for " << seed_block->getName() << "..." << RTT::endlog();
+
+  // Make sure the conflict matrix has a row and column for every block
+  const size_t n_blocks = block_indices_.size();
+  if(conflict_matrix_.size() != n_blocks) {
+    conflict_matrix_.resize(n_blocks);
+    for(ConflictMatrix::iterator row_it = conflict_matrix_.begin();
+        row_it != conflict_matrix_.end();
+        ++row_it)
+    {
+      ReserveBits(*row_it, max_blocks_);
+      row_it->resize(n_blocks);
+    }
+  }
+
+  if(flow_vertex_map_.find(seed_block) == flow_vertex_map_.end()) {
+    return;
+  }
+
+  // The exclusive input ports that the seed block writes to or owns
+  std::set<std::pair<DataFlowVertexDescriptor, const RTT::base::PortInterface*> > exclusive_sinks;
+
+  // Iterate over each data flow edge to the seed vertex, since its writers
+  // may have been added to the scheme before it was
+  DataFlowInEdgeIterator seed_in_edge_it, seed_in_edge_end;
+  for(boost::tie(seed_in_edge_it, seed_in_edge_end) = boost::in_edges(flow_vertex_map_[seed_block], flow_graph_);
+      seed_in_edge_it != seed_in_edge_end; 
+      ++seed_in_edge_it) 
+  {
+    const DataFlowEdge::Ptr in_edge = flow_graph_[*seed_in_edge_it];
+
+    for(std::vector<DataFlowEdge::Connection>::const_iterator in_conn_it = in_edge->connections.begin();
+        in_conn_it != in_edge->connections.end();
+        ++in_conn_it)
+    {
+      if(this->getInputExclusivity(seed_vertex, in_conn_it->sink_port) == conman::Exclusivity::EXCLUSIVE) {
+        exclusive_sinks.insert(std::make_pair(flow_vertex_map_[seed_block], in_conn_it->sink_port));
+      }
+    }
+  }
 
   // Iterate over each data flow edge from the seed vertex
+  DataFlowOutEdgeIterator out_edge_it, out_edge_end;
   for(boost::tie(out_edge_it, out_edge_end) = boost::out_edges(flow_vertex_map_[seed_block], flow_graph_);
       out_edge_it != out_edge_end; 
       ++out_edge_it) 
   {
-    // Get a reference to the output edge properties for convenience
-    const DataFlowEdge::Ptr out_edge = flow_graph_[*out_edge_it];
+    const DataFlowEdge::Ptr out_edge = flow_graph_[*out_edge_it];
+    const DataFlowVertexDescriptor sink_vertex_descriptor = boost::target(*out_edge_it, flow_graph_);
+    const DataFlowVertex::Ptr sink_vertex = flow_graph_[sink_vertex_descriptor];
+
+    // Only exclusive ports can induce conflicts
+    for(std::vector<DataFlowEdge::Connection>::const_iterator out_conn_it = out_edge->connections.begin();
+        out_conn_it != out_edge->connections.end();
+        ++out_conn_it)
+    {
+      if(this->getInputExclusivity(sink_vertex, out_conn_it->sink_port) == conman::Exclusivity::EXCLUSIVE) {
+        exclusive_sinks.insert(std::make_pair(sink_vertex_descriptor, out_conn_it->sink_port));
+      }
+    }
+  }
+
+  // All of the blocks which write to the same exclusive port conflict
+  for(std::set<std::pair<DataFlowVertexDescriptor, const RTT::base::PortInterface*> >::const_iterator sink_it = exclusive_sinks.begin();
+      sink_it != exclusive_sinks.end();
+      ++sink_it)
+  {
+    // Get the set of blocks which write to this port
+    ConflictSet writers(n_blocks);
+
+    DataFlowInEdgeIterator in_edge_it, in_edge_end;
+    for(boost::tie(in_edge_it, in_edge_end) = boost::in_edges(sink_it->first, flow_graph_);
+        in_edge_it != in_edge_end;
+        ++in_edge_it) 
+    {
+      const DataFlowEdge::Ptr in_edge = flow_graph_[*in_edge_it];
+
+      for(std::vector<DataFlowEdge::Connection>::const_iterator in_conn_it = in_edge->connections.begin();
+          in_conn_it != in_edge->connections.end();
+          ++in_conn_it)
+      {
+        if(in_conn_it->sink_port == sink_it->second) {
+          writers.set(flow_graph_[boost::source(*in_edge_it, flow_graph_)]->index);
+        }
+      }
+    }
+
+    // Each writer conflicts with every other writer
+    for(ConflictSet::size_type w = writers.find_first(); w != ConflictSet::npos; w = writers.find_next(w)) {
+      conflict_matrix_[w] |= writers;
+      conflict_matrix_[w].reset(w);
+    }
+
+    RTT::log(RTT::Debug) << " -- Added conflicts between " << writers.count() << " blocks because of port: "
+      << flow_graph_[sink_it->first]->block->getName() << "." << sink_it->second->getName() << RTT::endlog();
+  }
+}
+
+bool Scheme::checkPortContract(
+    const conman::graph::DataFlowVertex::Ptr &source_vertex,
+    const RTT::base::PortInterface *source_port,
+    const conman::graph::DataFlowVertex::Ptr &sink_vertex,
+    const RTT::base::PortInterface *sink_port,
+    const bool quiet)
+{
+  const std::string
+    source_path = ResolvePortPath(source_port),
+    sink_path = ResolvePortPath(sink_port);
+
+  // Check the dimensions if both ports declare them
+  const unsigned int
+    source_dim = source_vertex->hook->getPortDimension(source_path),
+    sink_dim = sink_vertex->hook->getPortDimension(sink_path);
+
+  if(source_dim > 0 && sink_dim > 0 && source_dim != sink_dim) {
+    if(quiet) {
+      return false;
+    }
+    RTT::log(RTT::Error) << "Rejecting connection "
+      << source_vertex->block->getName() << "." << source_path << " --> "
+      << sink_vertex->block->getName() << "." << sink_path << " because the "
+      "source has dimension " << source_dim << " but the sink has dimension "
+      << sink_dim << "." << RTT::endlog();
+    return false;
+  }
+
+  // Check the joint names if both ports declare them
+  const std::vector<std::string>
+    source_joints = source_vertex->hook->getPortJointNames(source_path),
+    sink_joints = sink_vertex->hook->getPortJointNames(sink_path);
+
+  if(!source_joints.empty() && !sink_joints.empty() && source_joints != sink_joints) {
+    if(quiet) {
+      return false;
+    }
+    RTT::log(RTT::Error) << "Rejecting connection "
+      << source_vertex->block->getName() << "." << source_path << " --> "
+      << sink_vertex->block->getName() << "." << sink_path << " because the "
+      "source and sink have different joint names." << RTT::endlog();
+    return false;
+  }
+
+  return true;
+}
+
+conman::Exclusivity::Mode Scheme::getInputExclusivity(
+    const conman::graph::DataFlowVertex::Ptr &sink_vertex,
+    const RTT::base::PortInterface *sink_port)
+{
+  std::map<const RTT::base::PortInterface*, conman::Exclusivity::Mode>::const_iterator mode_it =
+    input_exclusivity_.find(sink_port);
+
+  if(mode_it != input_exclusivity_.end()) {
+    return mode_it->second;
+  }
+
+  // Get the exclusivity from the sink block's hook
+  const conman::Exclusivity::Mode mode = sink_vertex->hook->getInputExclusivity(ResolvePortPath(sink_port));
+  input_exclusivity_[sink_port] = mode;
+
+  return mode;
+}
+
+bool Scheme::conflicting(
+    const conman::graph::DataFlowVertex::Ptr &first,
+    const conman::graph::DataFlowVertex::Ptr &second)
+  const
+{
+  return first->index < conflict_matrix_.size() 
+    && second->index < conflict_matrix_[first->index].size()
+    && conflict_matrix_[first->index].test(second->index);
+}
+
+void Scheme::cacheInputExclusivity(const conman::graph::DataFlowVertex::Ptr &vertex)
+{
+  std::vector<RTT::base::PortInterface*> ports;
+  GetAllPorts(vertex->block->provides(), ports);
+
+  for(std::vector<RTT::base::PortInterface*>::const_iterator port_it = ports.begin();
+      port_it != ports.end();
+      ++port_it)
+  {
+    if(dynamic_cast<const RTT::base::InputPortInterface*>(*port_it)) {
+      input_exclusivity_[*port_it] = vertex->hook->getInputExclusivity(ResolvePortPath(*port_it));
+    }
+  }
+}
+
+bool Scheme::getBlockSet(
+    const std::vector<std::string> &block_names,
+    conman::graph::ConflictSet &block_set) const
+{
+  using namespace conman::graph;
+
+  RTT::Logger::In in("Scheme::getBlockSet");
+
+  bool success = true;
+
+  block_set.clear();
+  block_set.resize(block_indices_.size());
+
+  for(std::vector<std::string>::const_iterator it = block_names.begin();
+      it != block_names.end();
+      ++it)
+  {
+    std::map<std::string,DataFlowVertex::Ptr>::const_iterator block_it = blocks_.find(*it);
+
+    if(block_it != blocks_.end()) {
+      block_set.set(block_it->second->index);
+    } else if(const GroupExpansion *expansion = this->expandGroup(*it)) {
+      // Add the members of the group
+      block_set |= expansion->blocks;
+    } else {
+      RTT::log(RTT::Error) << "No block or group named \"" << *it << "\" is in the scheme." << RTT::endlog();
+      success = false;
+    }
+  }
+
+  return success;
+}
+
+bool Scheme::getBlockSet(
+    const std::vector<conman::BlockID> &block_ids,
+    conman::graph::ConflictSet &block_set) const
+{
+  using namespace conman::graph;
+
+  bool success = true;
+
+  // This doesn't allocate if the set is already the right size
+  block_set.resize(block_indices_.size());
+  block_set.reset();
+
+  for(std::vector<conman::BlockID>::const_iterator it = block_ids.begin();
+      it != block_ids.end();
+      ++it)
+  {
+    if(*it < id_vertices_.size() && id_vertices_[*it]) {
+      block_set.set(id_vertices_[*it]->index);
+    } else if(const GroupExpansion *expansion = this->expandGroup(*it)) {
+      block_set |= expansion->blocks;
+    } else {
+      success = false;
+    }
+  }
+
+  return success;
+}
+
+conman::graph::ConflictSet Scheme::getConflictSet(
+    const conman::graph::ConflictSet &block_set) const
+{
+  conman::graph::ConflictSet conflict_set;
+
+  this->getConflictSet(block_set, conflict_set);
+
+  return conflict_set;
+}
+
+void Scheme::getConflictSet(
+    const conman::graph::ConflictSet &block_set,
+    conman::graph::ConflictSet &conflict_set) const
+{
+  using namespace conman::graph;
+
+  conflict_set.resize(block_set.size());
+  conflict_set.reset();
+
+  for(ConflictSet::size_type b = block_set.find_first(); b != ConflictSet::npos; b = block_set.find_next(b)) {
+    if(b < conflict_matrix_.size() && conflict_matrix_[b].size() == conflict_set.size()) {
+      conflict_set |= conflict_matrix_[b];
+    }
+  }
+}
+
+void Scheme::updateRunningBlock(RTT::TaskContext *block)
+{
+  std::map<std::string,conman::graph::DataFlowVertex::Ptr>::const_iterator block_it = blocks_.find(block->getName());
+
+  if(block_it != blocks_.end() && block_it->second->index < running_blocks_.size()) {
+    running_blocks_[block_it->second->index] = block->isRunning();
+  }
+}
+
+void Scheme::syncRunningBlocks(const conman::graph::ConflictSet &block_set) const
+{
+  using namespace conman::graph;
+
+  for(ConflictSet::size_type b = block_set.find_first(); b != ConflictSet::npos; b = block_set.find_next(b)) {
+    if(b < running_blocks_.size() && b < block_indices_.size()) {
+      running_blocks_[b] = block_indices_[b]->block->isRunning();
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+const conman::graph::DataFlowVertex::Ptr Scheme::getBlockVertex(const std::string &name) const
+{
+  return blocks_.find(name)->second;
+}
+
+bool Scheme::addBlockToGraph(conman::graph::DataFlowVertex::Ptr new_vertex)
+{
+  using namespace conman::graph;
+
+  RTT::Logger::In in("Scheme::addBlockToGraph");
+
+  // Make sure the vertex isn't null
+  if(!new_vertex) {
+    RTT::log(RTT::Error) << "DataFlowVertex::Ptr is NULL." << RTT::endlog();
+    return false;
+  }
+
+  // Get a reference to the block pointer
+  TaskContext *&new_block = new_vertex->block;
+
+  // Make sure the block isn't null
+  if(new_block == NULL) {
+    RTT::log(RTT::Error) << "TaskContext is NULL." << RTT::endlog();
+    return false;
+  }
+
+  // Make sure the block has the conman hook service
+  if(!conman::Hook::HasHook(new_block)) {
+    RTT::log(RTT::Error) << "Requested block to add does not have the conman"
+      "hook service." << RTT::endlog();
+    return false;
+  }
+
+  // Add this block to the DFG (the ESG is a view of the DFG)
+  flow_vertex_map_[new_block] = boost::add_vertex(new_vertex, flow_graph_);
+  model_version_++;
+
+  RTT::log(RTT::Debug) << "Created vertex: "<< new_vertex->index << " (" <<
+    flow_vertex_map_[new_block] << ")" << RTT::endlog();
+
+  // Regenerate the topological ordering
+  if(!this->deferModelUpdate() && !this->regenerateModel()) {
+    // Report error if we can't regenerate the graphs
+    RTT::log(RTT::Warning) << "New block \"" << new_block->getName()
+      << "\" creates one or more cycles in the conman scheme." << RTT::endlog();
+
+    if(false) {
+      // Clean up this graph (but not the others, yet)
+      this->removeBlockFromGraph(new_vertex);
+
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/** \brief Remove a block index from a set of blocks
+ *
+ * The indices of the blocks after it are decremented, since they will be
+ * re-indexed.
+ */
+static void EraseBlockIndex(
+    conman::graph::ConflictSet &block_set,
+    const conman::graph::ConflictSet::size_type index)
+{
+  using namespace conman::graph;
+
+  if(index >= block_set.size()) {
+    return;
+  }
+
+  ConflictSet erased(block_set.size() - 1);
+  for(ConflictSet::size_type b = block_set.find_first(); b != ConflictSet::npos; b = block_set.find_next(b)) {
+    if(b != index) {
+      erased.set(b < index ? b : b - 1);
+    }
+  }
+  block_set.swap(erased);
+}
+
+bool Scheme::removeBlockFromGraph(conman::graph::DataFlowVertex::Ptr vertex)
+{
+  using namespace conman::graph;
+
+  RTT::Logger::In in("Scheme::removeBlockFromGraph");
+
+  // Succeed if the vertex already doesn't exist
+  if(flow_vertex_map_.find(vertex->block) == flow_vertex_map_.end()) {
+    return true;
+  }
+
+  // Restore the lock policies of this block's connections, since it will no
+  // longer be executed by the scheme
+  std::map<std::pair<RTT::base::PortInterface*, RTT::base::PortInterface*>, int>::iterator local_it =
+    local_lock_policies_.begin();
+  while(local_it != local_lock_policies_.end()) {
+    RTT::base::PortInterface
+      *source_port = local_it->first.first,
+      *sink_port = local_it->first.second;
+    ++local_it;
+
+    if(source_port->getInterface()->getOwner() == vertex->block ||
+       sink_port->getInterface()->getOwner() == vertex->block)
+    {
+      this->localizeConnection(source_port, sink_port, false);
+    }
+  }
+
+  // Forget the latches of this block's removed edges
+  std::map<std::pair<RTT::TaskContext*, RTT::TaskContext*>, bool>::iterator removed_it = removed_latches_.begin();
+  while(removed_it != removed_latches_.end()) {
+    if(removed_it->first.first == vertex->block || removed_it->first.second == vertex->block) {
+      removed_latches_.erase(removed_it++);
+    } else {
+      ++removed_it;
+    }
+  }
+
+  // Remove the edges, the vertex itself, and the reference in the flow map
+  // (this also removes them from the ESG view)
+  if(flow_vertex_map_.find(vertex->block) != flow_vertex_map_.end()) {
+    boost::clear_vertex(flow_vertex_map_[vertex->block], flow_graph_);
+    boost::remove_vertex(flow_vertex_map_[vertex->block], flow_graph_);
+    flow_vertex_map_.erase(vertex->block);
+
+    // Keep the graph's vertex indices contiguous, since the graph algorithms
+    // size their property maps by the number of vertices
+    flow_graph_.renumber_vertex_indices();
+  }
+
+  // Forget the modeled connections of this block's ports
+  std::vector<RTT::base::PortInterface*> ports;
+  GetAllPorts(vertex->block->provides(), ports);
+  for(std::vector<RTT::base::PortInterface*>::const_iterator port_it = ports.begin();
+      port_it != ports.end();
+      ++port_it)
+  {
+    port_peers_.erase(*port_it);
+    input_exclusivity_.erase(*port_it);
+  }
+
+  // Remove the row and column for this block from the conflict matrix, since
+  // the blocks after it will be re-indexed
+  if(vertex->index < conflict_matrix_.size()) {
+    conflict_matrix_.erase(conflict_matrix_.begin() + vertex->index);
+
+    for(ConflictMatrix::iterator row_it = conflict_matrix_.begin();
+        row_it != conflict_matrix_.end();
+        ++row_it)
+    {
+      EraseBlockIndex(*row_it, vertex->index);
+    }
+  }
+
+  // Remove this block from the set of running and required blocks
+  EraseBlockIndex(running_blocks_, vertex->index);
+  EraseBlockIndex(required_blocks_, vertex->index);
+
+  // Groups may contain this block, and the blocks after it are re-indexed
+  this->invalidateGroupExpansions();
+
+  model_version_++;
+
+  // Regenerate the graph without the vertex
+  return this->deferModelUpdate() || this->regenerateModel();
+}
+
+bool Scheme::regenerateModel()
+{
+  using namespace conman::graph;
+
+  RTT::Logger::In in("Scheme::regenerateGraph");
+
+  // Regenerateing model posible only when scheme is stoped
+  if(this->getTaskState() != Stopped) {
+    RTT::log(RTT::Error) << "Scheme is in running state. Regenerateing model forbidden." << RTT::endlog();
+    return false;
+  }
+
+  // Initialize the modification flag
+  bool topology_modified = exec_ordering_.size() != flow_vertex_map_.size();
+
+  // Model the connections from all blocks
+  contracts_satisfied_ = this->modelConnections(topology_modified);
+
+  return this->updateSchedule(topology_modified) && contracts_satisfied_;
+}
+
+//! Get the ports connected to an output port (sorted so they can be compared)
+static void GetPeerPorts(
+    RTT::base::PortInterface *port,
+    std::vector<RTT::base::PortInterface*> &peers)
+{
+  const std::list<RTT::internal::ConnectionManager::ChannelDescriptor> channels =
+    port->getManager()->getChannels();
+
+  peers.clear();
+  peers.reserve(channels.size());
+
+  for(std::list<RTT::internal::ConnectionManager::ChannelDescriptor>::const_iterator channel_it = channels.begin();
+      channel_it != channels.end();
+      ++channel_it)
+  {
+    peers.push_back(channel_it->get<1>()->getOutputEndPoint()->getPort());
+  }
+
+  std::sort(peers.begin(), peers.end());
+}
+
+bool Scheme::modelConnections(bool &topology_modified)
+{
+  using namespace conman::graph;
+
+  bool contracts_satisfied = true;
+
+  // Iterate over all vertex structures
+  for(std::map<std::string, DataFlowVertex::Ptr>::iterator vert_it = blocks_.begin();
+      vert_it != blocks_.end();
+      ++vert_it) 
+  {
+    // Temporary variable for readability
+    DataFlowVertex::Ptr source_vertex = vert_it->second;
+
+    // Get the output ports for a given taskcontext
+    std::vector<RTT::base::PortInterface*> ports;
+    GetAllPorts(source_vertex->block->provides(), ports);
+
+    // Create graph arcs for each port between blocks
+    std::vector<RTT::base::PortInterface*>::const_iterator port_it;
+    for(port_it = ports.begin(); port_it != ports.end(); ++port_it) 
+    {
+      RTT::log(RTT::Debug) << "Examining port: "<<source_vertex->block->getName() << " . " <<(*port_it)->getName() << RTT::endlog();
+
+      // Only start from output ports
+      if(!dynamic_cast<const RTT::base::OutputPortInterface*>(*port_it)) {
+        continue;
+      }
+
+      contracts_satisfied &= this->modelConnections(source_vertex, *port_it, topology_modified);
+    }
+  }
+
+  return contracts_satisfied;
+}
+
+bool Scheme::updateModel()
+{
+  using namespace conman::graph;
+
+  RTT::Logger::In in("Scheme::updateModel");
+
+  // Updating model posible only when scheme is stoped
+  if(this->getTaskState() != Stopped) {
+    RTT::log(RTT::Error) << "Scheme is in running state. Updating model forbidden." << RTT::endlog();
+    return false;
+  }
+
+  // Blocks can declare their port shapes whenever they're configured, so the
+  // connections which are already modeled are checked again, and their
+  // source ports are remodeled if they're no longer compatible
+  DataFlowEdgeIterator edge_it, edge_end;
+  for(boost::tie(edge_it, edge_end) = boost::edges(flow_graph_);
+      edge_it != edge_end;
+      ++edge_it)
+  {
+    const DataFlowVertex::Ptr
+      source_vertex = flow_graph_[boost::source(*edge_it, flow_graph_)],
+      sink_vertex = flow_graph_[boost::target(*edge_it, flow_graph_)];
+
+    const std::vector<DataFlowEdge::Connection> &connections = flow_graph_[*edge_it]->connections;
+    for(std::vector<DataFlowEdge::Connection>::const_iterator conn_it = connections.begin();
+        conn_it != connections.end();
+        ++conn_it)
+    {
+      if(!this->checkPortContract(source_vertex, conn_it->source_port, sink_vertex, conn_it->sink_port, true)) {
+        port_peers_.erase(conn_it->source_port);
+      }
+    }
+  }
+
+  // Queue the output ports whose connections changed since they were last
+  // modeled
+  std::vector<std::pair<DataFlowVertex::Ptr, RTT::base::PortInterface*> > modified_ports;
+
+  std::vector<RTT::base::PortInterface*> peers;
+
+  for(std::map<std::string, DataFlowVertex::Ptr>::iterator vert_it = blocks_.begin();
+      vert_it != blocks_.end();
+      ++vert_it) 
+  {
+    std::vector<RTT::base::PortInterface*> ports;
+    GetAllPorts(vert_it->second->block->provides(), ports);
+
+    std::vector<RTT::base::PortInterface*>::const_iterator port_it;
+    for(port_it = ports.begin(); port_it != ports.end(); ++port_it) 
+    {
+      if(!dynamic_cast<const RTT::base::OutputPortInterface*>(*port_it)) {
+        continue;
+      }
+
+      std::map<RTT::base::PortInterface*, std::vector<RTT::base::PortInterface*> >::const_iterator peers_it =
+        port_peers_.find(*port_it);
+      GetPeerPorts(*port_it, peers);
+
+      if(peers_it == port_peers_.end() || peers_it->second != peers) {
+        modified_ports.push_back(std::make_pair(vert_it->second, *port_it));
+      }
+    }
+  }
+
+  RTT::log(RTT::Debug) << "Updating the model for " << modified_ports.size()
+    << " modified ports." << RTT::endlog();
+
+  // Model the connections of only the modified ports
+  bool topology_modified = exec_ordering_.size() != flow_vertex_map_.size();
+
+  // The ports with incompatible connections are never recorded as modeled,
+  // so they're always remodeled here
+  contracts_satisfied_ = true;
+  for(size_t i=0; i < modified_ports.size(); i++) {
+    contracts_satisfied_ &= this->modelConnections(modified_ports[i].first, modified_ports[i].second, topology_modified);
+  }
+
+  return this->updateSchedule(topology_modified) && contracts_satisfied_;
+}
+
+bool Scheme::modelConnections(
+    conman::graph::DataFlowVertex::Ptr source_vertex,
+    RTT::base::PortInterface *port,
+    bool &topology_modified)
+{
+  using namespace conman::graph;
+
+  bool contracts_satisfied = true;
+
+  // Get the port connections (to get endpoints)
+  std::list<RTT::internal::ConnectionManager::ChannelDescriptor> channels = port->getManager()->getChannels();
+  std::list<RTT::internal::ConnectionManager::ChannelDescriptor>::iterator channel_it;
+
+  // Store the connections which are now modeled
+  std::vector<RTT::base::PortInterface*> &peers = port_peers_[port];
+  GetPeerPorts(port, peers);
+
+  // Forget the modeled connections from this port which no longer exist
+  std::map<RTT::TaskContext*, DataFlowVertexDescriptor>::const_iterator source_desc_it =
+    flow_vertex_map_.find(source_vertex->block);
+
+  if(source_desc_it != flow_vertex_map_.end()) {
+    std::vector<DataFlowEdgeDescriptor> empty_edges;
+
+    DataFlowOutEdgeIterator out_edge_it, out_edge_end;
+    for(boost::tie(out_edge_it, out_edge_end) = boost::out_edges(source_desc_it->second, flow_graph_);
+        out_edge_it != out_edge_end;
+        ++out_edge_it)
+    {
+      std::vector<DataFlowEdge::Connection> &connections = flow_graph_[*out_edge_it]->connections;
+      std::vector<DataFlowEdge::Connection>::iterator conn_it = connections.begin();
+      while(conn_it != connections.end()) {
+        if(conn_it->source_port == port &&
+           !std::binary_search(peers.begin(), peers.end(), conn_it->sink_port))
+        {
+          local_lock_policies_.erase(std::make_pair(conn_it->source_port, conn_it->sink_port));
+          conn_it = connections.erase(conn_it);
+          model_version_++;
+        } else {
+          ++conn_it;
+        }
+      }
+
+      if(connections.empty()) {
+        empty_edges.push_back(*out_edge_it);
+      }
+    }
+
+    for(std::vector<DataFlowEdgeDescriptor>::const_iterator edge_it = empty_edges.begin();
+        edge_it != empty_edges.end();
+        ++edge_it)
+    {
+      this->removeFlowEdge(*edge_it);
+      topology_modified = true;
+    }
+  }
+
+  // Create graph arcs for each connection
+  for(channel_it = channels.begin(); channel_it != channels.end(); ++channel_it) 
+  {
+    // Get the connection descriptor
+    RTT::base::ChannelElementBase::shared_ptr connection = channel_it->get<1>();
+
+    // Pointers to the endpoints of this connection
+    RTT::base::PortInterface  
+      *source_port = connection->getInputEndPoint()->getPort(), 
+      *sink_port = connection->getOutputEndPoint()->getPort();
+
+    // Make sure the ports and components are not null
+    // Make sure they have DFIs (some dont, like streamed ports)
+    if( source_port == NULL || source_port->getInterface() == NULL
+        || sink_port == NULL || sink_port->getInterface() == NULL) 
+    {
+      continue;
+    }
+
+    // Get the source and sink components
+    RTT::Service
+      *source_service = source_port->getInterface()->getService(),
+      *sink_service = sink_port->getInterface()->getService();
+
+    RTT::TaskContext
+      *source_block = source_port->getInterface()->getOwner(),
+      *sink_block = sink_port->getInterface()->getOwner();
+
+    // Make sure both blocks are in the DFG
+    if( flow_vertex_map_.find(source_block) == flow_vertex_map_.end() || 
+        flow_vertex_map_.find(sink_block)   == flow_vertex_map_.end()) 
+    {
+      continue;
+    }
+
+    // Get the source and sink flow vertex descriptors
+    DataFlowVertexDescriptor flow_source_desc = flow_vertex_map_[source_block];
+    DataFlowVertexDescriptor flow_sink_desc = flow_vertex_map_[sink_block];
+
+    // Get the sink vertex properties
+    DataFlowVertex::Ptr sink_vertex = flow_graph_[flow_sink_desc];
+
+    // Get an existing edge between these two blocks in the DFG
+    DataFlowEdgeDescriptor flow_edge_desc;
+    bool flow_edge_found;
+
+    boost::tie(flow_edge_desc, flow_edge_found) = boost::edge(
+        flow_source_desc,
+        flow_sink_desc,
+        flow_graph_);
+
+    // Don't model connections between ports whose declared shapes differ
+    // (they're left connected, it's up to the user to fix them)
+    if(!this->checkPortContract(source_vertex, source_port, sink_vertex, sink_port)) {
+      contracts_satisfied = false;
+
+      // Forget the connection if it was modeled before its contract changed
+      if(flow_edge_found) {
+        std::vector<DataFlowEdge::Connection> &connections = flow_graph_[flow_edge_desc]->connections;
+        for(std::vector<DataFlowEdge::Connection>::iterator conn_it = connections.begin();
+            conn_it != connections.end();
+            ++conn_it)
+        {
+          if(conn_it->source_port == source_port && conn_it->sink_port == sink_port) {
+            connections.erase(conn_it);
+            model_version_++;
+            break;
+          }
+        }
+
+        if(connections.empty()) {
+          this->removeFlowEdge(flow_edge_desc);
+          topology_modified = true;
+        }
+      }
+
+      continue;
+    }
+
+    // Pointer to flow edge properties
+    DataFlowEdge::Ptr flow_edge;
+
+    // Only create edge if it isn't already there
+    if(flow_edge_found) {
+      RTT::log(RTT::Debug) << "Found DFG edge "
+        << source_block->getName() << "." << source_port->getName() << " --> "
+        << sink_block->getName() << "." << sink_port->getName() << RTT::endlog();
+
+      // Get the existing DFG edge
+      flow_edge = flow_graph_[flow_edge_desc];
+    } else {
+      // Create a new edge representing the connections between these two vertices
+      flow_edge = boost::make_shared<DataFlowEdge>();
+
+      // Add the edge to the DFG
+      bool edge_added;
+      boost::tie(flow_edge_desc,edge_added) = boost::add_edge(
+          flow_source_desc, 
+          flow_sink_desc, 
+          flow_edge, 
+          flow_graph_);
+
+      if(edge_added) {
+        // Set the topo flag since we've modified edges
+        topology_modified = true;
+
+        // Apply a latch requested before this edge was modeled, or restore
+        // the latch of an edge which was removed when these blocks were
+        // disconnected
+        const std::pair<RTT::TaskContext*, RTT::TaskContext*> arc(source_block, sink_block);
+        std::map<std::pair<RTT::TaskContext*, RTT::TaskContext*>, bool>::iterator latch_it =
+          pending_latches_.find(arc);
+        if(latch_it != pending_latches_.end()) {
+          flow_edge->latched = latch_it->second;
+        } else if((latch_it = removed_latches_.find(arc)) != removed_latches_.end()) {
+          flow_edge->latched = latch_it->second;
+        }
+        removed_latches_.erase(arc);
+
+        RTT::log(RTT::Debug) << "Created DFG edge "
+          << source_block->getName() << "." << source_port->getName() << " --> "
+          << sink_block->getName() << "." << sink_port->getName() << RTT::endlog();
+      } else {
+        RTT::log(RTT::Error) << "Could not create DFG edge "
+          << source_block->getName() << "." << source_port->getName() << " --> "
+          << sink_block->getName() << "." << sink_port->getName() << RTT::endlog();
+      }
+    }
+
+    // Check if this connection is already modeled in the data flow edge
+    bool connection_exists = false;
+    std::vector<DataFlowEdge::Connection>::const_iterator edge_connection_it;
+    for(edge_connection_it = flow_edge->connections.begin();
+        edge_connection_it != flow_edge->connections.end();
+        ++edge_connection_it) 
+    {
+      if( edge_connection_it->source_port == source_port &&
+          edge_connection_it->sink_port == sink_port) 
+      {
+        connection_exists = true;
+        break;
+      }
+    }
+
+    // Store the data flow connection in the edge if it doesn't already exist
+    if(!connection_exists) {
+      flow_edge->connections.push_back(
+          DataFlowEdge::Connection(
+              source_service, source_port,
+              sink_service, sink_port));
+      model_version_++;
+
+      // The scheme executes both blocks, so the connection can be unsynchronized
+      if(local_connections_) {
+        this->localizeConnection(source_port, sink_port, true);
+      }
+    }
+
+    // Check if either of the blocks involved in this connection are latched
+    // (latching the edge removes it from the ESG view)
+    if(!flow_edge->latched && (source_vertex->latched_output || sink_vertex->latched_input)) {
+      flow_edge->latched = true;
+      topology_modified = true;
+      model_version_++;
+    }
+  }
+
+  // Remodel this port on the next update until its connections are fixed
+  if(!contracts_satisfied) {
+    port_peers_.erase(port);
+  }
+
+  return contracts_satisfied;
+}
+
+void Scheme::removeFlowEdge(const conman::graph::DataFlowEdgeDescriptor &edge)
+{
+  removed_latches_[std::make_pair(
+      flow_graph_[boost::source(edge, flow_graph_)]->block,
+      flow_graph_[boost::target(edge, flow_graph_)]->block)] = flow_graph_[edge]->latched;
+
+  boost::remove_edge(edge, flow_graph_);
+}
+
+bool Scheme::updateSchedule(const bool topology_modified)
+{
+  // Recompute the execution schedule if the topology changed since it was
+  // last computed (latching edges elsewhere also changes the ESG)
+  if(topology_modified || exec_ordering_version_ != model_version_) {
+    exec_ordering_version_ = model_version_;
+    if(this->computeSchedule(exec_graph_, exec_ordering_, true)) {
+      RTT::log(RTT::Debug) << "Regenerated topological ordering." << RTT::endlog();
+    } else {
+      RTT::log(RTT::Debug) << "Could not regenerate the topological ordering." << RTT::endlog();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool Scheme::enableBlock(const std::string &block_name, const bool force)
+{
+  RTT::Logger::In in("Scheme::enableBlock");
+
+  // First check if this block is a group
+  conman::GroupMap::iterator group = 
+    block_groups_.find(block_name);
+
+  if(group != block_groups_.end()) {
+    // Enable the blocks in this group
+    RTT::log(RTT::Debug) << "Enabling blocks in group \"" << block_name <<"\"" << RTT::endlog();
+    return this->enableBlocks(
+        std::vector<std::string>(group->second.begin(),group->second.end()),
+        true,
+        force);
+  }
+
+  // Enable the block by name
+  return this->enableBlock(this->getPeer(block_name), force);
+}
+
+bool Scheme::enableBlock(RTT::TaskContext *block, const bool force)
+{
+  using namespace conman::graph;
+
+  RTT::Logger::In in("Scheme::enableBlock");
+
+  if(block == NULL) { 
+    RTT::log(RTT::Error) << "Could not enable block because the given block is NULL." << RTT::endlog();
+    return false; 
+  }
+
+  const std::string &block_name = block->getName();
+  std::map<std::string,conman::graph::DataFlowVertex::Ptr>::const_iterator block_vertex_it = blocks_.find(block_name);
+
+  RTT::log(RTT::Debug) << "Enabling block \"" << block_name <<"\"" << RTT::endlog();
+
+  if(block_vertex_it == blocks_.end()) {
+    RTT::log(RTT::Error) << "Could not enable block \""<< block_name << "\""
+      " because it has not been added to the scheme." << RTT::endlog();
+    return false;
+  }
+
+  return this->enableVertex(block_vertex_it->second, force);
+}
+
+bool Scheme::enableVertex(
+    const conman::graph::DataFlowVertex::Ptr &block_vertex,
+    const bool force)
+{
+  using namespace conman::graph;
+
+  RTT::TaskContext *block = block_vertex->block;
+  const std::string &block_name = block->getName();
+
+  // Make sure the block is configured
+  if(!block->isConfigured()) {
+    RTT::log(RTT::Error) << "Could not enable block \""<< block_name << "\""
+      " because it has not been confiugre()ed." << RTT::endlog();
+    return false;
+  }
+
+  // Check if the block is already enabled
+  if(block->getTaskState() == RTT::TaskContext::Running) {
+    // If it's already running, then we're going to assume for now that the
+    // user isn't doing anything dirty.
+    // TODO: Keep track of whether or not a block has been properly enabled.
+    RTT::log(RTT::Debug) << "The block \"" << block_name <<"\" is already enabled." << RTT::endlog();
+    running_blocks_[block_vertex->index] = true;
+    return true;
+  }
+
+  // Check if conflicting blocks are running
+  if(block_vertex->index < conflict_matrix_.size()) {
+    this->syncRunningBlocks(conflict_matrix_[block_vertex->index]);
+  }
+
+  const bool has_conflicts = 
+    block_vertex->index < conflict_matrix_.size() &&
+    conflict_matrix_[block_vertex->index].size() == running_blocks_.size() &&
+    conflict_matrix_[block_vertex->index].intersects(running_blocks_);
+
+  const ConflictSet &conflicts = has_conflicts ? conflict_matrix_[block_vertex->index] : running_blocks_;
+
+  for(ConflictSet::size_type c = conflicts.find_first();
+      has_conflicts && c != ConflictSet::npos;
+      c = conflicts.find_next(c))
+  {
+    if(!running_blocks_.test(c)) {
+      continue;
+    }
 
-    // Get a reference to the vertex properties of the sink block for convenience
-    const DataFlowVertexDescriptor sink_vertex_descriptor = boost::target(*out_edge_it, flow_graph_);
-    const DataFlowVertex::Ptr sink_vertex = flow_graph_[sink_vertex_descriptor];
+    RTT::TaskContext *conflict_block = block_indices_[c]->block;
 
-    RTT::log(RTT::Debug) << " -- Examining ports " << seed_block->getName() << " -> " << sink_vertex->block->getName() << "..." << RTT::endlog();
+    // Check if the conflicting block is running
+    if(conflict_block->getTaskState() == RTT::TaskContext::Running) {
+      // If force is selected, disable the conflicting block
+      if(force) {
+        RTT::log(RTT::Info) << "Force-enabling block \""<< block_name << "\""
+          " involves disabling block \"" << conflict_block->getName() << "\""
+          << RTT::endlog();
 
-    // Iterate over connections between the seed block and this sink block (each pair of output/input ports)
-    for(std::vector<DataFlowEdge::Connection>::const_iterator out_conn_it = out_edge->connections.begin();
-        out_conn_it != out_edge->connections.end();
-        ++out_conn_it)
-    {
-      const std::string source_port_path = ResolvePortPath(out_conn_it->sink_service, out_conn_it->sink_port);
-      const std::string sink_port_path = ResolvePortPath(out_conn_it->sink_service, out_conn_it->sink_port);
+        // Make sure we can actually disable it
+        if(this->disableVertex(block_indices_[c]) == false) {
+          RTT::log(RTT::Error) << "Could not disable block \"" <<
+            conflict_block->getName() << "\"" << RTT::endlog();
+          return false;
+        }
+      } else {
+        RTT::log(RTT::Error) << "Could not enable block \""<< block_name <<
+          "\" because it conflicts with block \"" << conflict_block->getName()
+          << "\"" << RTT::endlog();
+        return false;
+      }
+    }
+  }
+
+  // Initialize the hook
+  block_vertex->hook->init(last_update_time_);
+
+  // Try to start the block
+  if(!block->start()) {
+    RTT::log(RTT::Error) << "Could not enable block \""<< block_name << "\""
+      " because it could not be start()ed." << RTT::endlog();
+    return false;
+  }
+
+  running_blocks_[block_vertex->index] = block->isRunning();
+
+  return true;
+}
+
+bool Scheme::disableBlock(const std::string &block_name)
+{
+  // First check if this block is a group
+  std::map<std::string, std::set<std::string> >::iterator group = 
+    block_groups_.find(block_name);
+
+  if(group != block_groups_.end()) {
+    // Enable the blocks in this group
+    return this->disableBlocks(
+        std::vector<std::string>(group->second.begin(),group->second.end()),
+        true);
+  }
+
+  // Disable the block by name
+  return this->disableBlock(this->getPeer(block_name));
+}
+
+bool Scheme::disableVertex(const conman::graph::DataFlowVertex::Ptr &block_vertex)
+{
+  RTT::TaskContext *block = block_vertex->block;
+
+  // Stop a block
+  if(block->isRunning()) {
+    if(!block->stop()) {
+      RTT::log(RTT::Error) 
+        << "Could not disable block \""<< block->getName() << "\" because it"
+        " could not be stop()ed." << RTT::endlog();
+      return false;
+    }
+  }
+
+  running_blocks_[block_vertex->index] = block->isRunning();
+
+  return true;
+}
+
+bool Scheme::disableBlock(RTT::TaskContext* block) 
+{
+  if(block == NULL) { return false; }
+
+  // Stop a block
+  if(block->isRunning()) {
+    if(!block->stop()) {
+      RTT::log(RTT::Error) 
+        << "Could not disable block \""<< block->getName() << "\" because it"
+        " could not be stop()ed." << RTT::endlog();
+      return false;
+    }
+  }
+
+  this->updateRunningBlock(block);
+
+  return true;
+}
+
+/*
+ *bool Scheme::enableBlocks(
+ *    const std::set<std::string> &block_names,
+ *    const bool strict,
+ *    const bool force)
+ *{
+ *  for(std::set<std::string>::const_iterator it = block_names.begin();
+ *      it != block_names.end();
+ *      ++it)
+ *  { 
+ *  }
+ *}
+ */
+
+bool Scheme::enableable(
+    const std::string &block_name) const
+{
+  return this->enableable(std::vector<std::string>(1, block_name));
+}
+
+bool Scheme::enableable(
+    const std::vector<std::string> &block_names) const
+{
+  using namespace conman::graph;
+
+  // Get the blocks in the blocks and groups
+  ConflictSet block_set;
+  if(!this->getBlockSet(block_names, block_set)) {
+    RTT::log(RTT::Error) << "Could not check all blocks and groups for conflicts because some are not in the scheme." << RTT::endlog();
+  }
+
+  // Check if any conflicting blocks are running
+  const ConflictSet conflict_set = this->getConflictSet(block_set);
+  this->syncRunningBlocks(conflict_set);
+
+  return !conflict_set.intersects(running_blocks_);
+}
 
-      RTT::log(RTT::Debug) << " -- -- Examining connection " 
-        << seed_block->getName()<<"."<<source_port_path
-        << " -> "
-        << sink_vertex->block->getName()<<"."<<sink_port_path<< " ..."
-        << RTT::endlog();
+bool Scheme::enableBlocks(
+    const std::vector<std::string> &block_names,
+    const bool strict,
+    const bool force)
+{
+  using namespace conman::graph;
 
-      // Get the exclusivity of this connection from the seed to this sink
-      // (the sink port of the out connection is the input that it is connected to)
-      const conman::Exclusivity::Mode mode = sink_vertex->hook->getInputExclusivity(sink_port_path);
+  // Get the running blocks which conflict with the blocks to be enabled
+  ConflictSet block_set;
+  this->getBlockSet(block_names, block_set);
+  const ConflictSet conflict_set = this->getConflictSet(block_set);
+  this->syncRunningBlocks(conflict_set);
+  const ConflictSet running_conflicts = conflict_set & running_blocks_;
+
+  // First make sure all the blocks can be enabled before actually trying to enable them
+  if(!force) {
+    if(running_conflicts.any()) {
+      RTT::log(RTT::Error) << "Could not enable block because it has conflicts which will not be force-disabled." << RTT::endlog();
+      return false;
+    }
+  } else {
+    // Disable all of the conflicting blocks which aren't going to be enabled
+    const ConflictSet disable_set = running_conflicts - block_set;
 
-      // Only exclusive ports can induce conflicts
-      if(mode != conman::Exclusivity::EXCLUSIVE) {
+    for(std::vector<DataFlowVertex::Ptr>::const_iterator it = block_indices_.begin();
+        it != block_indices_.end() && disable_set.any();
+        ++it)
+    {
+      if(!disable_set.test((*it)->index)) {
         continue;
       }
 
-      RTT::log(RTT::Debug) << " -- -- This connection is EXCLUSIVE " << RTT::endlog(); 
+      RTT::log(RTT::Info) << "Force-enabling blocks involves disabling block \""
+        << (*it)->block->getName() << "\"" << RTT::endlog();
+
+      if(!this->disableVertex(*it) && strict) {
+        return false;
+      }
+    }
+  }
 
-      // Iterator for edges targeting the sink vertex
-      DataFlowInEdgeIterator in_edge_it, in_edge_end;
+  // Enable the blocks
+  bool success = true;
 
-      // Iterate over all input edges to the sink vertex
-      for(boost::tie(in_edge_it, in_edge_end) = boost::in_edges(sink_vertex_descriptor, flow_graph_);
-          in_edge_it != in_edge_end;
-          ++in_edge_it) 
-      {
-        // Get a reference to the edge properties for convenience
-        const DataFlowEdge::Ptr in_edge = flow_graph_[*in_edge_it];
-        const DataFlowVertex::Ptr source_vertex = flow_graph_[boost::source(*in_edge_it,flow_graph_)];
+  for(std::vector<std::string>::const_iterator it = block_names.begin();
+      it != block_names.end();
+      ++it)
+  {
+    // Try to start the block
+    success = this->enableBlock(*it,force) && success;
+
+    // Break on failure if strict
+    if(!success && strict) { return false; }
+  }
+
+  return success;
+}
+
+bool Scheme::disableBlocks(const bool strict)
+{
+  bool success = true;
 
-        RTT::log(RTT::Debug) << " -- -- -- Examining ports " << source_vertex->block->getName() << " -> " << sink_vertex->block->getName() << "..." << RTT::endlog();
+  for(std::map<std::string,graph::DataFlowVertex::Ptr>::const_iterator it = blocks_.begin();
+      it != blocks_.end();
+      ++it)
+  {
+    // Try to disable the block
+    success &= this->disableBlock(it->second->block);
+
+    // Break on failure if strict
+    if(!success && strict) { return false; }
+  }
+
+  return success;
+}
+
+bool Scheme::disableBlocks(
+    const std::vector<std::string> &block_names,
+    const bool strict)
+{
+  bool success = true;
+
+  for(std::vector<std::string>::const_iterator it = block_names.begin();
+      it != block_names.end();
+      ++it)
+  {
+    // Try to disable the block
+    success &= this->disableBlock(*it);
+
+    // Break on failure if strict
+    if(!success && strict) { return false; }
+  }
+
+  return success;
+}
 
-        // Iterate over the connections (port pairs) on this in input edge
-        for(std::vector<DataFlowEdge::Connection>::const_iterator in_conn_it = in_edge->connections.begin();
-            in_conn_it != in_edge->connections.end();
-            ++in_conn_it)
-        {
-          RTT::log(RTT::Debug) << " -- -- -- -- Examining connection " 
-            << source_vertex->block->getName()<<"."<< in_conn_it->source_port->getName() 
-            << " -> "
-            << sink_vertex->block->getName()<<"."<< in_conn_it->sink_port->getName() << "..."
-            << RTT::endlog();
-
-          // This isn't a conflict if the ports are different
-          if(out_conn_it->sink_port != in_conn_it->sink_port) {
-            continue;
-          }
+bool Scheme::switchBlocks(
+    const std::vector<std::string> &disable_block_names,
+    const std::vector<std::string> &enable_block_names,
+    const bool strict,
+    const bool force)
+{
 
-          // Add conflict between the seed block and the source block for this connection
-          const DataFlowVertex::Ptr conflicting_vertex = flow_graph_[boost::source(*in_edge_it,flow_graph_)];
+  bool success = true;
 
-          // Make sure the source block is in the conflict map, and isn't the seed block
-          if( conflict_vertex_map_.find(conflicting_vertex->block) == conflict_vertex_map_.end() ||
-              seed_block == conflicting_vertex->block) 
-          {
-            continue;
-          }
+  for(std::vector<std::string>::const_iterator it = disable_block_names.begin();
+      it != disable_block_names.end();
+      ++it)
+  {
+    // Don't disable a blcok that's about to be enabled
+    if(std::find(enable_block_names.begin(), enable_block_names.end(), *it) == enable_block_names.end()) {
+      // Try to disable the block
+      success &= this->disableBlock(*it);
 
-          // Add an edge in the conflict graph between the seed block and the source block
-          add_edge(
-              conflict_vertex_map_[seed_block],
-              conflict_vertex_map_[conflicting_vertex->block],
-              conflict_graph_);
-
-          // Debug output
-          RTT::log(RTT::Debug) << " -- -- -- -- Added conflict between blocks "<<
-            seed_block->getName() << " and " <<
-            conflicting_vertex->block->getName() << " because of port: "
-            << sink_vertex->block->getName() << "." << in_conn_it->sink_port->getName() << RTT::endlog();
-        }
-      }
+      // Break on failure if strict
+      if(!success && strict) { return false; }
     }
   }
-}
 
-///////////////////////////////////////////////////////////////////////////////
+  // First disable blocks, so that "force" can be used appropriately when
+  // enabling blocks.
+  bool enable_success = this->enableBlocks(enable_block_names, strict, force);
 
-const conman::graph::DataFlowVertex::Ptr Scheme::getBlockVertex(const std::string &name) const
-{
-  return blocks_.find(name)->second;
+  return success;
 }
 
-const conman::graph::ConflictVertexDescriptor Scheme::getConflictVertex(RTT::TaskContext* task) const
+bool Scheme::setEnabledBlocks(
+    const std::vector<std::string> &enabled_block_names,
+    const bool strict)
 {
-  return conflict_vertex_map_.find(task)->second;
+  bool disable_success = this->disableBlocks(strict);
+  bool enable_success = this->enableBlocks(enabled_block_names, strict, false);
+
+  return disable_success && enable_success;
 }
 
-bool Scheme::addBlockToGraph(conman::graph::DataFlowVertex::Ptr new_vertex)
+///////////////////////////////////////////////////////////////////////////////
+
+//! Blocks to be configured by a pool of threads
+struct ConfigureQueue
 {
-  using namespace conman::graph;
+  //! The blocks to configure (NULL for blocks which are skipped)
+  std::vector<RTT::TaskContext*> blocks;
+  //! The result for each block
+  std::vector<conman::ConfigureResult> *report;
+  //! The index of the next block to configure
+  size_t next;
+  //! Mutex protecting the next index
+  boost::mutex mutex;
+};
+
+//! Configure blocks from the queue until it's empty
+static void ConfigureWorker(ConfigureQueue &queue)
+{
+  while(true) {
+    size_t i;
 
-  RTT::Logger::In in("Scheme::addBlockToGraph");
+    // Get the next block
+    {
+      boost::mutex::scoped_lock lock(queue.mutex);
+      if(queue.next >= queue.blocks.size()) {
+        return;
+      }
+      i = queue.next++;
+    }
 
-  // Make sure the vertex isn't null
-  if(!new_vertex) {
-    RTT::log(RTT::Error) << "DataFlowVertex::Ptr is NULL." << RTT::endlog();
-    return false;
+    if(queue.blocks[i] == NULL) {
+      continue;
+    }
+
+    // Configure it and measure how long it took
+    const RTT::os::TimeService::nsecs start = RTT::os::TimeService::Instance()->getNSecs();
+    (*queue.report)[i].success = queue.blocks[i]->configure();
+    (*queue.report)[i].duration = RTT::nsecs_to_Seconds(RTT::os::TimeService::Instance()->getNSecs(start));
   }
+}
 
-  // Get a reference to the block pointer
-  TaskContext *&new_block = new_vertex->block;
+bool Scheme::configureBlocks(
+    const std::vector<std::string> &block_names,
+    const unsigned int max_threads,
+    std::vector<conman::ConfigureResult> &report)
+{
+  RTT::Logger::In in("Scheme::configureBlocks");
 
-  // Make sure the block isn't null
-  if(new_block == NULL) {
-    RTT::log(RTT::Error) << "TaskContext is NULL." << RTT::endlog();
-    return false;
-  }
+  report.clear();
 
-  // Make sure the block has the conman hook service
-  if(!conman::Hook::HasHook(new_block)) {
-    RTT::log(RTT::Error) << "Requested block to add does not have the conman"
-      "hook service." << RTT::endlog();
+  // Configuring blocks would stall the scheme's updates
+  if(this->isRunning()) {
+    RTT::log(RTT::Error) << "Scheme is in running state. Configuring blocks forbidden." << RTT::endlog();
     return false;
   }
 
-  // Add this block to the DFG & ESG
-  flow_vertex_map_[new_block] = boost::add_vertex(new_vertex, flow_graph_);
-  exec_vertex_map_[new_block] = boost::add_vertex(new_vertex, exec_graph_);
-
-  RTT::log(RTT::Debug) << "Created vertex: "<< new_vertex->index << " (" <<
-    flow_vertex_map_[new_block] << ", " << exec_vertex_map_[new_block] << ")"
-    << RTT::endlog();
-
-  // Regenerate the topological ordering
-  if(!this->regenerateModel()) {
-    // Report error if we can't regenerate the graphs
-    RTT::log(RTT::Warning) << "New block \"" << new_block->getName()
-      << "\" creates one or more cycles in the conman scheme." << RTT::endlog();
-
-    if(false) {
-      // Clean up this graph (but not the others, yet)
-      this->removeBlockFromGraph(new_vertex);
-
+  // Get the blocks in the blocks and groups
+  std::set<std::string> members;
+  for(std::vector<std::string>::const_iterator it = block_names.begin();
+      it != block_names.end();
+      ++it)
+  {
+    std::vector<std::string> group_members;
+    if(!this->getGroupMembers(*it, group_members)) {
+      RTT::log(RTT::Error) << "Could not configure blocks because \"" << *it
+        << "\" is not a block or group in the scheme." << RTT::endlog();
       return false;
     }
+    members.insert(group_members.begin(), group_members.end());
   }
 
-  return true;
-}
-
-bool Scheme::removeBlockFromGraph(conman::graph::DataFlowVertex::Ptr vertex)
-{
-  using namespace conman::graph;
+  ConfigureQueue queue;
+  queue.report = &report;
+  queue.next = 0;
 
-  RTT::Logger::In in("Scheme::removeBlockFromGraph");
+  size_t n_blocks = 0;
 
-  // Succeed if the vertex already doesn't exist
-  if(flow_vertex_map_.find(vertex->block) == flow_vertex_map_.end()) {
-    return true;
-  }
+  for(std::set<std::string>::const_iterator it = members.begin();
+      it != members.end();
+      ++it)
+  {
+    RTT::TaskContext *block = blocks_.find(*it)->second->block;
 
-  // Remove the edges, the vertex itself, and the reference in the flow map
-  if(flow_vertex_map_.find(vertex->block) != flow_vertex_map_.end()) {
-    boost::clear_vertex(flow_vertex_map_[vertex->block], flow_graph_);
-    boost::remove_vertex(flow_vertex_map_[vertex->block], flow_graph_);
-    flow_vertex_map_.erase(vertex->block);
-  }
+    conman::ConfigureResult result;
+    result.block = *it;
+    result.skipped = block->isRunning();
+    result.success = result.skipped;
+    result.duration = 0.0;
 
-  // Remove the edges, the vertex itself, and the reference in the exec map
-  if(exec_vertex_map_.find(vertex->block) != exec_vertex_map_.end()) {
-    boost::clear_vertex(exec_vertex_map_[vertex->block], exec_graph_);
-    boost::remove_vertex(exec_vertex_map_[vertex->block], exec_graph_);
-    exec_vertex_map_.erase(vertex->block);
-  }
+    // Running blocks can't be reconfigured, so they aren't queued
+    queue.blocks.push_back(result.skipped ? NULL : block);
+    report.push_back(result);
 
-  // Remove the edges, the vertex itself, and the reference in the conflict map
-  if(conflict_vertex_map_.find(vertex->block) != conflict_vertex_map_.end()) {
-    boost::clear_vertex(conflict_vertex_map_[vertex->block], conflict_graph_);
-    boost::remove_vertex(conflict_vertex_map_[vertex->block], conflict_graph_);
-    conflict_vertex_map_.erase(vertex->block);
+    if(!result.skipped) {
+      n_blocks++;
+    }
   }
 
-  // Regenerate the graph without the vertex
-  return this->regenerateModel();
-}
+  // Use one thread per core by default, but never more threads than blocks
+  size_t n_threads = (max_threads > 0) ? max_threads : boost::thread::hardware_concurrency();
+  n_threads = std::max(size_t(1), std::min(n_threads, n_blocks));
 
-bool Scheme::regenerateModel()
-{
-  using namespace conman::graph;
+  RTT::log(RTT::Debug) << "Configuring " << n_blocks << " blocks on "
+    << n_threads << " threads..." << RTT::endlog();
 
-  RTT::Logger::In in("Scheme::regenerateGraph");
+  // Configure the blocks
+  const RTT::os::TimeService::nsecs start = RTT::os::TimeService::Instance()->getNSecs();
 
-  // Regenerateing model posible only when scheme is stoped
-  if(this->getTaskState() != Stopped) {
-    RTT::log(RTT::Error) << "Scheme is in running state. Regenerateing model forbidden." << RTT::endlog();
-    return false;
+  boost::thread_group threads;
+  for(size_t t=0; t < n_threads; t++) {
+    threads.create_thread(boost::bind(ConfigureWorker, boost::ref(queue)));
   }
+  threads.join_all();
 
-  // Initialize the modification flag
-  bool topology_modified = exec_ordering_.size() != flow_vertex_map_.size();
+  const RTT::Seconds duration = RTT::nsecs_to_Seconds(RTT::os::TimeService::Instance()->getNSecs(start));
 
-  // Iterate over all vertex structures
-  for(std::map<std::string, DataFlowVertex::Ptr>::iterator vert_it = blocks_.begin();
-      vert_it != blocks_.end();
-      ++vert_it) 
+  // Report the results
+  bool success = true;
+
+  for(std::vector<conman::ConfigureResult>::const_iterator it = report.begin();
+      it != report.end();
+      ++it)
   {
-    // Temporary variable for readability
-    DataFlowVertex::Ptr source_vertex = vert_it->second;
+    if(it->skipped) {
+      RTT::log(RTT::Debug) << "Skipped configuring block \"" << it->block
+        << "\" because it is running." << RTT::endlog();
+    } else if(it->success) {
+      RTT::log(RTT::Debug) << "Configured block \"" << it->block << "\" in "
+        << it->duration << " seconds." << RTT::endlog();
+    } else {
+      RTT::log(RTT::Error) << "Could not configure block \"" << it->block
+        << "\" (" << it->duration << " seconds)." << RTT::endlog();
+      success = false;
+    }
+  }
 
-    // Get the output ports for a given taskcontext
-    std::vector<RTT::base::PortInterface*> ports;
-    GetAllPorts(source_vertex->block->provides(), ports);
+  RTT::log(RTT::Info) << "Configured " << n_blocks << " blocks in "
+    << duration << " seconds." << RTT::endlog();
 
-    // Create graph arcs for each port between blocks
-    std::vector<RTT::base::PortInterface*>::const_iterator port_it;
-    for(port_it = ports.begin(); port_it != ports.end(); ++port_it) 
-    {
-      // Get the port, for readability
-      const RTT::base::PortInterface *port = *port_it;
+  // Blocks can declare their port contracts when they're configured, so the
+  // connections which were modeled before then need to be checked again
+  if(n_blocks > 0 && !this->deferModelUpdate()) {
+    if(!this->regenerateModel() && contracts_satisfied_) {
+      RTT::log(RTT::Warning) << "Could not regenerate the model after configuring the blocks." << RTT::endlog();
+    }
 
-      RTT::log(RTT::Debug) << "Examining port: "<<source_vertex->block->getName() << " . " <<port->getName() << RTT::endlog();
+    if(!contracts_satisfied_) {
+      RTT::log(RTT::Error) << "Some connections to the configured blocks don't "
+        "match their declared port shapes, so they aren't modeled." << RTT::endlog();
+      success = false;
+    }
+  }
 
-      // Only start from output ports
-      if(!dynamic_cast<const RTT::base::OutputPortInterface*>(port)) {
-        continue;
-      }
+  return success;
+}
 
-      // Get the port connections (to get endpoints)
-      std::list<RTT::internal::ConnectionManager::ChannelDescriptor> channels = port->getManager()->getChannels();
-      std::list<RTT::internal::ConnectionManager::ChannelDescriptor>::iterator channel_it;
+bool Scheme::configureBlocks(
+    const std::vector<std::string> &block_names,
+    const unsigned int max_threads,
+    std::vector<std::string> &configured_blocks,
+    std::vector<int> &status,
+    std::vector<double> &durations)
+{
+  std::vector<conman::ConfigureResult> report;
+  const bool success = this->configureBlocks(block_names, max_threads, report);
 
-      // Create graph arcs for each connection
-      for(channel_it = channels.begin(); channel_it != channels.end(); ++channel_it) 
-      {
-        // Get the connection descriptor
-        RTT::base::ChannelElementBase::shared_ptr connection = channel_it->get<1>();
-
-        // Pointers to the endpoints of this connection
-        RTT::base::PortInterface  
-          *source_port = connection->getInputEndPoint()->getPort(), 
-          *sink_port = connection->getOutputEndPoint()->getPort();
-
-        // Make sure the ports and components are not null
-        // Make sure they have DFIs (some dont, like streamed ports)
-        if( source_port == NULL || source_port->getInterface() == NULL
-            || sink_port == NULL || sink_port->getInterface() == NULL) 
-        {
-          continue;
-        }
+  configured_blocks.clear();
+  status.clear();
+  durations.clear();
 
-        // Get the source and sink components
-        RTT::Service
-          *source_service = source_port->getInterface()->getService(),
-          *sink_service = sink_port->getInterface()->getService();
+  for(std::vector<conman::ConfigureResult>::const_iterator it = report.begin();
+      it != report.end();
+      ++it)
+  {
+    configured_blocks.push_back(it->block);
+    status.push_back(
+        it->skipped ? ConfigureStatus::SKIPPED :
+        it->success ? ConfigureStatus::CONFIGURED :
+        ConfigureStatus::FAILED);
+    durations.push_back(it->duration);
+  }
 
-        RTT::TaskContext
-          *source_block = source_port->getInterface()->getOwner(),
-          *sink_block = sink_port->getInterface()->getOwner();
+  return success;
+}
 
-        // Make sure both blocks are in the DFG and ESG
-        if( flow_vertex_map_.find(source_block) == flow_vertex_map_.end() || 
-            flow_vertex_map_.find(sink_block)   == flow_vertex_map_.end() ||
-            exec_vertex_map_.find(source_block) == exec_vertex_map_.end() || 
-            exec_vertex_map_.find(sink_block)   == exec_vertex_map_.end()) 
-        {
-          continue;
-        }
+bool Scheme::configureBlocks(
+    const std::string &group_name,
+    const unsigned int max_threads)
+{
+  std::vector<conman::ConfigureResult> report;
 
-        // Get the source and sink flow vertex descriptors
-        DataFlowVertexDescriptor flow_source_desc = flow_vertex_map_[source_block];
-        DataFlowVertexDescriptor flow_sink_desc = flow_vertex_map_[sink_block];
+  if(group_name.empty()) {
+    return this->configureBlocks(this->getBlocks(), max_threads, report);
+  }
 
-        // Get the sink vertex properties
-        DataFlowVertex::Ptr sink_vertex = flow_graph_[flow_sink_desc];
+  return this->configureBlocks(std::vector<std::string>(1, group_name), max_threads, report);
+}
 
-        // Get an existing edge between these two blocks in the DFG
-        DataFlowEdgeDescriptor flow_edge_desc;
-        bool flow_edge_found;
+///////////////////////////////////////////////////////////////////////////////
 
-        boost::tie(flow_edge_desc, flow_edge_found) = boost::edge(
-            flow_source_desc,
-            flow_sink_desc,
-            flow_graph_);
+bool Scheme::enableable(
+    const std::vector<conman::BlockID> &block_ids) const
+{
+  // Get the blocks in the blocks and groups
+  if(!this->getBlockSet(block_ids, id_block_set_)) {
+    RTT::log(RTT::Error) << "Could not check all blocks and groups for conflicts because some IDs are not in the scheme." << RTT::endlog();
+  }
 
-        // Pointer to flow edge properties
-        DataFlowEdge::Ptr flow_edge;
+  // Check if any conflicting blocks are running
+  this->getConflictSet(id_block_set_, id_conflict_set_);
+  this->syncRunningBlocks(id_conflict_set_);
 
-        // Only create edge if it isn't already there
-        if(flow_edge_found) {
-          RTT::log(RTT::Debug) << "Found DFG edge "
-            << source_block->getName() << "." << source_port->getName() << " --> "
-            << sink_block->getName() << "." << sink_port->getName() << RTT::endlog();
+  return !id_conflict_set_.intersects(running_blocks_);
+}
 
-          // Get the existing DFG edge
-          flow_edge = flow_graph_[flow_edge_desc];
-        } else {
-          // Create a new edge representing the connections between these two vertices
-          flow_edge = boost::make_shared<DataFlowEdge>();
-
-          // Add the edge to the DFG
-          bool edge_added;
-          boost::tie(flow_edge_desc,edge_added) = boost::add_edge(
-              flow_source_desc, 
-              flow_sink_desc, 
-              flow_edge, 
-              flow_graph_);
-
-          if(edge_added) {
-            // Set the topo flag since we've modified edges
-            topology_modified = true;
-
-            RTT::log(RTT::Debug) << "Created DFG edge "
-              << source_block->getName() << "." << source_port->getName() << " --> "
-              << sink_block->getName() << "." << sink_port->getName() << RTT::endlog();
-          } else {
-            RTT::log(RTT::Error) << "Could not create DFG edge "
-              << source_block->getName() << "." << source_port->getName() << " --> "
-              << sink_block->getName() << "." << sink_port->getName() << RTT::endlog();
-          }
-        }
+bool Scheme::enableBlocks(
+    const std::vector<conman::BlockID> &block_ids,
+    const bool strict,
+    const bool force)
+{
+  using namespace conman::graph;
 
-        // Check if this connection is already modeled in the data flow edge
-        bool connection_exists = false;
-        std::vector<DataFlowEdge::Connection>::const_iterator edge_connection_it;
-        for(edge_connection_it = flow_edge->connections.begin();
-            edge_connection_it != flow_edge->connections.end();
-            ++edge_connection_it) 
-        {
-          if( edge_connection_it->source_port == source_port &&
-              edge_connection_it->sink_port == sink_port) 
-          {
-            connection_exists = true;
-            break;
-          }
-        }
+  // Get the blocks in the blocks and groups
+  if(!this->getBlockSet(block_ids, id_block_set_) && strict) {
+    RTT::log(RTT::Error) << "Could not enable blocks because some IDs are not in the scheme." << RTT::endlog();
+    return false;
+  }
 
-        // Store the data flow connection in the edge if it doesn't already exist
-        if(!connection_exists) {
-          flow_edge->connections.push_back(
-              DataFlowEdge::Connection(
-                  source_service, source_port,
-                  sink_service, sink_port));
-        }
+  // Get the running blocks which conflict with the blocks to be enabled
+  this->getConflictSet(id_block_set_, id_conflict_set_);
+  this->syncRunningBlocks(id_conflict_set_);
+  id_conflict_set_ &= running_blocks_;
 
-        // Check if either of the blocks involved in this connection are latched
-        if(source_vertex->latched_output || sink_vertex->latched_input) {
-          flow_edge->latched = true;
-        }
+  if(!force) {
+    if(id_conflict_set_.any()) {
+      RTT::log(RTT::Error) << "Could not enable block because it has conflicts which will not be force-disabled." << RTT::endlog();
+      return false;
+    }
+  } else {
+    // Disable all of the conflicting blocks which aren't going to be enabled
+    id_conflict_set_ -= id_block_set_;
 
-        // Get the source and sink exec vertex descriptors
-        DataFlowVertexDescriptor exec_source_desc = exec_vertex_map_[source_block];
-        DataFlowVertexDescriptor exec_sink_desc = exec_vertex_map_[sink_block];
-
-        // Get the edge in the exec graph
-        DataFlowEdgeDescriptor exec_edge_desc;
-        bool exec_edge_found;
-        boost::tie(exec_edge_desc, exec_edge_found) = boost::edge(
-            exec_source_desc,
-            exec_sink_desc,
-            exec_graph_);
-
-        if(flow_edge->latched) {
-          if(exec_edge_found) {
-            // Remove the edge from the exec graph
-            boost::remove_edge(exec_edge_desc, exec_graph_);
-            topology_modified = true;
-          }
-        } else {
-          if(!exec_edge_found) {
-            // Add the edge to the exec graph
-            bool edge_added;
-            boost::tie(exec_edge_desc,edge_added) = boost::add_edge(
-                exec_source_desc,
-                exec_sink_desc,
-                flow_edge,
-                exec_graph_);
-            topology_modified = true;
-          }
-        }
+    for(ConflictSet::size_type b = id_conflict_set_.find_first(); b != ConflictSet::npos; b = id_conflict_set_.find_next(b)) {
+      if(!this->disableVertex(block_indices_[b]) && strict) {
+        return false;
       }
     }
   }
 
-  // Recompute the execution schedule if the topology changed
-  if(topology_modified) {
-    if(this->computeSchedule(exec_graph_, exec_ordering_, true)) {
-      RTT::log(RTT::Debug) << "Regenerated topological ordering." << RTT::endlog();
+  // Enable the blocks in the order that they were given
+  bool success = true;
+
+  for(std::vector<conman::BlockID>::const_iterator it = block_ids.begin();
+      it != block_ids.end();
+      ++it)
+  {
+    if(*it < id_vertices_.size() && id_vertices_[*it]) {
+      success = this->enableVertex(id_vertices_[*it], force) && success;
+    } else if(const GroupExpansion *expansion = this->expandGroup(*it)) {
+      for(ConflictSet::size_type b = expansion->blocks.find_first(); b != ConflictSet::npos; b = expansion->blocks.find_next(b)) {
+        success = this->enableVertex(block_indices_[b], force) && success;
+        if(!success && strict) { return false; }
+      }
     } else {
-      RTT::log(RTT::Debug) << "Could not regenerate the topological ordering." << RTT::endlog();
-      return false;
+      success = false;
     }
+
+    // Break on failure if strict
+    if(!success && strict) { return false; }
   }
 
-  return true;
+  return success;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-
-bool Scheme::enableBlock(const std::string &block_name, const bool force)
+bool Scheme::disableBlocks(
+    const std::vector<conman::BlockID> &block_ids,
+    const bool strict)
 {
-  RTT::Logger::In in("Scheme::enableBlock");
+  using namespace conman::graph;
 
-  // First check if this block is a group
-  conman::GroupMap::iterator group = 
-    block_groups_.find(block_name);
+  bool success = true;
 
-  if(group != block_groups_.end()) {
-    // Enable the blocks in this group
-    RTT::log(RTT::Debug) << "Enabling blocks in group \"" << block_name <<"\"" << RTT::endlog();
-    return this->enableBlocks(
-        std::vector<std::string>(group->second.begin(),group->second.end()),
-        true,
-        force);
+  for(std::vector<conman::BlockID>::const_iterator it = block_ids.begin();
+      it != block_ids.end();
+      ++it)
+  {
+    if(*it < id_vertices_.size() && id_vertices_[*it]) {
+      success &= this->disableVertex(id_vertices_[*it]);
+    } else if(const GroupExpansion *expansion = this->expandGroup(*it)) {
+      for(ConflictSet::size_type b = expansion->blocks.find_first(); b != ConflictSet::npos; b = expansion->blocks.find_next(b)) {
+        success &= this->disableVertex(block_indices_[b]);
+      }
+    } else {
+      success = false;
+    }
+
+    // Break on failure if strict
+    if(!success && strict) { return false; }
   }
 
-  // Enable the block by name
-  return this->enableBlock(this->getPeer(block_name), force);
+  return success;
 }
 
-bool Scheme::enableBlock(RTT::TaskContext *block, const bool force)
+bool Scheme::switchBlocks(
+    const std::vector<conman::BlockID> &disable_block_ids,
+    const std::vector<conman::BlockID> &enable_block_ids,
+    const bool strict,
+    const bool force)
 {
   using namespace conman::graph;
 
-  RTT::Logger::In in("Scheme::enableBlock");
+  // Don't disable blocks that are about to be enabled
+  bool success = this->getBlockSet(disable_block_ids, id_conflict_set_);
+  success &= this->getBlockSet(enable_block_ids, id_block_set_);
 
-  if(block == NULL) { 
-    RTT::log(RTT::Error) << "Could not enable block because the given block is NULL." << RTT::endlog();
-    return false; 
+  if(!success && strict) { return false; }
+
+  id_conflict_set_ -= id_block_set_;
+
+  for(ConflictSet::size_type b = id_conflict_set_.find_first(); b != ConflictSet::npos; b = id_conflict_set_.find_next(b)) {
+    // Try to disable the block
+    success &= this->disableVertex(block_indices_[b]);
+
+    // Break on failure if strict
+    if(!success && strict) { return false; }
   }
 
-  const std::string &block_name = block->getName();
-  std::map<std::string,conman::graph::DataFlowVertex::Ptr>::const_iterator block_vertex_it = blocks_.find(block_name);
+  // First disable blocks, so that "force" can be used appropriately when
+  // enabling blocks.
+  return this->enableBlocks(enable_block_ids, strict, force) && success;
+}
 
-  RTT::log(RTT::Debug) << "Enabling block \"" << block_name <<"\"" << RTT::endlog();
+bool Scheme::getExecutionOrder(std::vector<conman::BlockID> &order) const
+{
+  order.clear();
 
-  if(block_vertex_it == blocks_.end()) {
-    RTT::log(RTT::Error) << "Could not enable block \""<< block_name << "\""
-      " because it has not been added to the scheme." << RTT::endlog();
+  // Check if the current ordering is valid
+  if(exec_ordering_version_ != model_version_ || exec_ordering_.size() != block_indices_.size()) {
     return false;
   }
 
-  DataFlowVertex::Ptr block_vertex = block_vertex_it->second;
+  for(conman::graph::ExecutionOrdering::const_iterator it = exec_ordering_.begin();
+      it != exec_ordering_.end();
+      ++it)
+  {
+    order.push_back(exec_graph_[*it]->id);
+  }
 
-  // Make sure the block is configured
-  if(!block->isConfigured()) {
-    RTT::log(RTT::Error) << "Could not enable block \""<< block_name << "\""
-      " because it has not been confiugre()ed." << RTT::endlog();
+  return true;
+}
+
+bool Scheme::isEnabled(const conman::BlockID id) const
+{
+  return id < id_vertices_.size() && id_vertices_[id] && id_vertices_[id]->block->isRunning();
+}
+
+bool Scheme::getBlockStats(
+    const conman::BlockID id,
+    conman::BlockStats &stats) const
+{
+  if(id >= id_vertices_.size() || !id_vertices_[id]) {
     return false;
   }
 
-  // Check if the block is already enabled
-  if(block->getTaskState() == RTT::TaskContext::Running) {
-    // If it's already running, then we're going to assume for now that the
-    // user isn't doing anything dirty.
-    // TODO: Keep track of whether or not a block has been properly enabled.
-    RTT::log(RTT::Debug) << "The block \"" << block_name <<"\" is already enabled." << RTT::endlog();
-    return true;
-  }
+  const conman::Hook::Ptr &hook = id_vertices_[id]->hook;
 
-  // Get the blocks that conflict with this block
-  ConflictAdjacencyIterator conflict_it, conflict_end;
+  stats.period = hook->getPeriod();
+  stats.period_avg = hook->getPeriodAvg();
+  stats.period_max = hook->getPeriodMax();
+  stats.duration = hook->getDuration();
+  stats.duration_avg = hook->getDurationAvg();
+  stats.duration_max = hook->getDurationMax();
 
-  boost::tie(conflict_it, conflict_end) =
-    boost::adjacent_vertices(conflict_vertex_map_[block], conflict_graph_);
+  return true;
+}
 
-  // Check if conflicting blocks are running
-  for(; conflict_it != conflict_end; ++conflict_it)
-  {
-    RTT::TaskContext *&conflict_block = conflict_graph_[*conflict_it]->block;
+///////////////////////////////////////////////////////////////////////////////
 
-    // Check if the conflicting block is running
-    if(conflict_block->getTaskState() == RTT::TaskContext::Running) {
-      // If force is selected, disable the conflicting block
-      if(force) {
-        RTT::log(RTT::Info) << "Force-enabling block \""<< block_name << "\""
-          " involves disabling block \"" << conflict_block->getName() << "\""
-          << RTT::endlog();
+void Scheme::setDemandDriven(const bool demand_driven)
+{
+  demand_driven_ = demand_driven;
+  // Force the demanded blocks to be recomputed
+  demand_version_ = 0;
+}
 
-        // Make sure we can actually disable it
-        if(this->disableBlock(conflict_block) == false) {
-          RTT::log(RTT::Error) << "Could not disable block \"" <<
-            conflict_block->getName() << "\"" << RTT::endlog();
-          return false;
-        }
-      } else {
-        RTT::log(RTT::Error) << "Could not enable block \""<< block_name <<
-          "\" because it conflicts with block \"" << conflict_block->getName()
-          << "\"" << RTT::endlog();
-        return false;
-      }
-    }
-  }
+bool Scheme::isDemandDriven() const
+{
+  return demand_driven_;
+}
 
-  // Initialize the hook
-  block_vertex->hook->init(last_update_time_);
+bool Scheme::setRequired(const std::string &block_name, const bool required)
+{
+  RTT::Logger::In in("Scheme::setRequired");
 
-  // Try to start the block
-  if(!block->start()) {
-    RTT::log(RTT::Error) << "Could not enable block \""<< block_name << "\""
-      " because it could not be start()ed." << RTT::endlog();
+  std::vector<std::string> members;
+  if(!this->getGroupMembers(block_name, members)) {
+    RTT::log(RTT::Error) << "Could not mark \"" << block_name << "\" as "
+      "required because it is not a block or group in this scheme." << RTT::endlog();
     return false;
   }
 
+  for(std::vector<std::string>::const_iterator it = members.begin();
+      it != members.end();
+      ++it)
+  {
+    required_blocks_[blocks_[*it]->index] = required;
+  }
+
+  // Force the demanded blocks to be recomputed
+  demand_version_ = 0;
+
   return true;
 }
 
-bool Scheme::disableBlock(const std::string &block_name)
+bool Scheme::isRequired(const std::string &block_name) const
 {
-  // First check if this block is a group
-  std::map<std::string, std::set<std::string> >::iterator group = 
-    block_groups_.find(block_name);
-
-  if(group != block_groups_.end()) {
-    // Enable the blocks in this group
-    return this->disableBlocks(
-        std::vector<std::string>(group->second.begin(),group->second.end()),
-        true);
-  }
+  std::map<std::string, conman::graph::DataFlowVertex::Ptr>::const_iterator block_it =
+    blocks_.find(block_name);
 
-  // Disable the block by name
-  return this->disableBlock(this->getPeer(block_name));
+  return block_it != blocks_.end() && required_blocks_.test(block_it->second->index);
 }
 
-bool Scheme::disableBlock(RTT::TaskContext* block) 
+bool Scheme::isDemanded(const std::string &block_name) const
 {
-  if(block == NULL) { return false; }
+  std::map<std::string, conman::graph::DataFlowVertex::Ptr>::const_iterator block_it =
+    blocks_.find(block_name);
 
-  // Stop a block
-  if(block->isRunning()) {
-    if(!block->stop()) {
-      RTT::log(RTT::Error) 
-        << "Could not disable block \""<< block->getName() << "\" because it"
-        " could not be stop()ed." << RTT::endlog();
-      return false;
-    }
+  if(block_it == blocks_.end()) {
+    return false;
   }
 
-  return true;
-}
+  this->updateDemand();
 
-/*
- *bool Scheme::enableBlocks(
- *    const std::set<std::string> &block_names,
- *    const bool strict,
- *    const bool force)
- *{
- *  for(std::set<std::string>::const_iterator it = block_names.begin();
- *      it != block_names.end();
- *      ++it)
- *  { 
- *  }
- *}
- */
+  return demanded_blocks_.test(block_it->second->index);
+}
 
-bool Scheme::enableable(
-    const std::string &block_name) const
+void Scheme::updateDemand() const
 {
   using namespace conman::graph;
 
-  // Make sure the block is in the scheme
-  if(this->hasBlock(block_name)) {
-    // Get the blocks that conflict with this block
-    ConflictAdjacencyIterator conflict_it, conflict_end;
+  // Check if the demanded blocks are up-to-date
+  if(demand_version_ == model_version_ && demand_running_blocks_ == running_blocks_) {
+    return;
+  }
+
+  demanded_blocks_.resize(block_indices_.size());
+  demanded_blocks_.reset();
+  demand_stack_.clear();
+
+  // Running sinks and required blocks are demanded
+  for(unsigned int index = 0; index < block_indices_.size(); index++) {
+    if(!running_blocks_.test(index)) {
+      continue;
+    }
+
+    const DataFlowVertexDescriptor vertex = 
+      flow_vertex_map_.find(block_indices_[index]->block)->second;
+
+    if(required_blocks_.test(index) || boost::out_degree(vertex, flow_graph_) == 0) {
+      demanded_blocks_.set(index);
+      demand_stack_.push_back(index);
+    }
+  }
 
-    boost::tie(conflict_it, conflict_end) =
-      boost::adjacent_vertices(
-          this->getConflictVertex(
-              this->getBlockVertex(block_name)->block), conflict_graph_);
+  // Running blocks which feed demanded blocks are demanded
+  while(!demand_stack_.empty()) {
+    const DataFlowVertexDescriptor vertex = 
+      flow_vertex_map_.find(block_indices_[demand_stack_.back()]->block)->second;
+    demand_stack_.pop_back();
 
-    // Check if conflicting blocks are running
-    for(; conflict_it != conflict_end; ++conflict_it)
+    DataFlowInEdgeIterator in_edge_it, in_edge_end;
+    for(boost::tie(in_edge_it, in_edge_end) = boost::in_edges(vertex, flow_graph_);
+        in_edge_it != in_edge_end;
+        ++in_edge_it)
     {
-      RTT::TaskContext *&conflict_block = conflict_graph_[*conflict_it]->block;
+      const unsigned int source_index = 
+        flow_graph_[boost::source(*in_edge_it, flow_graph_)]->index;
 
-      // Check if the conflicting block is running
-      if(conflict_block->getTaskState() == RTT::TaskContext::Running) {
-        return false;
+      if(running_blocks_.test(source_index) && !demanded_blocks_.test(source_index)) {
+        demanded_blocks_.set(source_index);
+        demand_stack_.push_back(source_index);
       }
     }
-  } else if(this->hasGroup(block_name)) {
-    // Enable a group
-    if(!this->enableable(this->getGroupMembers(block_name))) {
-      return false;
-    }
-  } else {
-    RTT::log(RTT::Error) << "Could not check block or group for conflicts named \"" << block_name << "\" because it is not in the scheme." << RTT::endlog();
   }
 
-  return true;
+  demand_running_blocks_ = running_blocks_;
+  demand_version_ = model_version_;
 }
 
-bool Scheme::enableable(
-    const std::vector<std::string> &block_names) const
+/** \brief Get the policy of the connection between two ports
+ *
+ * Returns false if the ports aren't connected.
+ */
+static bool GetConnectionPolicy(
+    RTT::base::PortInterface *source_port,
+    RTT::base::PortInterface *sink_port,
+    RTT::ConnPolicy &policy)
 {
-  for(std::vector<std::string>::const_iterator it = block_names.begin();
-      it != block_names.end();
-      ++it)
-  {
-    if(!enableable(*it)) {
-      return false;
+  std::list<RTT::internal::ConnectionManager::ChannelDescriptor> channels = source_port->getManager()->getChannels();
+  std::list<RTT::internal::ConnectionManager::ChannelDescriptor>::iterator channel_it;
+
+  for(channel_it = channels.begin(); channel_it != channels.end(); ++channel_it) {
+    RTT::base::ChannelElementBase::shared_ptr connection = channel_it->get<1>();
+    if(connection->getOutputEndPoint()->getPort() == sink_port) {
+      policy = channel_it->get<2>();
+      return true;
     }
   }
 
+  return false;
+}
+
+//! Replace the connection between two ports with one with a new policy
+static bool Reconnect(
+    RTT::base::PortInterface *source_port,
+    RTT::base::PortInterface *sink_port,
+    const RTT::ConnPolicy &policy)
+{
+  source_port->disconnect(sink_port);
+  if(!source_port->connectTo(sink_port, policy)) {
+    RTT::log(RTT::Error) << "Could not reconnect "
+      << source_port->getInterface()->getOwner()->getName() << "." << source_port->getName() << " --> "
+      << sink_port->getInterface()->getOwner()->getName() << "." << sink_port->getName() << RTT::endlog();
+    return false;
+  }
+
   return true;
 }
 
-bool Scheme::enableBlocks(
-    const std::vector<std::string> &block_names,
-    const bool strict,
-    const bool force)
+bool Scheme::setLocalConnections(const bool local)
 {
   using namespace conman::graph;
 
-  // First make sure all the blocks can be enabled before actually trying to enable them
-  if(!force) {
-    if(!this->enableable(block_names)) {
-      RTT::log(RTT::Error) << "Could not enable block because it has conflicts which will not be force-disabled." << RTT::endlog();
-      return false;
-    }
-  }
+  RTT::Logger::In in("Scheme::setLocalConnections");
+
+  local_connections_ = local;
 
-  // Enable the blocks
   bool success = true;
 
-  for(std::vector<std::string>::const_iterator it = block_names.begin();
-      it != block_names.end();
-      ++it)
+  // Reconnect each connection modeled in the DFG
+  DataFlowEdgeIterator edge_it, edge_end;
+  for(boost::tie(edge_it, edge_end) = boost::edges(flow_graph_);
+      edge_it != edge_end;
+      ++edge_it)
   {
-    // Try to start the block
-    success = this->enableBlock(*it,force) && success;
+    const DataFlowEdge::Ptr edge = flow_graph_[*edge_it];
 
-    // Break on failure if strict
-    if(!success && strict) { return false; }
+    for(std::vector<DataFlowEdge::Connection>::const_iterator conn_it = edge->connections.begin();
+        conn_it != edge->connections.end();
+        ++conn_it)
+    {
+      success &= this->localizeConnection(conn_it->source_port, conn_it->sink_port, local);
+    }
   }
 
   return success;
 }
 
-bool Scheme::disableBlocks(const bool strict)
+bool Scheme::hasLocalConnections() const
 {
-  bool success = true;
+  return local_connections_;
+}
 
-  for(std::map<std::string,graph::DataFlowVertex::Ptr>::const_iterator it = blocks_.begin();
-      it != blocks_.end();
-      ++it)
-  {
-    // Try to disable the block
-    success &= this->disableBlock(it->second->block);
+bool Scheme::localizeConnection(
+    RTT::base::PortInterface *source_port,
+    RTT::base::PortInterface *sink_port,
+    const bool local)
+{
+  const std::pair<RTT::base::PortInterface*, RTT::base::PortInterface*> key(source_port, sink_port);
+  std::map<std::pair<RTT::base::PortInterface*, RTT::base::PortInterface*>, int>::iterator local_it =
+    local_lock_policies_.find(key);
 
-    // Break on failure if strict
-    if(!success && strict) { return false; }
+  // Check if the connection is already in the requested state
+  if(local == (local_it != local_lock_policies_.end())) {
+    return true;
   }
 
-  return success;
+  // Get the current policy of the connection
+  RTT::ConnPolicy policy;
+  if(!GetConnectionPolicy(source_port, sink_port, policy)) {
+    // The connection no longer exists
+    if(!local) {
+      local_lock_policies_.erase(local_it);
+    }
+    return !local;
+  }
+
+  if(local) {
+    // Nothing to do if it's already unsynchronized
+    if(policy.lock_policy == RTT::ConnPolicy::UNSYNC) {
+      return true;
+    }
+    local_lock_policies_[key] = policy.lock_policy;
+    policy.lock_policy = RTT::ConnPolicy::UNSYNC;
+  } else {
+    policy.lock_policy = local_it->second;
+    local_lock_policies_.erase(local_it);
+  }
+
+  // Carry the source's last written sample over into the new channel
+  policy.init = true;
+
+  return Reconnect(source_port, sink_port, policy);
 }
 
-bool Scheme::disableBlocks(
-    const std::vector<std::string> &block_names,
-    const bool strict)
+int Scheme::optimizeConnections(
+    const bool apply,
+    std::vector<conman::ConnectionRecommendation> &recommendations)
 {
-  bool success = true;
+  using namespace conman::graph;
 
-  for(std::vector<std::string>::const_iterator it = block_names.begin();
-      it != block_names.end();
-      ++it)
-  {
-    // Try to disable the block
-    success &= this->disableBlock(*it);
+  RTT::Logger::In in("Scheme::optimizeConnections");
 
-    // Break on failure if strict
-    if(!success && strict) { return false; }
+  // Connections can only be rewired safely while the blocks aren't executing
+  if(apply && this->isRunning()) {
+    RTT::log(RTT::Error) << "Connection policies can only be applied while "
+      "the scheme is stopped." << RTT::endlog();
+    return -1;
   }
 
-  return success;
-}
-
-bool Scheme::switchBlocks(
-    const std::vector<std::string> &disable_block_names,
-    const std::vector<std::string> &enable_block_names,
-    const bool strict,
-    const bool force)
-{
+  recommendations.clear();
 
+  int n_changes = 0;
   bool success = true;
 
-  for(std::vector<std::string>::const_iterator it = disable_block_names.begin();
-      it != disable_block_names.end();
-      ++it)
+  DataFlowEdgeIterator edge_it, edge_end;
+  for(boost::tie(edge_it, edge_end) = boost::edges(flow_graph_);
+      edge_it != edge_end;
+      ++edge_it)
   {
-    // Don't disable a blcok that's about to be enabled
-    if(std::find(enable_block_names.begin(), enable_block_names.end(), *it) == enable_block_names.end()) {
-      // Try to disable the block
-      success &= this->disableBlock(*it);
+    const DataFlowVertex::Ptr 
+      source_vertex = flow_graph_[boost::source(*edge_it, flow_graph_)],
+      sink_vertex = flow_graph_[boost::target(*edge_it, flow_graph_)];
+
+    // Get the number of samples the source can write between sink updates
+    // (blocks run at most once per scheme update)
+    const RTT::Seconds
+      scheme_period = this->getPeriod(),
+      source_period = std::max(source_vertex->hook->getDesiredMinPeriod(), scheme_period),
+      sink_period = std::max(sink_vertex->hook->getDesiredMinPeriod(), scheme_period);
+
+    int n_samples = 1;
+    if(sink_period > source_period) {
+      // The rate ratio is unknown if the scheme isn't periodic
+      n_samples = (source_period > 0.0) ? static_cast<int>(std::ceil(sink_period / source_period)) : 0;
+    }
 
-      // Break on failure if strict
-      if(!success && strict) { return false; }
+    const DataFlowEdge::Ptr edge = flow_graph_[*edge_it];
+    for(std::vector<DataFlowEdge::Connection>::const_iterator conn_it = edge->connections.begin();
+        conn_it != edge->connections.end();
+        ++conn_it)
+    {
+      conman::ConnectionRecommendation recommendation;
+      if(!GetConnectionPolicy(conn_it->source_port, conn_it->sink_port, recommendation.policy)) {
+        continue;
+      }
+
+      recommendation.source = source_vertex->block->getName() + "." + conn_it->source_port->getName();
+      recommendation.sink = sink_vertex->block->getName() + "." + conn_it->sink_port->getName();
+      recommendation.recommended = recommendation.policy;
+      recommendation.undersized = false;
+
+      // The scheme executes both blocks, so no synchronization is needed
+      recommendation.recommended.lock_policy = RTT::ConnPolicy::UNSYNC;
+
+      if(recommendation.policy.type != RTT::ConnPolicy::DATA) {
+        if(n_samples == 1) {
+          // There is at most one sample per sink update, so only the newest
+          // sample is needed
+          recommendation.recommended.type = RTT::ConnPolicy::DATA;
+          recommendation.recommended.size = 0;
+        } else if(n_samples > 1) {
+          // The buffer needs to hold all of the samples written between sink
+          // updates
+          recommendation.recommended.size = n_samples;
+          recommendation.undersized = n_samples > recommendation.policy.size;
+        }
+      }
+
+      const bool changed = 
+        recommendation.recommended.lock_policy != recommendation.policy.lock_policy ||
+        recommendation.recommended.type != recommendation.policy.type ||
+        recommendation.recommended.size != recommendation.policy.size;
+
+      if(changed) {
+        n_changes++;
+
+        if(apply) {
+          // Remember the original lock policy so that it can be restored if
+          // either block is removed from the scheme
+          const std::pair<RTT::base::PortInterface*, RTT::base::PortInterface*> 
+            key(conn_it->source_port, conn_it->sink_port);
+          if(local_lock_policies_.find(key) == local_lock_policies_.end() &&
+             recommendation.policy.lock_policy != RTT::ConnPolicy::UNSYNC)
+          {
+            local_lock_policies_[key] = recommendation.policy.lock_policy;
+          }
+
+          success &= Reconnect(conn_it->source_port, conn_it->sink_port, recommendation.recommended);
+        }
+      }
+
+      recommendations.push_back(recommendation);
     }
   }
 
-  // First disable blocks, so that "force" can be used appropriately when
-  // enabling blocks.
-  bool enable_success = this->enableBlocks(enable_block_names, strict, force);
-
-  return success;
+  return success ? n_changes : -1;
 }
 
-bool Scheme::setEnabledBlocks(
-    const std::vector<std::string> &enabled_block_names,
-    const bool strict)
+int Scheme::optimizeConnections(const bool apply)
 {
-  bool disable_success = this->disableBlocks(strict);
-  bool enable_success = this->enableBlocks(enabled_block_names, strict, false);
+  RTT::Logger::In in("Scheme::optimizeConnections");
 
-  return disable_success && enable_success;
-}
+  std::vector<conman::ConnectionRecommendation> recommendations;
+  const int n_changes = this->optimizeConnections(apply, recommendations);
 
-///////////////////////////////////////////////////////////////////////////////
+  for(std::vector<conman::ConnectionRecommendation>::const_iterator it = recommendations.begin();
+      it != recommendations.end();
+      ++it)
+  {
+    if(it->undersized) {
+      RTT::log(RTT::Warning) << "The buffer of size " << it->policy.size
+        << " on " << it->source << " --> " << it->sink << " can overflow, "
+        "it should have size " << it->recommended.size << "." << RTT::endlog();
+    } else if(it->recommended.type != it->policy.type) {
+      RTT::log(RTT::Info) << "Only the newest sample is read from "
+        << it->source << " --> " << it->sink << ", it can be a data "
+        "connection." << RTT::endlog();
+    }
+  }
+
+  return n_changes;
+}
 
 bool Scheme::configureHook()
 {
@@ -1808,7 +5088,13 @@ bool Scheme::configureHook()
 
 bool Scheme::startHook()
 {
-  if(!this->regenerateModel()) {
+  if(edit_depth_ > 0) {
+    RTT::log(RTT::Error) << "Cannot start the scheme while a transaction is open." << RTT::endlog();
+    return false;
+  }
+
+  // Only model the connections which changed since the last update
+  if(!this->updateModel()) {
     return false;
   } else {
     return true;
@@ -1836,6 +5122,11 @@ void Scheme::updateHook()
   min_exec_period_ = std::min(min_exec_period_,last_exec_period_);
   max_exec_period_ = std::max(max_exec_period_,last_exec_period_);
 
+  // Determine which blocks contribute to a sink
+  if(demand_driven_) {
+    this->updateDemand();
+  }
+
   // Execute the blocks in the appropriate order
   for(ExecutionOrdering::iterator block_it = exec_ordering_.begin();
       block_it != exec_ordering_.end();
@@ -1846,9 +5137,12 @@ void Scheme::updateHook()
 
     // Get the state of the task
     const RTT::base::TaskCore::TaskState block_state = block_vertex->block->getTaskState();
+    running_blocks_[block_vertex->index] = (block_state == RTT::TaskContext::Running);
 
-    // Check if the task is running 
-    if(block_state == RTT::TaskContext::Running) { 
+    // Check if the task is running and something depends on it
+    if(block_state == RTT::TaskContext::Running &&
+       (!demand_driven_ || demanded_blocks_.test(block_vertex->index)))
+    {
 
       // Update the task
       if(!block_vertex->hook->update(time)) {
@@ -0,0 +1,483 @@
+/** Copyright (c) 2013, Jonathan Bohren, all rights reserved.
+ * This software is released under the BSD 3-clause license, for the details of
+ * this license, please see LICENSE.txt at the root of this repository.
+ */
+
+#include <conman/scheme_fork.h>
+#include <conman/hook.h>
+
+using namespace conman;
+
+SchemeFork::SchemeFork(
+    Model::ConstPtr model,
+    const std::vector<bool> &enabled) :
+  model_(model),
+  enabled_(enabled)
+{
+}
+
+SchemeFork::Model& SchemeFork::editModel()
+{
+  // Copy the model if anything else refers to it
+  if(!model_.unique()) {
+    model_ = boost::make_shared<Model>(*model_);
+  }
+
+  return const_cast<Model&>(*model_);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool SchemeFork::hasBlock(const std::string &block_name) const
+{
+  return model_->indices.find(block_name) != model_->indices.end();
+}
+
+std::vector<std::string> SchemeFork::getBlocks() const
+{
+  std::vector<std::string> block_names;
+
+  for(std::map<std::string, unsigned int>::const_iterator it = model_->indices.begin();
+      it != model_->indices.end();
+      ++it)
+  {
+    block_names.push_back(it->first);
+  }
+
+  return block_names;
+}
+
+bool SchemeFork::getGroupMembers(
+    const std::string &group_name,
+    std::vector<std::string> &members)
+  const
+{
+  // Expand the group recursively
+  std::set<std::string> member_set, visited;
+  bool success = this->getGroupMembers(group_name, member_set, visited);
+
+  // Copy the set to vector
+  members.assign(member_set.begin(), member_set.end());
+
+  return success;
+}
+
+bool SchemeFork::getGroupMembers(
+    const std::string &name,
+    std::set<std::string> &member_set,
+    std::set<std::string> &visited)
+  const
+{
+  // Avoid loops in group membership
+  if(!visited.insert(name).second) {
+    return true;
+  }
+
+  // Check if the group is a single block
+  if(this->hasBlock(name)) {
+    member_set.insert(name);
+    return true;
+  }
+
+  // Check if the group exists
+  GroupMap::const_iterator group = model_->groups.find(name);
+  if(group == model_->groups.end()) {
+    return false;
+  }
+
+  bool success = true;
+  for(std::set<std::string>::const_iterator it=group->second.begin();
+      it != group->second.end();
+      ++it)
+  {
+    success &= this->getGroupMembers(*it, member_set, visited);
+  }
+
+  return success;
+}
+
+bool SchemeFork::addBlock(RTT::TaskContext *new_block)
+{
+  using namespace conman::graph;
+
+  RTT::Logger::In in("SchemeFork::addBlock");
+
+  // Nulls are bad
+  if(new_block == NULL) {
+    RTT::log(RTT::Error) << "Requested block to add is NULL." << RTT::endlog();
+    return false;
+  }
+
+  const std::string block_name = new_block->getName();
+
+  if(this->hasBlock(block_name)) {
+    RTT::log(RTT::Error) << "A block named \"" << block_name << "\" is already "
+      "in the fork." << RTT::endlog();
+    return false;
+  }
+
+  // Don't load the hook service, since this would modify the block
+  if(!conman::Hook::HasHook(new_block)) {
+    RTT::log(RTT::Error) << "Requested block to add does not have the conman"
+      " hook service." << RTT::endlog();
+    return false;
+  }
+
+  Model &model = this->editModel();
+
+  // Create the vertex properties
+  DataFlowVertex::Ptr new_vertex = boost::make_shared<DataFlowVertex>();
+  new_vertex->index = model.vertices.size();
+  new_vertex->latched_input = false;
+  new_vertex->latched_output = false;
+  new_vertex->block = new_block;
+  new_vertex->hook = conman::Hook::GetHook(new_block);
+
+  const unsigned int new_index = new_vertex->index;
+  model.indices[block_name] = new_index;
+  model.vertices.push_back(new_vertex);
+  model.conflicts.resize(model.vertices.size());
+  enabled_.resize(model.vertices.size(), false);
+
+  // Map from the blocks in the fork to their indices
+  std::map<RTT::TaskContext*, unsigned int> block_indices;
+  for(size_t i=0; i < model.vertices.size(); i++) {
+    block_indices[model.vertices[i]->block] = i;
+  }
+
+  // Sink ports which are connected to the new block
+  std::set<std::pair<unsigned int, RTT::base::PortInterface*> > sink_ports;
+
+  // Model the connections from every output port (including those of the new
+  // block) to or from the new block
+  for(size_t i=0; i < model.vertices.size(); i++) {
+    std::vector<RTT::base::PortInterface*> ports;
+    GetAllPorts(model.vertices[i]->block, ports);
+
+    for(std::vector<RTT::base::PortInterface*>::const_iterator port_it = ports.begin();
+        port_it != ports.end();
+        ++port_it)
+    {
+      if(!dynamic_cast<const RTT::base::OutputPortInterface*>(*port_it)) {
+        continue;
+      }
+
+      std::list<RTT::internal::ConnectionManager::ChannelDescriptor> channels = (*port_it)->getManager()->getChannels();
+      std::list<RTT::internal::ConnectionManager::ChannelDescriptor>::iterator channel_it;
+
+      for(channel_it = channels.begin(); channel_it != channels.end(); ++channel_it)
+      {
+        RTT::base::ChannelElementBase::shared_ptr connection = channel_it->get<1>();
+
+        RTT::base::PortInterface
+          *source_port = connection->getInputEndPoint()->getPort(),
+          *sink_port = connection->getOutputEndPoint()->getPort();
+
+        if( source_port == NULL || source_port->getInterface() == NULL
+            || sink_port == NULL || sink_port->getInterface() == NULL)
+        {
+          continue;
+        }
+
+        std::map<RTT::TaskContext*, unsigned int>::const_iterator sink_it =
+          block_indices.find(sink_port->getInterface()->getOwner());
+
+        // Only model connections between blocks in the fork involving the new block
+        if(sink_it == block_indices.end() || (i != new_index && sink_it->second != new_index)) {
+          continue;
+        }
+
+        // Get the arc between these blocks, creating it if necessary
+        std::vector<Model::Arc>::iterator arc_it = model.arcs.begin();
+        for(; arc_it != model.arcs.end(); ++arc_it) {
+          if(arc_it->source == i && arc_it->sink == sink_it->second) {
+            break;
+          }
+        }
+
+        if(arc_it == model.arcs.end()) {
+          Model::Arc arc;
+          arc.source = i;
+          arc.sink = sink_it->second;
+          // Latch the arc if either block has its inputs or outputs latched
+          arc.latched =
+            model.vertices[i]->latched_output ||
+            model.vertices[sink_it->second]->latched_input;
+          arc_it = model.arcs.insert(model.arcs.end(), arc);
+        }
+
+        arc_it->connections.push_back(
+            DataFlowEdge::Connection(
+                source_port->getInterface()->getService(), source_port,
+                sink_port->getInterface()->getService(), sink_port));
+
+        sink_ports.insert(std::make_pair(sink_it->second, sink_port));
+      }
+    }
+  }
+
+  // All of the blocks connected to the same exclusive input port conflict
+  for(std::set<std::pair<unsigned int, RTT::base::PortInterface*> >::const_iterator sink_port_it = sink_ports.begin();
+      sink_port_it != sink_ports.end();
+      ++sink_port_it)
+  {
+    const DataFlowVertex::Ptr sink_vertex = model.vertices[sink_port_it->first];
+    const std::string sink_port_path = ResolvePortPath(sink_port_it->second);
+
+    if(sink_vertex->hook->getInputExclusivity(sink_port_path) != conman::Exclusivity::EXCLUSIVE) {
+      continue;
+    }
+
+    std::set<unsigned int> sources;
+    for(std::vector<Model::Arc>::const_iterator arc_it = model.arcs.begin();
+        arc_it != model.arcs.end();
+        ++arc_it)
+    {
+      for(std::vector<DataFlowEdge::Connection>::const_iterator conn_it = arc_it->connections.begin();
+          conn_it != arc_it->connections.end();
+          ++conn_it)
+      {
+        if(conn_it->sink_port == sink_port_it->second) {
+          sources.insert(arc_it->source);
+        }
+      }
+    }
+
+    for(std::set<unsigned int>::const_iterator a = sources.begin(); a != sources.end(); ++a) {
+      for(std::set<unsigned int>::const_iterator b = sources.begin(); b != sources.end(); ++b) {
+        if(*a != *b) {
+          model.conflicts[*a].insert(*b);
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+bool SchemeFork::latchConnections(
+    const std::string &source_name,
+    const std::string &sink_name,
+    const bool latch)
+{
+  // Self-loops are implicitly latched
+  if(source_name == sink_name) {
+    return true;
+  }
+
+  std::vector<std::string> sources, sinks;
+  if(!this->getGroupMembers(source_name, sources) || !this->getGroupMembers(sink_name, sinks)) {
+    return false;
+  }
+
+  // Collect the indices of the sinks
+  std::set<unsigned int> sink_indices;
+  for(std::vector<std::string>::const_iterator it = sinks.begin(); it != sinks.end(); ++it) {
+    sink_indices.insert(model_->indices.find(*it)->second);
+  }
+
+  Model &model = this->editModel();
+
+  // Latch the arcs between all sources and sinks
+  for(std::vector<std::string>::const_iterator it = sources.begin(); it != sources.end(); ++it) {
+    const unsigned int source = model.indices[*it];
+
+    for(std::vector<Model::Arc>::iterator arc_it = model.arcs.begin();
+        arc_it != model.arcs.end();
+        ++arc_it)
+    {
+      if(arc_it->source == source && sink_indices.count(arc_it->sink) > 0) {
+        arc_it->latched = latch;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool SchemeFork::enableBlock(const std::string &block_name, const bool force)
+{
+  RTT::Logger::In in("SchemeFork::enableBlock");
+
+  std::vector<std::string> members;
+  if(!this->getGroupMembers(block_name, members)) {
+    RTT::log(RTT::Error) << "Could not enable \"" << block_name << "\" because "
+      "it is not a block or group in the fork." << RTT::endlog();
+    return false;
+  }
+
+  bool success = true;
+  for(std::vector<std::string>::const_iterator it = members.begin(); it != members.end(); ++it) {
+    const unsigned int index = model_->indices.find(*it)->second;
+
+    if(enabled_[index]) {
+      continue;
+    }
+
+    // Make sure the block is configured
+    if(!model_->vertices[index]->block->isConfigured()) {
+      RTT::log(RTT::Error) << "Could not enable block \""<< *it << "\""
+        " because it has not been configure()ed." << RTT::endlog();
+      success = false;
+      continue;
+    }
+
+    // Check if conflicting blocks are enabled
+    const std::set<unsigned int> &conflicts = model_->conflicts[index];
+    bool conflicted = false;
+
+    for(std::set<unsigned int>::const_iterator conflict_it = conflicts.begin();
+        conflict_it != conflicts.end();
+        ++conflict_it)
+    {
+      if(enabled_[*conflict_it]) {
+        if(force) {
+          enabled_[*conflict_it] = false;
+        } else {
+          RTT::log(RTT::Error) << "Could not enable block \""<< *it <<
+            "\" because it conflicts with block \"" <<
+            model_->vertices[*conflict_it]->block->getName() << "\"" << RTT::endlog();
+          conflicted = true;
+        }
+      }
+    }
+
+    if(conflicted) {
+      success = false;
+    } else {
+      enabled_[index] = true;
+    }
+  }
+
+  return success;
+}
+
+bool SchemeFork::disableBlock(const std::string &block_name)
+{
+  std::vector<std::string> members;
+  if(!this->getGroupMembers(block_name, members)) {
+    return false;
+  }
+
+  for(std::vector<std::string>::const_iterator it = members.begin(); it != members.end(); ++it) {
+    enabled_[model_->indices.find(*it)->second] = false;
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool SchemeFork::computeOrdering(std::vector<unsigned int> &ordering) const
+{
+  const size_t n_blocks = model_->vertices.size();
+
+  // Get the unlatched arcs from each block and count the producers of each block
+  std::vector<std::vector<unsigned int> > successors(n_blocks);
+  std::vector<int> in_degrees(n_blocks, 0);
+
+  for(std::vector<Model::Arc>::const_iterator arc_it = model_->arcs.begin();
+      arc_it != model_->arcs.end();
+      ++arc_it)
+  {
+    if(!arc_it->latched) {
+      successors[arc_it->source].push_back(arc_it->sink);
+      in_degrees[arc_it->sink]++;
+    }
+  }
+
+  // Schedule the most recently readied block first, like the scheme does
+  std::set<std::pair<int, unsigned int> > ready;
+  for(size_t v=0; v < n_blocks; v++) {
+    if(in_degrees[v] == 0) {
+      ready.insert(std::make_pair(0, v));
+    }
+  }
+
+  ordering.clear();
+
+  for(int slot = 1; !ready.empty(); slot++) {
+    const unsigned int v = ready.begin()->second;
+    ready.erase(ready.begin());
+    ordering.push_back(v);
+
+    for(std::vector<unsigned int>::const_iterator it = successors[v].begin();
+        it != successors[v].end();
+        ++it)
+    {
+      if(--in_degrees[*it] == 0) {
+        ready.insert(std::make_pair(-slot, *it));
+      }
+    }
+  }
+
+  // Blocks on cycles are never readied
+  return ordering.size() == n_blocks;
+}
+
+bool SchemeFork::executable() const
+{
+  std::vector<unsigned int> ordering;
+  return this->computeOrdering(ordering);
+}
+
+bool SchemeFork::getExecutionOrder(std::vector<std::string> &order) const
+{
+  order.clear();
+
+  std::vector<unsigned int> ordering;
+  if(!this->computeOrdering(ordering)) {
+    return false;
+  }
+
+  for(std::vector<unsigned int>::const_iterator it = ordering.begin();
+      it != ordering.end();
+      ++it)
+  {
+    order.push_back(model_->vertices[*it]->block->getName());
+  }
+
+  return true;
+}
+
+bool SchemeFork::getConflicts(
+    const std::string &block_name,
+    std::vector<std::string> &conflicts)
+  const
+{
+  conflicts.clear();
+
+  std::map<std::string, unsigned int>::const_iterator index_it = model_->indices.find(block_name);
+  if(index_it == model_->indices.end()) {
+    return false;
+  }
+
+  const std::set<unsigned int> &block_conflicts = model_->conflicts[index_it->second];
+  for(std::set<unsigned int>::const_iterator it = block_conflicts.begin();
+      it != block_conflicts.end();
+      ++it)
+  {
+    conflicts.push_back(model_->vertices[*it]->block->getName());
+  }
+
+  return true;
+}
+
+bool SchemeFork::isEnabled(const std::string &block_name) const
+{
+  std::map<std::string, unsigned int>::const_iterator index_it = model_->indices.find(block_name);
+  return index_it != model_->indices.end() && enabled_[index_it->second];
+}
+
+std::vector<std::string> SchemeFork::getEnabledBlocks() const
+{
+  std::vector<std::string> block_names;
+
+  for(size_t i=0; i < enabled_.size(); i++) {
+    if(enabled_[i]) {
+      block_names.push_back(model_->vertices[i]->block->getName());
+    }
+  }
+
+  return block_names;
+}
@@ -0,0 +1,87 @@
+/** Copyright (c) 2013, Jonathan Bohren, all rights reserved.
+ * This software is released under the BSD 3-clause license, for the details of
+ * this license, please see LICENSE.txt at the root of this repository.
+ */
+
+#ifndef __CONMAN_TEST_ALLOCATION_COUNTER_H
+#define __CONMAN_TEST_ALLOCATION_COUNTER_H
+
+/** \file
+ * Heap allocation checks for the realtime paths in tests
+ *
+ * This replaces the global operator new and delete, so it should be included
+ * in exactly one translation unit of a test executable. Eigen allocates with
+ * malloc instead of operator new, so test executables which use Eigen should
+ * be built with EIGEN_RUNTIME_NO_MALLOC, which makes Eigen assert if it
+ * allocates while an AllocationCounter exists.
+ */
+
+#include <new>
+#include <cstdlib>
+
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+#include <Eigen/Core>
+#endif
+
+namespace conman {
+  namespace test {
+
+    //! The number of calls to operator new
+    static unsigned long n_allocations = 0;
+
+    /** \brief Count the heap allocations made while this exists
+     *
+     * If Eigen was built with EIGEN_RUNTIME_NO_MALLOC, it isn't allowed to
+     * allocate while this exists.
+     */
+    class AllocationCounter
+    {
+    public:
+      AllocationCounter() :
+        n_allocations_start_(n_allocations)
+      {
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+        Eigen::internal::set_is_malloc_allowed(false);
+#endif
+      }
+
+      ~AllocationCounter()
+      {
+#ifdef EIGEN_RUNTIME_NO_MALLOC
+        Eigen::internal::set_is_malloc_allowed(true);
+#endif
+      }
+
+      //! Get the number of calls to operator new since this was created
+      unsigned long count() const
+      {
+        return n_allocations - n_allocations_start_;
+      }
+
+    private:
+      const unsigned long n_allocations_start_;
+    };
+  }
+}
+
+// Dynamic exception specifications were removed in C++17
+#if __cplusplus >= 201103L
+#define CONMAN_THROW_BAD_ALLOC
+#define CONMAN_NOEXCEPT noexcept
+#else
+#define CONMAN_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define CONMAN_NOEXCEPT throw()
+#endif
+
+void* operator new(std::size_t size) CONMAN_THROW_BAD_ALLOC {
+  ++conman::test::n_allocations;
+  void *ptr = std::malloc(size ? size : 1);
+  if(ptr == NULL) { throw std::bad_alloc(); }
+  return ptr;
+}
+
+void operator delete(void *ptr) CONMAN_NOEXCEPT {
+  std::free(ptr);
+}
+
+#endif // ifndef __CONMAN_TEST_ALLOCATION_COUNTER_H
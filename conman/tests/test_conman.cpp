@@ -6,6 +6,12 @@
 #include <string>
 #include <vector>
 #include <iterator>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
 
 #include <rtt/os/startstop.h>
 
@@ -13,6 +19,7 @@
 #include <ocl/TaskBrowser.hpp>
 #include <ocl/LoggingService.hpp>
 #include <rtt/Logger.hpp>
+#include <rtt/Activity.hpp>
 #include <rtt/deployment/ComponentLoader.hpp>
 
 #include <boost/graph/adjacency_list.hpp>
@@ -21,6 +28,7 @@
 #include <conman/conman.h>
 #include <conman/scheme.h>
 #include <conman/hook.h>
+#include <conman/payload.h>
 
 #include <boost/assign/std/vector.hpp>
 using namespace boost::assign;
@@ -29,6 +37,9 @@ using namespace boost::assign;
 #include <gmock/gmock.h>
 using ::testing::ElementsAre;
 
+// Count heap allocations so that the realtime paths can be checked
+#include "allocation_counter.h"
+
 
 class InvalidBlock : public RTT::TaskContext {
 public:
@@ -43,6 +54,15 @@ public:
   boost::shared_ptr<conman::Hook> conman_hook_;
 };
 
+class UnconfigurableBlock : public RTT::TaskContext {
+public:
+  UnconfigurableBlock(const std::string &name) : RTT::TaskContext(name) { 
+    conman_hook_ = conman::Hook::GetHook(this);
+  }
+  bool configureHook() { return false; }
+  boost::shared_ptr<conman::Hook> conman_hook_;
+};
+
 class IOBlock : public RTT::TaskContext {
 public:
   RTT::InputPort<double> in;
@@ -65,6 +85,18 @@ public:
   boost::shared_ptr<conman::Hook> conman_hook_;
 };
 
+class ContractBlock : public IOBlock {
+public:
+  ContractBlock(const std::string &name, const unsigned int dim) : IOBlock(name), dim_(dim) { }
+
+  // Declare the port dimension like the conman_blocks blocks do
+  bool configureHook() {
+    return conman_hook_->setPortDimension("in", dim_);
+  }
+
+  const unsigned int dim_;
+};
+
 class SchemeTest : public ::testing::Test {
 protected:
   SchemeTest() : scheme("Scheme") { }
@@ -184,6 +216,65 @@ public:
   ValidBlock vb3;
 };
 
+TEST_F(GroupsTest, ConfigureBlocks) {
+  std::vector<std::string> names;
+  std::vector<conman::ConfigureResult> report;
+
+  EXPECT_TRUE(scheme.setGroupMembers("win12","vb1"));
+  EXPECT_TRUE(scheme.addToGroup("vb2","win12"));
+  names += "win12", "vb3", "vb2";
+
+  EXPECT_TRUE(scheme.configureBlocks(names, 2, report));
+  ASSERT_EQ(3,report.size());
+  EXPECT_EQ("vb1",report[0].block);
+  EXPECT_TRUE(report[0].success);
+  EXPECT_TRUE(report[2].success);
+
+  // Failures are reported for each block
+  UnconfigurableBlock ub("ub");
+  EXPECT_TRUE(scheme.addBlock(&ub));
+  EXPECT_FALSE(scheme.configureBlocks("", 0));
+
+  names.push_back("ub");
+  EXPECT_FALSE(scheme.configureBlocks(names, 0, report));
+  ASSERT_EQ(4,report.size());
+  EXPECT_FALSE(report[0].success);
+  EXPECT_EQ("ub",report[0].block);
+  EXPECT_TRUE(report[1].success);
+
+  EXPECT_TRUE(scheme.removeBlock("ub"));
+
+  // Running blocks are skipped
+  names.pop_back();
+  EXPECT_TRUE(vb3.start());
+  EXPECT_TRUE(scheme.configureBlocks(names, 0, report));
+  ASSERT_EQ(3,report.size());
+  EXPECT_EQ("vb3",report[2].block);
+  EXPECT_TRUE(report[2].success);
+  EXPECT_TRUE(report[2].skipped);
+  EXPECT_FALSE(report[0].skipped);
+
+  // The report is also available as parallel lists
+  std::vector<std::string> configured_blocks;
+  std::vector<int> status;
+  std::vector<double> durations;
+  EXPECT_TRUE(scheme.configureBlocks(names, 0, configured_blocks, status, durations));
+  EXPECT_THAT(configured_blocks, ElementsAre("vb1", "vb2", "vb3"));
+  EXPECT_THAT(status, ElementsAre(
+        conman::ConfigureStatus::CONFIGURED,
+        conman::ConfigureStatus::CONFIGURED,
+        conman::ConfigureStatus::SKIPPED));
+  ASSERT_EQ(3,durations.size());
+  EXPECT_EQ(0.0,durations[2]);
+  EXPECT_TRUE(vb3.stop());
+
+  // Blocks can't be configured while the scheme is running
+  EXPECT_TRUE(scheme.start());
+  EXPECT_FALSE(scheme.configureBlocks(names, 0, report));
+  EXPECT_EQ(0,report.size());
+  scheme.stop();
+}
+
 TEST_F(GroupsTest, GetGroups) {
   EXPECT_FALSE(scheme.hasGroup("fail"));
 
@@ -241,6 +332,15 @@ TEST_F(GroupsTest, NestedGroups) {
 
   EXPECT_TRUE(scheme.getGroupMembers("win123",members_get));
   EXPECT_EQ(members_get.size(),3);
+
+  // Modifying a nested group modifies the groups which contain it
+  EXPECT_TRUE(scheme.removeGroup("win2"));
+  EXPECT_TRUE(scheme.getGroupMembers("win123",members_get));
+  EXPECT_THAT(members_get, ElementsAre("vb1","vb3"));
+
+  EXPECT_TRUE(scheme.addToGroup("vb2","win4"));
+  EXPECT_TRUE(scheme.getGroupMembers("win123",members_get));
+  EXPECT_THAT(members_get, ElementsAre("vb1","vb2","vb3"));
 }
 
 TEST_F(GroupsTest, RemoveFromGroups) {
@@ -348,6 +448,288 @@ TEST_F(DataFlowTest, Cyclic) {
   EXPECT_FALSE(scheme.executable());
 }
 
+TEST_F(DataFlowTest, UpdateModel) {
+  std::vector<std::vector<std::string> > flow_cycles;
+
+  // Connect blocks without cycles
+  ConnectBlocksAcyclic();
+  AddBlocks();
+
+  // Nothing changed since the blocks were added
+  const unsigned long version = scheme.getModelVersion();
+  EXPECT_TRUE(scheme.updateModel());
+  EXPECT_EQ(version,scheme.getModelVersion());
+
+  // Reconnecting a port to a different peer is modeled even though it has
+  // the same number of connections
+  iob2.out2.disconnect(&iob3.in);
+  iob2.out2.connectTo(&iob4.in);
+  EXPECT_TRUE(scheme.updateModel());
+  EXPECT_LT(version,scheme.getModelVersion());
+
+  // The old connection is no longer modeled
+  std::vector<conman::ConnectionRecommendation> connections;
+  EXPECT_EQ(7,scheme.optimizeConnections(false, connections));
+
+  // Restore the original connection
+  iob2.out2.disconnect(&iob4.in);
+  iob2.out2.connectTo(&iob3.in);
+  EXPECT_TRUE(scheme.updateModel());
+  const unsigned long reconnected_version = scheme.getModelVersion();
+
+  // Only the new connections are modeled
+  ConnectBlocksCyclic();
+  EXPECT_FALSE(scheme.updateModel());
+  EXPECT_LT(reconnected_version,scheme.getModelVersion());
+  EXPECT_EQ(4,scheme.getFlowCycles(flow_cycles));
+  EXPECT_FALSE(scheme.executable());
+}
+
+TEST_F(DataFlowTest, ReconnectLatched) {
+  // Connect blocks with cycles and break them with latches
+  ConnectBlocksAcyclic();
+  ConnectBlocksCyclic();
+  AddBlocks();
+  EXPECT_TRUE(scheme.latchConnections("iob5","iob1",true));
+  EXPECT_TRUE(scheme.latchConnections("iob5","iob2",true));
+  EXPECT_TRUE(scheme.executable());
+
+  // Disconnecting the blocks removes the edge, but not the latch
+  iob5.out1.disconnect(&iob1.in);
+  EXPECT_TRUE(scheme.updateModel());
+  iob5.out1.connectTo(&iob1.in);
+  EXPECT_TRUE(scheme.updateModel());
+  EXPECT_TRUE(scheme.executable());
+
+  // Unlatching while the blocks are disconnected also survives
+  iob5.out2.disconnect(&iob2.in);
+  EXPECT_TRUE(scheme.updateModel());
+  EXPECT_TRUE(scheme.latchConnections("iob5","iob2",false));
+  iob5.out2.connectTo(&iob2.in);
+  EXPECT_FALSE(scheme.updateModel());
+  EXPECT_FALSE(scheme.executable());
+}
+
+TEST_F(DataFlowTest, Conflicts) {
+  std::vector<std::string> conflicts;
+
+  // iob1 and iob2 both write to the exclusive input of iob3
+  ConnectBlocksAcyclic();
+  AddBlocks();
+
+  EXPECT_TRUE(scheme.fork().getConflicts("iob1", conflicts));
+  EXPECT_THAT(conflicts, ElementsAre("iob2"));
+  EXPECT_TRUE(scheme.fork().getConflicts("iob2", conflicts));
+  EXPECT_THAT(conflicts, ElementsAre("iob1"));
+  EXPECT_TRUE(scheme.fork().getConflicts("iob3", conflicts));
+  EXPECT_EQ(0,conflicts.size());
+
+  // Conflicts are preserved when other blocks are removed
+  EXPECT_TRUE(scheme.removeBlock("iob4"));
+  EXPECT_TRUE(scheme.fork().getConflicts("iob1", conflicts));
+  EXPECT_THAT(conflicts, ElementsAre("iob2"));
+  EXPECT_TRUE(scheme.fork().getConflicts("iob5", conflicts));
+  EXPECT_EQ(0,conflicts.size());
+}
+
+TEST_F(DataFlowTest, Enableable) {
+  std::vector<std::string> iob32, iob23;
+  iob32 += "iob3", "iob2";
+  iob23 += "iob2", "iob3";
+
+  ConnectBlocksAcyclic();
+  AddBlocks();
+
+  // iob1 conflicts with iob2
+  EXPECT_TRUE(scheme.enableBlock("iob1", false));
+  EXPECT_FALSE(scheme.enableable("iob2"));
+  EXPECT_TRUE(scheme.enableable("iob3"));
+  EXPECT_FALSE(scheme.enableable(iob32));
+  EXPECT_FALSE(scheme.enableBlock("iob2", false));
+  EXPECT_FALSE(iob2.isRunning());
+
+  // Force-enabling iob2 disables iob1
+  EXPECT_TRUE(scheme.enableBlocks(iob23, true, true));
+  EXPECT_FALSE(iob1.isRunning());
+  EXPECT_TRUE(iob2.isRunning());
+  EXPECT_TRUE(iob3.isRunning());
+  EXPECT_FALSE(scheme.enableable("iob1"));
+
+  EXPECT_TRUE(scheme.disableBlock("iob2"));
+  EXPECT_TRUE(scheme.enableable("iob1"));
+
+  // Blocks started and stopped outside of the scheme are accounted for
+  EXPECT_TRUE(iob2.start());
+  EXPECT_FALSE(scheme.enableable("iob1"));
+  EXPECT_FALSE(scheme.enableBlock("iob1", false));
+  EXPECT_TRUE(iob2.stop());
+  EXPECT_TRUE(scheme.enableable("iob1"));
+  EXPECT_TRUE(scheme.enableBlock("iob1", false));
+  EXPECT_TRUE(scheme.disableBlock("iob1"));
+}
+
+TEST_F(DataFlowTest, BlockIDs) {
+  ConnectBlocksAcyclic();
+  AddBlocks();
+
+  const conman::BlockID iob1_id = scheme.getBlockID("iob1");
+  const conman::BlockID iob2_id = scheme.getBlockID("iob2");
+  const conman::BlockID iob3_id = scheme.getBlockID("iob3");
+  EXPECT_NE(conman::INVALID_BLOCK_ID, iob1_id);
+  EXPECT_EQ(conman::INVALID_BLOCK_ID, scheme.getBlockID("not_a_block"));
+  EXPECT_EQ("iob2", scheme.getBlockName(iob2_id));
+
+  EXPECT_TRUE(scheme.setGroupMembers("g23","iob2"));
+  EXPECT_TRUE(scheme.addToGroup("iob3","g23"));
+  const conman::BlockID g23_id = scheme.getBlockID("g23");
+
+  std::vector<conman::BlockID> ids1, ids23;
+  ids1.push_back(iob1_id);
+  ids23.push_back(g23_id);
+
+  // iob1 conflicts with iob2
+  EXPECT_TRUE(scheme.enableBlocks(ids1, true, false));
+  EXPECT_TRUE(scheme.isEnabled(iob1_id));
+  EXPECT_FALSE(scheme.enableable(ids23));
+  EXPECT_FALSE(scheme.enableBlocks(ids23, true, false));
+
+  // Switching disables iob1
+  EXPECT_TRUE(scheme.switchBlocks(ids1, ids23, true, false));
+  EXPECT_FALSE(scheme.isEnabled(iob1_id));
+  EXPECT_TRUE(scheme.isEnabled(iob2_id));
+  EXPECT_TRUE(scheme.isEnabled(iob3_id));
+
+  EXPECT_TRUE(scheme.disableBlocks(ids23, true));
+  EXPECT_FALSE(scheme.isEnabled(iob2_id));
+
+  // IDs are not reused
+  EXPECT_TRUE(scheme.removeBlock("iob1"));
+  EXPECT_EQ(conman::INVALID_BLOCK_ID, scheme.getBlockID("iob1"));
+  EXPECT_FALSE(scheme.isEnabled(iob1_id));
+  EXPECT_FALSE(scheme.enableBlocks(ids1, true, false));
+  EXPECT_TRUE(scheme.addBlock(&iob1));
+  EXPECT_NE(iob1_id, scheme.getBlockID("iob1"));
+}
+
+TEST_F(DataFlowTest, Capacity) {
+  ConnectBlocksAcyclic();
+
+  EXPECT_TRUE(scheme.setCapacity(5,1));
+  AddBlocks();
+  EXPECT_TRUE(scheme.setGroupMembers("g23","iob2"));
+  EXPECT_TRUE(scheme.addToGroup("iob3","g23"));
+
+  // Blocks and groups beyond the capacity are rejected
+  ValidBlock vb("vb");
+  scheme.addPeer(&vb);
+  EXPECT_FALSE(scheme.addBlock(&vb));
+  EXPECT_FALSE(scheme.addGroup("g45"));
+  EXPECT_FALSE(scheme.setCapacity(4,1));
+
+  std::vector<conman::BlockID> ids1, ids23, order;
+  ids1.push_back(scheme.getBlockID("iob1"));
+  ids23.push_back(scheme.getBlockID("g23"));
+  order.reserve(5);
+
+  std::vector<std::string> block_names, order_names;
+
+  // Warm up
+  EXPECT_TRUE(scheme.enableBlocks(ids1, true, false));
+  EXPECT_TRUE(scheme.switchBlocks(ids1, ids23, true, false));
+  EXPECT_TRUE(scheme.disableBlocks(ids23, true));
+  scheme.getBlocks(block_names);
+  EXPECT_TRUE(scheme.getExecutionOrder(order_names));
+
+  // The ID operations don't allocate
+  {
+    conman::test::AllocationCounter allocations;
+    EXPECT_TRUE(scheme.enableable(ids1));
+    EXPECT_TRUE(scheme.enableBlocks(ids1, true, false));
+    EXPECT_TRUE(scheme.isEnabled(ids1[0]));
+    EXPECT_FALSE(scheme.enableable(ids23));
+    EXPECT_TRUE(scheme.switchBlocks(ids1, ids23, true, false));
+    EXPECT_TRUE(scheme.enableBlocks(ids1, true, true));
+    EXPECT_TRUE(scheme.disableBlocks(ids1, true));
+    EXPECT_TRUE(scheme.getExecutionOrder(order));
+    EXPECT_EQ(0, allocations.count());
+  }
+
+  EXPECT_EQ(5, order.size());
+  EXPECT_EQ(ids1[0], order.front());
+
+  // The name queries reuse the vectors they're given
+  {
+    conman::test::AllocationCounter allocations;
+    scheme.getBlocks(block_names);
+    EXPECT_TRUE(scheme.getExecutionOrder(order_names));
+    EXPECT_EQ(0, allocations.count());
+  }
+
+  EXPECT_THAT(block_names, ElementsAre("iob1", "iob2", "iob3", "iob4", "iob5"));
+  EXPECT_THAT(order_names, ElementsAre("iob1", "iob2", "iob3", "iob4", "iob5"));
+}
+
+TEST_F(DataFlowTest, DemandDriven) {
+  std::vector<std::string> iob234;
+  iob234 += "iob2", "iob3", "iob4";
+
+  ConnectBlocksAcyclic();
+  AddBlocks();
+  scheme.setDemandDriven(true);
+
+  // Nothing feeds an enabled sink
+  EXPECT_TRUE(scheme.enableBlocks(iob234, true, false));
+  EXPECT_FALSE(scheme.isDemanded("iob2"));
+  EXPECT_FALSE(scheme.isDemanded("iob4"));
+
+  // Required blocks are sinks
+  EXPECT_TRUE(scheme.setRequired("iob3", true));
+  EXPECT_TRUE(scheme.isRequired("iob3"));
+  EXPECT_TRUE(scheme.isDemanded("iob2"));
+  EXPECT_TRUE(scheme.isDemanded("iob3"));
+  EXPECT_FALSE(scheme.isDemanded("iob4"));
+
+  // Blocks without outputs are sinks
+  EXPECT_TRUE(scheme.enableBlock("iob5", false));
+  EXPECT_TRUE(scheme.isDemanded("iob4"));
+  EXPECT_TRUE(scheme.isDemanded("iob5"));
+
+  // Disabled blocks don't propagate demand
+  EXPECT_TRUE(scheme.disableBlock("iob3"));
+  EXPECT_FALSE(scheme.isDemanded("iob2"));
+  EXPECT_FALSE(scheme.isDemanded("iob3"));
+  EXPECT_TRUE(scheme.isDemanded("iob4"));
+
+  EXPECT_FALSE(scheme.setRequired("not_a_block", true));
+}
+
+TEST_F(DataFlowTest, LocalConnections) {
+  ConnectBlocksAcyclic();
+  AddBlocks();
+
+  // Connections to blocks outside of the scheme are not modified
+  IOBlock external("external");
+  iob4.out2.connectTo(&external.in, RTT::ConnPolicy::buffer(8, RTT::ConnPolicy::LOCKED));
+
+  EXPECT_TRUE(scheme.setLocalConnections(true));
+  EXPECT_TRUE(scheme.hasLocalConnections());
+  EXPECT_EQ(RTT::ConnPolicy::UNSYNC, iob1.out1.getManager()->getChannels().front().get<2>().lock_policy);
+  EXPECT_EQ(RTT::ConnPolicy::LOCKED, iob4.out2.getManager()->getChannels().front().get<2>().lock_policy);
+
+  // The last written sample is carried over into the new channels
+  EXPECT_TRUE(iob1.out1.getManager()->getChannels().front().get<2>().init);
+  EXPECT_FALSE(iob4.out2.getManager()->getChannels().front().get<2>().init);
+  EXPECT_TRUE(scheme.executable());
+
+  // Removed blocks have their original policies restored
+  EXPECT_TRUE(scheme.removeBlock("iob4"));
+  EXPECT_EQ(RTT::ConnPolicy::LOCK_FREE, iob3.out1.getManager()->getChannels().front().get<2>().lock_policy);
+
+  EXPECT_TRUE(scheme.setLocalConnections(false));
+  EXPECT_EQ(RTT::ConnPolicy::LOCK_FREE, iob1.out1.getManager()->getChannels().front().get<2>().lock_policy);
+  EXPECT_EQ(2, iob1.out1.getManager()->getChannels().size());
+}
+
 TEST_F(DataFlowTest, GetCycles) {
   // Connect blocks with cycles
   ConnectBlocksAcyclic();
@@ -401,6 +783,205 @@ TEST_F(DataFlowTest, LatchConnections) {
   EXPECT_TRUE(scheme.getExecutionOrder(execution_order));
 
   EXPECT_THAT(execution_order, ElementsAre("iob1", "iob2", "iob3", "iob4", "iob5"));
+
+  // Unlatching restores the edge in the ESG
+  EXPECT_TRUE(scheme.latchConnections("iob5","iob2",false));
+  EXPECT_FALSE(scheme.executable());
+  EXPECT_EQ(1,scheme.getExecutionCycles(exec_cycles));
+  EXPECT_THAT(exec_cycles, ElementsAre(c4));
+}
+
+TEST_F(DataFlowTest, OptimizeConnections) {
+  iob1.out1.connectTo(&iob2.in, RTT::ConnPolicy::buffer(4, RTT::ConnPolicy::LOCKED));
+  iob1.out2.connectTo(&iob3.in_ex, RTT::ConnPolicy::buffer(4));
+  iob2.out2.connectTo(&iob3.in);
+  AddBlocks();
+
+  std::vector<conman::ConnectionRecommendation> recommendations;
+  EXPECT_EQ(3, scheme.optimizeConnections(false, recommendations));
+  EXPECT_EQ(3, recommendations.size());
+
+  for(std::vector<conman::ConnectionRecommendation>::const_iterator it = recommendations.begin();
+      it != recommendations.end();
+      ++it)
+  {
+    // The blocks all run at the same rate, so only the newest samples are needed
+    EXPECT_EQ(RTT::ConnPolicy::DATA, it->recommended.type);
+    EXPECT_EQ(RTT::ConnPolicy::UNSYNC, it->recommended.lock_policy);
+    EXPECT_FALSE(it->undersized);
+  }
+
+  // Nothing is rewired unless the policies are applied
+  EXPECT_EQ(RTT::ConnPolicy::BUFFER, iob1.out1.getManager()->getChannels().front().get<2>().type);
+
+  EXPECT_TRUE(scheme.start());
+  EXPECT_EQ(-1, scheme.optimizeConnections(true));
+  scheme.stop();
+
+  EXPECT_EQ(3, scheme.optimizeConnections(true));
+  EXPECT_EQ(RTT::ConnPolicy::DATA, iob1.out1.getManager()->getChannels().front().get<2>().type);
+  EXPECT_EQ(0, scheme.optimizeConnections(false));
+
+  // The original lock policies are restored when a block is removed
+  EXPECT_TRUE(scheme.removeBlock("iob2"));
+  EXPECT_EQ(RTT::ConnPolicy::LOCKED, iob1.out1.getManager()->getChannels().front().get<2>().lock_policy);
+}
+
+TEST_F(DataFlowTest, OptimizeMultiRateConnections) {
+  iob1.conman_hook_->setDesiredMinPeriod(0.001);
+  iob2.conman_hook_->setDesiredMinPeriod(0.001);
+  iob3.conman_hook_->setDesiredMinPeriod(0.004);
+  iob4.conman_hook_->setDesiredMinPeriod(0.001);
+
+  iob1.out1.connectTo(&iob2.in, RTT::ConnPolicy::buffer(8));
+  iob1.out2.connectTo(&iob3.in_ex, RTT::ConnPolicy::buffer(2));
+  iob2.out2.connectTo(&iob3.in, RTT::ConnPolicy::buffer(8));
+  iob3.out1.connectTo(&iob4.in, RTT::ConnPolicy::buffer(2));
+  AddBlocks();
+
+  std::vector<conman::ConnectionRecommendation> recommendations;
+  EXPECT_EQ(4, scheme.optimizeConnections(false, recommendations));
+  ASSERT_EQ(4, recommendations.size());
+
+  for(std::vector<conman::ConnectionRecommendation>::const_iterator it = recommendations.begin();
+      it != recommendations.end();
+      ++it)
+  {
+    if(it->sink == "iob3.in_ex") {
+      // iob1 writes four samples per iob3 update, even though the input is
+      // exclusive
+      EXPECT_EQ(RTT::ConnPolicy::BUFFER, it->recommended.type);
+      EXPECT_EQ(4, it->recommended.size);
+      EXPECT_TRUE(it->undersized);
+    } else if(it->sink == "iob3.in") {
+      // The buffer is larger than it needs to be
+      EXPECT_EQ(RTT::ConnPolicy::BUFFER, it->recommended.type);
+      EXPECT_EQ(4, it->recommended.size);
+      EXPECT_FALSE(it->undersized);
+    } else {
+      // The sinks run at least as fast as their sources
+      EXPECT_EQ(RTT::ConnPolicy::DATA, it->recommended.type);
+      EXPECT_FALSE(it->undersized);
+    }
+  }
+}
+
+TEST_F(DataFlowTest, PortContracts) {
+  std::vector<std::string> joints_ab, joints_ba;
+  joints_ab += "a", "b";
+  joints_ba += "b", "a";
+
+  iob1.conman_hook_->setPortDimension("out1", 3);
+  iob2.conman_hook_->setPortDimension("in", 3);
+  iob3.conman_hook_->setPortDimension("in", 4);
+  iob1.conman_hook_->setPortJointNames("out2", joints_ab);
+  iob4.conman_hook_->setPortJointNames("in", joints_ba);
+
+  iob1.out1.connectTo(&iob2.in);
+  iob1.out1.connectTo(&iob3.in);
+  iob1.out2.connectTo(&iob4.in);
+  iob1.out2.connectTo(&iob5.in);
+  AddBlocks();
+
+  // Connections with different dimensions or joint names aren't modeled,
+  // but they're left connected
+  std::vector<conman::ConnectionDescription> connections;
+  scheme.getConnectionDescriptions(connections);
+  EXPECT_EQ(2, connections.size());
+  EXPECT_TRUE(iob2.in.connected());
+  EXPECT_TRUE(iob3.in.connected());
+  EXPECT_TRUE(iob4.in.connected());
+  EXPECT_TRUE(iob5.in.connected());
+  EXPECT_FALSE(scheme.regenerateModel());
+  EXPECT_FALSE(scheme.start());
+
+  // Contracts are checked when the model is regenerated
+  iob5.conman_hook_->setPortDimension("in", 1);
+  EXPECT_FALSE(scheme.regenerateModel());
+  EXPECT_TRUE(iob5.in.connected());
+
+  connections.clear();
+  scheme.getConnectionDescriptions(connections);
+  EXPECT_EQ(1, connections.size());
+
+  // The model is valid once the mismatched connections are removed
+  iob1.out1.disconnect(&iob3.in);
+  iob1.out2.disconnect(&iob4.in);
+  iob1.out2.disconnect(&iob5.in);
+  EXPECT_TRUE(scheme.regenerateModel());
+
+  // Contracts declared in configureHook are checked once the block is
+  // configured
+  ContractBlock cb("cb", 2);
+  iob1.out1.connectTo(&cb.in);
+  EXPECT_TRUE(scheme.addBlock(&cb));
+  EXPECT_TRUE(cb.in.connected());
+  EXPECT_FALSE(scheme.configureBlocks("cb", 1));
+  EXPECT_TRUE(cb.in.connected());
+
+  connections.clear();
+  scheme.getConnectionDescriptions(connections);
+  EXPECT_EQ(1, connections.size());
+  EXPECT_TRUE(scheme.removeBlock("cb"));
+
+  // Blocks which are configured directly are checked when the scheme starts
+  ContractBlock direct_cb("direct_cb", 2);
+  iob1.out1.connectTo(&direct_cb.in);
+  EXPECT_TRUE(scheme.addBlock(&direct_cb));
+  EXPECT_TRUE(direct_cb.configure());
+  EXPECT_FALSE(scheme.start());
+  EXPECT_TRUE(direct_cb.in.connected());
+
+  iob1.out1.disconnect(&direct_cb.in);
+  EXPECT_TRUE(scheme.start());
+  EXPECT_TRUE(scheme.stop());
+  EXPECT_TRUE(scheme.removeBlock("direct_cb"));
+}
+
+TEST_F(DataFlowTest, LatchDelay) {
+  std::vector<std::string> order;
+
+  ConnectBlocksAcyclic();
+  AddBlocks();
+  EXPECT_TRUE(scheme.latchesDelayed());
+
+  // iob5 still depends on iob1 through iob4, so the latch isn't delayed
+  EXPECT_FALSE(scheme.latchConnections("iob1","iob5",true));
+  EXPECT_FALSE(scheme.latchesDelayed());
+
+  // iob5 only reads latched connections, so it runs first
+  EXPECT_TRUE(scheme.latchConnections("iob4","iob5",true));
+  EXPECT_TRUE(scheme.regenerateModel());
+  EXPECT_TRUE(scheme.getExecutionOrder(order));
+  EXPECT_EQ("iob5", order.front());
+  EXPECT_TRUE(scheme.latchesDelayed());
+
+  // iob5 depends on iob1 through an unlatched connection
+  EXPECT_TRUE(scheme.latchConnections("iob4","iob5",false));
+  EXPECT_TRUE(scheme.regenerateModel());
+  EXPECT_TRUE(scheme.getExecutionOrder(order));
+  EXPECT_EQ("iob5", order.back());
+  EXPECT_FALSE(scheme.latchesDelayed());
+}
+
+TEST_F(DataFlowTest, PartialLatchDelay) {
+  std::vector<std::string> order;
+
+  iob1.out1.connectTo(&iob2.in);
+  iob2.out1.connectTo(&iob3.in);
+  iob1.out2.connectTo(&iob3.in_ex);
+  iob3.out1.connectTo(&iob5.in_ex);
+  iob4.out1.connectTo(&iob5.in);
+  AddBlocks();
+
+  // iob3 depends on iob1 through iob2, but iob5 doesn't depend on iob4, so
+  // only the connection from iob4 to iob5 is delayed
+  EXPECT_FALSE(scheme.latchConnections("iob1","iob3",true));
+  EXPECT_TRUE(scheme.latchConnections("iob4","iob5",true));
+  EXPECT_TRUE(scheme.regenerateModel());
+  EXPECT_TRUE(scheme.getExecutionOrder(order));
+  EXPECT_THAT(order, ElementsAre("iob1", "iob2", "iob3", "iob5", "iob4"));
+  EXPECT_FALSE(scheme.latchesDelayed());
 }
 
 TEST_F(DataFlowTest, Latchanalysis) {
@@ -431,6 +1012,286 @@ TEST_F(DataFlowTest, Latchanalysis) {
 
   EXPECT_EQ(1,scheme.maxLatchCount());
   EXPECT_EQ(1,scheme.minLatchCount());
+
+  // Analysis queries don't modify the model
+  unsigned long model_version = scheme.getModelVersion();
+  EXPECT_EQ(1,scheme.maxLatchCount());
+  EXPECT_EQ(model_version,scheme.getModelVersion());
+
+  // Latch counts can also be computed by vertex index
+  std::vector<unsigned int> index_query;
+  index_query += 4, 0;
+  EXPECT_EQ(1,scheme.latchCount(index_query));
+
+  // Latching changes the model version and the analysis
+  scheme.latchConnections("iob4","iob5",true);
+  EXPECT_LT(model_version,scheme.getModelVersion());
+  EXPECT_EQ(2,scheme.maxLatchCount());
+  EXPECT_EQ(1,scheme.minLatchCount());
+}
+
+TEST_F(DataFlowTest, AutoLatch) {
+  std::vector<std::vector<std::string> > exec_cycles;
+  std::vector<std::string> sources, sinks;
+
+  // Connect blocks with cycles
+  ConnectBlocksAcyclic();
+  ConnectBlocksCyclic();
+  AddBlocks();
+  EXPECT_FALSE(scheme.executable());
+
+  // Proposing latches doesn't modify the scheme
+  EXPECT_EQ(2,scheme.proposeLatches(sources, sinks, conman::LatchCost::UNIFORM));
+  EXPECT_EQ(2,sources.size());
+  EXPECT_EQ(2,sinks.size());
+  EXPECT_FALSE(scheme.executable());
+
+  EXPECT_EQ(2,scheme.proposeLatches(sources, sinks, conman::LatchCost::CONNECTIONS));
+  EXPECT_FALSE(scheme.executable());
+
+  // Apply the latches
+  EXPECT_EQ(2,scheme.autoLatch(conman::LatchCost::UNIFORM, true));
+  EXPECT_TRUE(scheme.executable());
+  EXPECT_EQ(0,scheme.getExecutionCycles(exec_cycles));
+
+  // Nothing left to latch
+  EXPECT_EQ(0,scheme.autoLatch(conman::LatchCost::UNIFORM, true));
+  EXPECT_TRUE(scheme.executable());
+}
+
+TEST_F(DataFlowTest, LocalityOrdering) {
+  // Connect two independent chains fed by the same block
+  iob1.out1.connectTo(&iob2.in);
+  iob2.out1.connectTo(&iob3.in);
+  iob1.out2.connectTo(&iob4.in);
+  iob4.out1.connectTo(&iob5.in);
+  AddBlocks();
+  EXPECT_TRUE(scheme.executable());
+
+  std::vector<std::string> execution_order;
+  EXPECT_TRUE(scheme.getExecutionOrder(execution_order));
+  ASSERT_EQ(5,execution_order.size());
+
+  // Each consumer runs right after its producer
+  std::map<std::string,int> positions;
+  for(size_t i=0; i<execution_order.size(); i++) {
+    positions[execution_order[i]] = i;
+  }
+  EXPECT_EQ(0,positions["iob1"]);
+  EXPECT_EQ(positions["iob2"]+1,positions["iob3"]);
+  EXPECT_EQ(positions["iob4"]+1,positions["iob5"]);
+}
+
+TEST_F(DataFlowTest, EditTransaction) {
+  std::vector<std::vector<std::string> > exec_cycles;
+  std::vector<std::string> sources, sinks;
+
+  // Connect blocks with cycles
+  ConnectBlocksAcyclic();
+  ConnectBlocksCyclic();
+
+  // Nothing to commit
+  EXPECT_FALSE(scheme.commit());
+
+  // Add blocks and latch the cycles in a single transaction
+  EXPECT_TRUE(scheme.beginEdit());
+  EXPECT_TRUE(scheme.isEditing());
+  AddBlocks();
+  sources += "iob5";
+  sinks += "iob1", "iob2";
+  EXPECT_TRUE(scheme.latchConnections(sources, sinks, true));
+
+  // The scheme can't be started with an open transaction
+  EXPECT_FALSE(scheme.start());
+
+  // The model is regenerated once on commit
+  EXPECT_TRUE(scheme.commit());
+  EXPECT_FALSE(scheme.isEditing());
+  EXPECT_TRUE(scheme.executable());
+  EXPECT_EQ(0,scheme.getExecutionCycles(exec_cycles));
+  EXPECT_TRUE(scheme.start());
+  scheme.stop();
+
+  // Transactions can't be begun while running
+  EXPECT_TRUE(scheme.start());
+  EXPECT_FALSE(scheme.beginEdit());
+}
+
+TEST_F(DataFlowTest, Fork) {
+  std::vector<std::string> execution_order;
+
+  // Connect blocks with cycles, but only add the blocks which are acyclic
+  ConnectBlocksAcyclic();
+  ConnectBlocksCyclic();
+  scheme.addBlock(&iob1);
+  scheme.addBlock(&iob2);
+  scheme.addBlock(&iob3);
+  scheme.addBlock(&iob4);
+  EXPECT_TRUE(scheme.start());
+
+  // Forks can be modified while the scheme is running
+  conman::SchemeFork fork = scheme.fork();
+  EXPECT_TRUE(fork.executable());
+  EXPECT_TRUE(fork.addBlock(&iob5));
+  EXPECT_FALSE(fork.executable());
+  EXPECT_FALSE(fork.getExecutionOrder(execution_order));
+
+  // Copies of a fork are independent
+  conman::SchemeFork latched_fork = fork;
+  EXPECT_TRUE(latched_fork.latchConnections("iob5","iob1",true));
+  EXPECT_TRUE(latched_fork.latchConnections("iob5","iob2",true));
+  EXPECT_TRUE(latched_fork.executable());
+  EXPECT_TRUE(latched_fork.getExecutionOrder(execution_order));
+  EXPECT_THAT(execution_order, ElementsAre("iob1", "iob2", "iob3", "iob4", "iob5"));
+  EXPECT_FALSE(fork.executable());
+
+  // The scheme is unchanged
+  EXPECT_EQ(4,scheme.getBlocks().size());
+  EXPECT_TRUE(scheme.isRunning());
+  EXPECT_FALSE(scheme.fork().hasBlock("iob5"));
+  EXPECT_EQ(4,scheme.fork().getBlocks().size());
+
+  // What-if queries refer to blocks by name
+  std::vector<std::string> adds, sources, sinks;
+  scheme.addPeer(&iob5);
+  adds += "iob5";
+  EXPECT_FALSE(scheme.whatIfExecutable(adds, sources, sinks));
+  EXPECT_TRUE(scheme.whatIfExecutionOrder(adds, sources, sinks).empty());
+  sources += "iob5", "iob5";
+  sinks += "iob1", "iob2";
+  EXPECT_TRUE(scheme.whatIfExecutable(adds, sources, sinks));
+  EXPECT_THAT(scheme.whatIfExecutionOrder(adds, sources, sinks),
+              ElementsAre("iob1", "iob2", "iob3", "iob4", "iob5"));
+  sinks.pop_back();
+  EXPECT_FALSE(scheme.whatIfExecutable(adds, sources, sinks));
+  EXPECT_EQ(4,scheme.getBlocks().size());
+
+  // Blocks added to a fork respect latched inputs
+  scheme.stop();
+  EXPECT_TRUE(scheme.latchInputs("iob1",true));
+  EXPECT_TRUE(scheme.latchInputs("iob2",true));
+  conman::SchemeFork input_latched_fork = scheme.fork();
+  EXPECT_TRUE(input_latched_fork.addBlock(&iob5));
+  EXPECT_TRUE(input_latched_fork.executable());
+}
+
+TEST_F(DataFlowTest, SchemeFile) {
+  std::vector<std::string> execution_order;
+
+  ConnectBlocksAcyclic();
+  ConnectBlocksCyclic();
+
+  // Declare the scheme in a temporary directory
+  const char *tmp_dir = std::getenv("TMPDIR");
+  std::ostringstream file_prefix;
+  file_prefix << ((tmp_dir != NULL) ? tmp_dir : "/tmp") << "/test_conman_scheme_" << getpid();
+  const std::string scheme_file = file_prefix.str() + ".txt";
+  const std::string snapshot_file = file_prefix.str() + ".snapshot";
+  const std::string invalid_file = file_prefix.str() + "_invalid.txt";
+  std::remove(snapshot_file.c_str());
+  {
+    std::ofstream out(scheme_file.c_str());
+    out << "# Test scheme" << std::endl
+      << "block iob1 iob2 iob3" << std::endl
+      << "block iob4 iob5 # inline comment" << std::endl
+      << "group feedback iob1 iob2" << std::endl
+      << "latch iob5 feedback" << std::endl;
+  }
+
+  EXPECT_FALSE(scheme.loadScheme("does_not_exist.txt", ""));
+
+  // Blocks need to be peers
+  EXPECT_FALSE(scheme.loadScheme(scheme_file, ""));
+  EXPECT_EQ(0,scheme.getBlocks().size());
+
+  conman::Scheme snapshot_scheme("SnapshotScheme");
+  IOBlock *blocks[] = {&iob1, &iob2, &iob3, &iob4, &iob5};
+  for(size_t i=0; i<5; i++) {
+    scheme.addPeer(blocks[i]);
+    snapshot_scheme.addPeer(blocks[i]);
+  }
+
+  // The first load computes the model and writes the snapshot
+  EXPECT_TRUE(scheme.loadScheme(scheme_file, snapshot_file));
+  EXPECT_EQ(5,scheme.getBlocks().size());
+  EXPECT_TRUE(scheme.executable());
+  EXPECT_TRUE(scheme.getExecutionOrder(execution_order));
+  EXPECT_THAT(execution_order, ElementsAre("iob1", "iob2", "iob3", "iob4", "iob5"));
+  EXPECT_TRUE(std::ifstream(snapshot_file.c_str()).good());
+
+  // The second load restores the model from the snapshot
+  EXPECT_TRUE(snapshot_scheme.loadScheme(scheme_file, snapshot_file));
+  EXPECT_TRUE(snapshot_scheme.executable());
+  EXPECT_TRUE(snapshot_scheme.getExecutionOrder(execution_order));
+  EXPECT_THAT(execution_order, ElementsAre("iob1", "iob2", "iob3", "iob4", "iob5"));
+
+  // Changing the exclusivity of an input invalidates the snapshot
+  std::string snapshot_contents;
+  {
+    std::ifstream in(snapshot_file.c_str(), std::ios::binary);
+    snapshot_contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+
+  iob4.conman_hook_->setInputExclusivity("in",conman::Exclusivity::EXCLUSIVE);
+  {
+    conman::Scheme exclusive_scheme("ExclusiveScheme");
+    for(size_t i=0; i<5; i++) {
+      exclusive_scheme.addPeer(blocks[i]);
+    }
+    EXPECT_TRUE(exclusive_scheme.loadScheme(scheme_file, snapshot_file));
+
+    std::ifstream in(snapshot_file.c_str(), std::ios::binary);
+    EXPECT_NE(snapshot_contents, std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()));
+  }
+  iob4.conman_hook_->setInputExclusivity("in",conman::Exclusivity::UNRESTRICTED);
+
+  // A corrupt snapshot with an oversized string length is ignored
+  {
+    std::ofstream out(snapshot_file.c_str(), std::ios::binary | std::ios::trunc);
+    // Keep the magic, version, model hash and number of ordered blocks
+    out.write(snapshot_contents.data(), 8 + 4 + 8 + 4);
+    const boost::uint32_t huge_size = 0xFFFFFFFF;
+    out.write(reinterpret_cast<const char*>(&huge_size), sizeof(huge_size));
+  }
+  {
+    conman::Scheme corrupt_scheme("CorruptScheme");
+    for(size_t i=0; i<5; i++) {
+      corrupt_scheme.addPeer(blocks[i]);
+    }
+    EXPECT_TRUE(corrupt_scheme.loadScheme(scheme_file, snapshot_file));
+    EXPECT_TRUE(corrupt_scheme.executable());
+    EXPECT_TRUE(corrupt_scheme.getExecutionOrder(execution_order));
+    EXPECT_THAT(execution_order, ElementsAre("iob1", "iob2", "iob3", "iob4", "iob5"));
+  }
+
+  // A scheme file which can't be loaded is rolled back
+  {
+    std::ofstream out(invalid_file.c_str());
+    out << "block iob1 iob2 iob3 iob4 iob5" << std::endl
+      << "group feedback iob1 iob2" << std::endl
+      << "latch iob5 feedback" << std::endl
+      << "latch_inputs iob3" << std::endl
+      << "block not_a_block" << std::endl;
+  }
+
+  conman::Scheme rollback_scheme("RollbackScheme");
+  for(size_t i=0; i<5; i++) {
+    rollback_scheme.addPeer(blocks[i]);
+  }
+  EXPECT_TRUE(rollback_scheme.addBlock("iob1"));
+  iob2.setActivity(new RTT::Activity(ORO_SCHED_OTHER, 0, 0.5, 0, 0, "iob2"));
+
+  EXPECT_FALSE(rollback_scheme.loadScheme(invalid_file, ""));
+  EXPECT_EQ(1,rollback_scheme.getBlocks().size());
+  EXPECT_FALSE(rollback_scheme.hasGroup("feedback"));
+
+  // Blocks added by the scheme file get their previous activity back
+  ASSERT_TRUE(iob2.getActivity() != NULL);
+  EXPECT_EQ(0.5,iob2.getActivity()->getPeriod());
+
+  std::remove(scheme_file.c_str());
+  std::remove(snapshot_file.c_str());
+  std::remove(invalid_file.c_str());
 }
 
 TEST_F(DataFlowTest, StartAcyclic) {
@@ -472,6 +1333,69 @@ TEST_F(DataFlowTest, StartLatchConnections) {
   EXPECT_TRUE(scheme.regenerateModel());
 }
 
+TEST(PayloadTest, Pool) {
+  conman::PayloadPool<std::vector<double> >::Ptr pool(
+      new conman::PayloadPool<std::vector<double> >(2, std::vector<double>(1000, 0.0)));
+  EXPECT_EQ(2, pool->capacity());
+  EXPECT_EQ(2, pool->available());
+
+  conman::SharedPayload<std::vector<double> > p1, p2, p3;
+
+  // Allocating payloads doesn't allocate memory
+  std::vector<double> *v1 = NULL;
+  {
+    conman::test::AllocationCounter allocations;
+    v1 = pool->allocate(p1);
+    ASSERT_TRUE(v1 != NULL);
+    (*v1)[0] = 1.0;
+    EXPECT_TRUE(pool->allocate(p2) != NULL);
+    EXPECT_EQ(0, allocations.count());
+  }
+  EXPECT_EQ(1000, v1->size());
+
+  // The pool is exhausted
+  EXPECT_TRUE(pool->allocate(p3) == NULL);
+  EXPECT_TRUE(p3.empty());
+  EXPECT_EQ(0, pool->available());
+  EXPECT_EQ(1, pool->exhausted());
+
+  // Copies share the payload
+  p3 = p1;
+  EXPECT_EQ(p1.get(), p3.get());
+  EXPECT_EQ(1.0, (*p3)[0]);
+
+  // Payloads are returned when the last handle is dropped
+  p1.reset();
+  EXPECT_EQ(0, pool->available());
+  p3.reset();
+  EXPECT_EQ(1, pool->available());
+  EXPECT_TRUE(pool->allocate(p1) == v1);
+
+  // Payloads can outlive their pool
+  pool.reset();
+  EXPECT_EQ(1.0, (*p1)[0]);
+}
+
+TEST(PayloadTest, Register) {
+  ValidBlock vb("vb");
+  conman::PayloadPool<std::vector<double> >::Ptr pool(
+      new conman::PayloadPool<std::vector<double> >(1, std::vector<double>(10, 0.0)));
+
+  // Pools can be registered while the block is configured
+  EXPECT_TRUE(vb.configure());
+  EXPECT_TRUE(vb.conman_hook_->registerPayloadPool("pool", pool));
+
+  conman::SharedPayload<std::vector<double> > p1, p2;
+  EXPECT_TRUE(pool->allocate(p1) != NULL);
+  EXPECT_TRUE(pool->allocate(p2) == NULL);
+  EXPECT_EQ(1, vb.conman_hook_->getPayloadPoolExhausted("pool"));
+
+  // Pools can't be registered while the block is running
+  EXPECT_TRUE(vb.start());
+  EXPECT_FALSE(vb.conman_hook_->registerPayloadPool("other", pool));
+  vb.stop();
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
 
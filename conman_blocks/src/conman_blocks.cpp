@@ -3,8 +3,26 @@
 
 #include "vector_sum.h"
 #include "feed_forward_feed_back.h"
+#include "control_blocks.h"
+#include "rate_transition.h"
 
 ORO_CREATE_COMPONENT_LIBRARY()
 ORO_LIST_COMPONENT_TYPE(conman_blocks::VectorSum)
 ORO_LIST_COMPONENT_TYPE(conman_blocks::FeedForwardFeedBack)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::Gain)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::Saturation)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::Deadband)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::RateLimiter)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::PID)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::RateTransition)
+
+// Fixed-dimension blocks
+ORO_LIST_COMPONENT_TYPE(conman_blocks::VectorSum3)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::VectorSum4)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::VectorSum6)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::VectorSum7)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::FeedForwardFeedBack3)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::FeedForwardFeedBack4)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::FeedForwardFeedBack6)
+ORO_LIST_COMPONENT_TYPE(conman_blocks::FeedForwardFeedBack7)
 
@@ -0,0 +1,145 @@
+
+#include <limits>
+
+#include "control_kernels.h"
+#include "control_blocks.h"
+
+using namespace conman_blocks;
+
+namespace {
+  const double inf = std::numeric_limits<double>::infinity();
+}
+
+Gain::Gain(std::string const& name) :
+  VectorFilter(name, "in", "out")
+{
+  this->addProperty("gains",gains_)
+    .doc("The gain for each coefficient (default: 1).");
+}
+
+bool Gain::configureFilter()
+{
+  return this->sizeParameter("gains", gains_, 1.0);
+}
+
+void Gain::filter(const RTT::Seconds period)
+{
+  kernels::Gain(gains_, input_, output_);
+}
+
+Saturation::Saturation(std::string const& name) :
+  VectorFilter(name, "in", "out")
+{
+  this->addProperty("limits",limits_)
+    .doc("The maximum magnitude of each coefficient (default: unlimited).");
+}
+
+bool Saturation::configureFilter()
+{
+  return this->sizeParameter("limits", limits_, inf);
+}
+
+void Saturation::filter(const RTT::Seconds period)
+{
+  kernels::Saturate(limits_, input_, output_);
+}
+
+Deadband::Deadband(std::string const& name) :
+  VectorFilter(name, "in", "out")
+{
+  this->addProperty("widths",widths_)
+    .doc("The half-width of the deadband of each coefficient (default: 0).");
+}
+
+bool Deadband::configureFilter()
+{
+  return this->sizeParameter("widths", widths_, 0.0);
+}
+
+void Deadband::filter(const RTT::Seconds period)
+{
+  kernels::Deadband(widths_, input_, output_);
+}
+
+RateLimiter::RateLimiter(std::string const& name) :
+  VectorFilter(name, "in", "out")
+  ,initialized_(false)
+{
+  this->addProperty("rates",rates_)
+    .doc("The maximum rate of change of each coefficient per second (default: unlimited).");
+}
+
+bool RateLimiter::configureFilter()
+{
+  return this->sizeParameter("rates", rates_, inf);
+}
+
+void RateLimiter::resetFilter()
+{
+  initialized_ = false;
+}
+
+void RateLimiter::filter(const RTT::Seconds period)
+{
+  // The first input after starting passes through, and the output is held
+  // if no time has passed
+  if(!initialized_) {
+    output_ = input_;
+    initialized_ = true;
+  } else if(period > 0.0) {
+    kernels::RateLimit(rates_, period, input_, output_);
+  }
+}
+
+PID::PID(std::string const& name) :
+  VectorFilter(name, "error_in", "effort_out")
+  ,initialized_(false)
+{
+  this->addProperty("p_gains",p_gains_)
+    .doc("The proportional gain for each coefficient (default: 0).");
+  this->addProperty("i_gains",i_gains_)
+    .doc("The integral gain for each coefficient (default: 0).");
+  this->addProperty("d_gains",d_gains_)
+    .doc("The derivative gain for each coefficient (default: 0).");
+  this->addProperty("i_limits",i_limits_)
+    .doc("The maximum magnitude of the integral of the error for each coefficient (default: unlimited).");
+}
+
+bool PID::configureFilter()
+{
+  if(!this->sizeParameter("p_gains", p_gains_, 0.0)
+     || !this->sizeParameter("i_gains", i_gains_, 0.0)
+     || !this->sizeParameter("d_gains", d_gains_, 0.0)
+     || !this->sizeParameter("i_limits", i_limits_, inf))
+  {
+    return false;
+  }
+
+  last_error_.setZero(dim_);
+  integral_.setZero(dim_);
+
+  return true;
+}
+
+void PID::resetFilter()
+{
+  initialized_ = false;
+  integral_.setZero();
+}
+
+void PID::filter(const RTT::Seconds period)
+{
+  // Don't differentiate the first error after starting
+  if(!initialized_) {
+    last_error_ = input_;
+    initialized_ = true;
+  }
+
+  kernels::PID(
+      p_gains_, i_gains_, d_gains_, i_limits_,
+      period,
+      input_,
+      last_error_,
+      integral_,
+      output_);
+}
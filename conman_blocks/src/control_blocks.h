@@ -0,0 +1,100 @@
+#ifndef __CONMAN_BLOCKS_CONTROL_BLOCKS_H
+#define __CONMAN_BLOCKS_CONTROL_BLOCKS_H
+
+#include <Eigen/Dense>
+
+#include "vector_filter.h"
+
+namespace conman_blocks {
+
+  //! Multiply a vector by a gain for each coefficient
+  class Gain : public VectorFilter
+  {
+    // RTT properties
+    Eigen::VectorXd gains_;
+
+  public:
+    Gain(std::string const& name);
+
+  protected:
+    virtual bool configureFilter();
+    virtual void filter(const RTT::Seconds period);
+  };
+
+  //! Clamp each coefficient of a vector to symmetric limits
+  class Saturation : public VectorFilter
+  {
+    // RTT properties
+    Eigen::VectorXd limits_;
+
+  public:
+    Saturation(std::string const& name);
+
+  protected:
+    virtual bool configureFilter();
+    virtual void filter(const RTT::Seconds period);
+  };
+
+  //! Zero the coefficients of a vector which are within a deadband
+  class Deadband : public VectorFilter
+  {
+    // RTT properties
+    Eigen::VectorXd widths_;
+
+  public:
+    Deadband(std::string const& name);
+
+  protected:
+    virtual bool configureFilter();
+    virtual void filter(const RTT::Seconds period);
+  };
+
+  //! Limit the rate of change of each coefficient of a vector
+  class RateLimiter : public VectorFilter
+  {
+    // RTT properties
+    Eigen::VectorXd rates_;
+
+  public:
+    RateLimiter(std::string const& name);
+
+  protected:
+    virtual bool configureFilter();
+    virtual void resetFilter();
+    virtual void filter(const RTT::Seconds period);
+
+  private:
+    // True once the output has been initialized from an input
+    bool initialized_;
+  };
+
+  //! Compute a PID control effort from an error vector
+  class PID : public VectorFilter
+  {
+    // RTT properties
+    Eigen::VectorXd
+      p_gains_,
+      i_gains_,
+      d_gains_,
+      i_limits_;
+
+  public:
+    PID(std::string const& name);
+
+  protected:
+    virtual bool configureFilter();
+    virtual void resetFilter();
+    virtual void filter(const RTT::Seconds period);
+
+  private:
+    // True once the last error has been initialized from an input
+    bool initialized_;
+
+    // State (preallocated in configureHook)
+    Eigen::VectorXd
+      last_error_,
+      integral_;
+  };
+}
+
+#endif // ifndef __CONMAN_BLOCKS_CONTROL_BLOCKS_H
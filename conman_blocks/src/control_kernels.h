@@ -0,0 +1,96 @@
+#ifndef __CONMAN_BLOCKS_CONTROL_KERNELS_H
+#define __CONMAN_BLOCKS_CONTROL_KERNELS_H
+
+#include <Eigen/Dense>
+
+namespace conman_blocks {
+  namespace kernels {
+
+    /** \name Joint-Vector Control Kernels
+     *
+     * These process all of the coefficients of a vector at once with
+     * coefficient-wise Eigen expressions, so they are vectorized and don't
+     * create any temporaries. They can be used with preallocated dynamic
+     * vectors or with fixed-size vectors, and except for PID, the output can
+     * alias the input.
+     */
+    //\{
+
+    //! y = k .* x
+    template <class Vector>
+    inline void Gain(const Vector &gains, const Vector &x, Vector &y)
+    {
+      y = gains.cwiseProduct(x);
+    }
+
+    //! Clamp x to [-limits, limits]
+    template <class Vector>
+    inline void Saturate(const Vector &limits, const Vector &x, Vector &y)
+    {
+      y = x.cwiseMin(limits).cwiseMax(-limits);
+    }
+
+    //! Zero x inside of [-widths, widths] and shift it towards zero outside
+    template <class Vector>
+    inline void Deadband(const Vector &widths, const Vector &x, Vector &y)
+    {
+      // This is x minus x clamped to the deadband, which vectorizes unlike
+      // sign()
+      y = x - x.cwiseMin(widths).cwiseMax(-widths);
+    }
+
+    //! Move y towards x by at most rates * dt
+    template <class Vector>
+    inline void RateLimit(const Vector &rates, const double dt, const Vector &x, Vector &y)
+    {
+      y += (x - y).cwiseMin(dt * rates).cwiseMax(-dt * rates);
+    }
+
+    //! y = a + s * (b - a)
+    template <class Vector>
+    inline void Interpolate(const double s, const Vector &a, const Vector &b, Vector &y)
+    {
+      y = a + s * (b - a);
+    }
+
+    /** \brief Compute a PID control effort
+     *
+     * \param dt The time since the last error (the integral and derivative
+     * terms are only updated if this is positive)
+     * \param error The current error
+     * \param last_error The previous error (updated to the current error)
+     * \param integral The integral of the error (clamped to the integral
+     * limits)
+     * \param y The control effort
+     *
+     * The error is read after y and the state are written, so none of them
+     * can alias the error (or each other).
+     */
+    template <class Vector>
+    inline void PID(
+        const Vector &p_gains,
+        const Vector &i_gains,
+        const Vector &d_gains,
+        const Vector &i_limits,
+        const double dt,
+        const Vector &error,
+        Vector &last_error,
+        Vector &integral,
+        Vector &y)
+    {
+      if(dt > 0.0) {
+        integral = (integral + dt * error).cwiseMin(i_limits).cwiseMax(-i_limits);
+        y = p_gains.cwiseProduct(error)
+          + i_gains.cwiseProduct(integral)
+          + d_gains.cwiseProduct(error - last_error) / dt;
+      } else {
+        y = p_gains.cwiseProduct(error) + i_gains.cwiseProduct(integral);
+      }
+      last_error = error;
+    }
+
+    //\}
+  }
+}
+
+#endif // ifndef __CONMAN_BLOCKS_CONTROL_KERNELS_H
@@ -0,0 +1,58 @@
+#ifndef __CONMAN_BLOCKS_DIMENSION_GUARD_H
+#define __CONMAN_BLOCKS_DIMENSION_GUARD_H
+
+#include <rtt/RTT.hpp>
+#include <rtt/Port.hpp>
+
+#include <Eigen/Dense>
+
+namespace conman_blocks {
+
+  /** \brief Reject input samples with the wrong dimension
+   *
+   * The blocks declare their port dimensions in configureHook, and a scheme
+   * checks them when it models a connection. Connections made outside of a
+   * scheme are never checked, and connections which a scheme modeled before
+   * the blocks were configured are only checked once it regenerates its
+   * model or is started, so each sample is still checked before it's used.
+   *
+   * A mismatch puts the block in the error state. Only the first mismatch
+   * after the block is started is logged, since logging can allocate.
+   */
+  class DimensionGuard
+  {
+  public:
+    DimensionGuard() : logged_(false) { }
+
+    //! Log the next mismatch (call this when the block is started)
+    void reset()
+    {
+      logged_ = false;
+    }
+
+    //! Return true if a sample read from a port has the given dimension
+    bool check(
+        RTT::TaskContext *block,
+        const RTT::base::PortInterface &port,
+        const Eigen::VectorXd &sample,
+        const int dim)
+    {
+      if(sample.size() == dim) {
+        return true;
+      }
+
+      if(!logged_) {
+        RTT::log(RTT::Error) << "Component \"" << block->getName() << "\" read a sample with dimension " << sample.size() << " from port \"" << port.getName() << "\" but it should have dimension " << dim << "." << RTT::endlog();
+        logged_ = true;
+      }
+
+      block->error();
+      return false;
+    }
+
+  private:
+    bool logged_;
+  };
+}
+
+#endif // ifndef __CONMAN_BLOCKS_DIMENSION_GUARD_H
@@ -1,10 +1,13 @@
 
+#include <limits>
+
 #include <Eigen/Dense>
 
 #include <conman/hook.h>
 #include <rtt_rosparam/rosparam.h>
 #include <rtt_roscomm/rtt_rostopic.h>
 
+#include "control_kernels.h"
 #include "feed_forward_feed_back.h"
 
 using namespace conman_blocks;
@@ -12,20 +15,41 @@ using namespace conman_blocks;
 FeedForwardFeedBack::FeedForwardFeedBack(std::string const& name) :
   TaskContext(name)
   ,dim_(0)
-  ,sum_()
-  ,feedback_effort_()
-  ,require_heartbeat_(false)
-  ,heartbeat_max_period_(0.01)
-  ,heartbeat_lifetime_(0.0)
   // Haha... dim sum.
-  ,feedforward_in_("feedforward_in",RTT::ConnPolicy::buffer(17))
-  ,enable_feedback_(true)
-  ,enable_duration_(3.0)
-  ,disable_duration_(0.1)
+  // Each writer contributes its latest sample once per cycle
+  ,feedforward_in_("feedforward_in",RTT::ConnPolicy::data())
+  ,fixed_dim_(false)
+  ,ops_(kernels::SelectVectorOps(0))
+{
+  this->addInterface();
+}
+
+FeedForwardFeedBack::FeedForwardFeedBack(std::string const& name, const kernels::VectorOps &fixed_ops) :
+  TaskContext(name)
+  ,dim_(fixed_ops.dim)
+  ,feedforward_in_("feedforward_in",RTT::ConnPolicy::data())
+  ,fixed_dim_(true)
+  ,ops_(fixed_ops)
 {
+  this->addInterface();
+}
+
+void FeedForwardFeedBack::addInterface()
+{
+  // Set the defaults shared by both constructors
+  require_heartbeat_ = false;
+  heartbeat_ = 0;
+  heartbeat_max_period_ = 0.01;
+  heartbeat_lifetime_ = 0.0;
+  heartbeat_warning_ = false;
+  enable_feedback_ = true;
+  enable_duration_ = 3.0;
+  disable_duration_ = 0.1;
+  heartbeat_period_ = 0.0;
+
   // Declare properties
   this->addProperty("dim",dim_)
-    .doc("The dimension of the .");
+    .doc("The dimension of the efforts.");
   this->addProperty("require_heartbeat", require_heartbeat_)
     .doc("If true, feedback effort will be disabled if there is no heartbeat heartbeat.");
   this->addProperty("heartbeat_max_period", heartbeat_max_period_)
@@ -68,22 +92,56 @@ bool FeedForwardFeedBack::configureHook()
 {
   boost::shared_ptr<rtt_rosparam::ROSParam> rosparam =
     this->getProvider<rtt_rosparam::ROSParam>("rosparam");
-  rosparam->getComponentPrivate("dim");
-  feedback_effort_limits_.resize(dim_);
-  feedback_effort_.resize(dim_);
-  sum_.resize(dim_);
+  if(rosparam) {
+    rosparam->getComponentPrivate("dim");
+  }
 
-  rosparam->getComponentPrivate("require_heartbeat");
-  rosparam->getComponentPrivate("heartbeat_max_period");
-  rosparam->getComponentPrivate("enable_duration");
-  rosparam->getComponentPrivate("disable_duration");
-  rosparam->getComponentPrivate("feedback_effort_limits");
+  // Get the kernels for this dimension
+  if(fixed_dim_) {
+    if(dim_ != ops_.dim) {
+      RTT::log(RTT::Error) << "FeedForwardFeedBack component \"" << this->getName() << "\" has a fixed dimension of " << ops_.dim << " but the \"dim\" property is " << dim_ << "." << RTT::endlog();
+      return false;
+    }
+  } else {
+    ops_ = kernels::SelectVectorOps(dim_);
+  }
+
+  // Preallocate the working samples so that reading the inputs never
+  // reallocates them
+  feedback_effort_.setZero(dim_);
+  addend_.setZero(dim_);
+  sum_.setZero(dim_);
+
+  // Size the samples in the output connections
+  sum_out_.setDataSample(sum_);
+
+  // Declare the port dimensions so the scheme rejects mismatched connections
+  conman_hook_->setPortDimension("feedforward_in", dim_);
+  conman_hook_->setPortDimension("feedback_in", dim_);
+  conman_hook_->setPortDimension("sum_out", dim_);
+
+  if(rosparam) {
+    rosparam->getComponentPrivate("require_heartbeat");
+    rosparam->getComponentPrivate("heartbeat_max_period");
+    rosparam->getComponentPrivate("enable_duration");
+    rosparam->getComponentPrivate("disable_duration");
+    rosparam->getComponentPrivate("feedback_effort_limits");
+  }
+
+  // The feedback efforts are unlimited unless limits are given
+  if(feedback_effort_limits_.size() == 0) {
+    feedback_effort_limits_.setConstant(dim_, std::numeric_limits<double>::infinity());
+  } else if(feedback_effort_limits_.size() != dim_) {
+    RTT::log(RTT::Error) << "The feedback effort limits should have dimension " << dim_ << " but they have dimension " << feedback_effort_limits_.size() << "." << RTT::endlog();
+    return false;
+  }
 
   return true;
 }
 
 bool FeedForwardFeedBack::startHook()
 {
+  dimension_guard_.reset();
   /*
    *interpolate_effort = true;
    *interpolation_scale = 0.0;
@@ -94,18 +152,14 @@ bool FeedForwardFeedBack::startHook()
 void FeedForwardFeedBack::updateHook()
 {
   // Reset the accumulator
-  sum_.setZero();
+  ops_.set_zero(sum_);
   bool has_new_data = false;
 
   // Get the feedforward
-  Eigen::VectorXd addend;
-  while(feedforward_in_.read( addend, false ) == RTT::NewData) {
-    if(addend.size() == dim_) {
-      sum_ += addend;
+  while(feedforward_in_.read( addend_, false ) == RTT::NewData) {
+    if(dimension_guard_.check(this, feedforward_in_, addend_, dim_)) {
+      ops_.add_scaled(sum_, 1.0, addend_);
       has_new_data = true;
-    } else {
-      RTT::log(RTT::Error) << "Feed-forward input to FeedForwardFeedBack component does not have the correct dimension. All inputs should have dimension "<<dim_<<" but this input had dimension " << addend.size();
-      this->error();
     }
   }
 
@@ -130,8 +184,9 @@ void FeedForwardFeedBack::updateHook()
     {
       // Get the feedback
       if(feedback_in_.readNewest( feedback_effort_, false) == RTT::NewData) {
-        if(feedback_effort_.size() == dim_) {
-          sum_ += std::min(1.0,(heartbeat_lifetime_/enable_duration_)) * feedback_effort_;
+        if(dimension_guard_.check(this, feedback_in_, feedback_effort_, dim_)) {
+          kernels::Saturate(feedback_effort_limits_, feedback_effort_, feedback_effort_);
+          ops_.add_scaled(sum_, std::min(1.0,(heartbeat_lifetime_/enable_duration_)), feedback_effort_);
           has_new_data = true;
 
           // TODO:::::::::::::::::
@@ -149,15 +204,12 @@ void FeedForwardFeedBack::updateHook()
    *          }
    *        }
    */
-        } else {
-          RTT::log(RTT::Error) << "Feed-back input to FeedForwardFeedBack component does not have the correct dimension. All inputs should have dimension "<<dim_<<" but this input had dimension " << addend.size();
-          this->error();
         }
       }
     } else {
       heartbeat_lifetime_ = 0.0;
       if(!heartbeat_warning_) { 
-        RTT::log(RTT::Warning) << "Heartbeats are not being sent often enough (should be < " << heartbeat_max_period_ << " s). Disabling feedback effort." << addend.size();
+        RTT::log(RTT::Warning) << "Heartbeats are not being sent often enough (should be < " << heartbeat_max_period_ << " s). Disabling feedback effort." << RTT::endlog();
         heartbeat_warning_ = true;
       }
     }
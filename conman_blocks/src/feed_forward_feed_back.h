@@ -8,6 +8,9 @@
 
 #include <conman/hook.h>
 
+#include "dimension_guard.h"
+#include "vector_kernels.h"
+
 #include <std_msgs/Empty.h>
 #include <rtt_rosclock/rtt_rosclock.h>
 
@@ -32,11 +35,23 @@ namespace conman_blocks {
     virtual void stopHook();
     virtual void cleanupHook();
 
+  protected:
+    // Construct a block with a dimension fixed at compile-time
+    FeedForwardFeedBack(std::string const& name, const kernels::VectorOps &fixed_ops);
+
   private:
+    // Declare the properties, ports and conman interface
+    void addInterface();
+
+    // The vector kernels (fixed-size if the dimension is fixed or has a
+    // specialization)
+    bool fixed_dim_;
+    kernels::VectorOps ops_;
 
-    // Working variables
+    // Working variables (preallocated in configureHook)
     Eigen::VectorXd 
       sum_,
+      addend_,
       feedback_effort_;
 
     bool require_heartbeat_;
@@ -53,9 +68,27 @@ namespace conman_blocks {
     double heartbeat_period_;
     Eigen::VectorXd feedback_effort_limits_;
 
+    // Rejects inputs with the wrong dimension
+    DimensionGuard dimension_guard_;
+
     // Conman interface
     boost::shared_ptr<conman::Hook> conman_hook_;
   };
+
+  //! FeedForwardFeedBack with a dimension fixed at compile-time
+  template <int N>
+  class FixedFeedForwardFeedBack : public FeedForwardFeedBack
+  {
+  public:
+    FixedFeedForwardFeedBack(std::string const& name) :
+      FeedForwardFeedBack(name, kernels::GetVectorOps<N>())
+    { }
+  };
+
+  typedef FixedFeedForwardFeedBack<3> FeedForwardFeedBack3;
+  typedef FixedFeedForwardFeedBack<4> FeedForwardFeedBack4;
+  typedef FixedFeedForwardFeedBack<6> FeedForwardFeedBack6;
+  typedef FixedFeedForwardFeedBack<7> FeedForwardFeedBack7;
 }
 
 
@@ -0,0 +1,121 @@
+
+#include <algorithm>
+
+#include "control_kernels.h"
+#include "rate_transition.h"
+
+using namespace conman_blocks;
+
+RateTransition::RateTransition(std::string const& name) :
+  VectorFilter(name, "in", "out")
+  ,mode_("hold")
+  ,decimation_(1)
+  ,transition_mode_(HOLD)
+  ,initialized_(false)
+  ,input_period_(0.0)
+  ,n_updates_(0)
+  ,n_inputs_(0)
+  ,last_input_()
+  ,next_input_()
+  ,accumulator_()
+{
+  this->addProperty("mode",mode_)
+    .doc("The rate transition: \"hold\", \"interpolate\", or \"average\".");
+  this->addProperty("decimation",decimation_)
+    .doc("The number of updates to average over before each output in \"average\" mode.");
+}
+
+bool RateTransition::configureFilter()
+{
+  if(mode_ == "hold") {
+    transition_mode_ = HOLD;
+  } else if(mode_ == "interpolate") {
+    transition_mode_ = INTERPOLATE;
+  } else if(mode_ == "average") {
+    transition_mode_ = AVERAGE;
+  } else {
+    RTT::log(RTT::Error) << "Unknown RateTransition mode \"" << mode_ << "\". It should be \"hold\", \"interpolate\", or \"average\"." << RTT::endlog();
+    return false;
+  }
+
+  if(decimation_ < 1) {
+    RTT::log(RTT::Error) << "The RateTransition decimation should be at least 1 but it is " << decimation_ << "." << RTT::endlog();
+    return false;
+  }
+
+  last_input_.setZero(dim_);
+  next_input_.setZero(dim_);
+  accumulator_.setZero(dim_);
+
+  return true;
+}
+
+void RateTransition::resetFilter()
+{
+  initialized_ = false;
+  input_period_ = 0.0;
+  n_updates_ = 0;
+  n_inputs_ = 0;
+  accumulator_.setZero();
+}
+
+void RateTransition::writeOutput(const bool filtered)
+{
+  // Write the output at this rate, whether or not there was a new input
+  switch(transition_mode_) {
+    case HOLD:
+      if(initialized_) {
+        out_.write( output_ );
+      }
+      break;
+
+    case INTERPOLATE:
+      if(initialized_) {
+        // Move from the last input to the next input over the input period
+        const double s = (input_period_ > 0.0)
+          ? std::min(1.0, (time_ - input_time_) / input_period_)
+          : 1.0;
+        kernels::Interpolate(s, last_input_, next_input_, output_);
+        out_.write( output_ );
+      }
+      break;
+
+    case AVERAGE:
+      if(++n_updates_ >= decimation_) {
+        if(n_inputs_ > 0) {
+          output_ = accumulator_ / n_inputs_;
+          out_.write( output_ );
+        }
+        accumulator_.setZero();
+        n_updates_ = 0;
+        n_inputs_ = 0;
+      }
+      break;
+  };
+}
+
+void RateTransition::filter(const RTT::Seconds period)
+{
+  switch(transition_mode_) {
+    case HOLD:
+      output_ = input_;
+      break;
+
+    case INTERPOLATE:
+      if(initialized_) {
+        last_input_ = next_input_;
+        input_period_ = period;
+      } else {
+        last_input_ = input_;
+      }
+      next_input_ = input_;
+      break;
+
+    case AVERAGE:
+      accumulator_ += input_;
+      n_inputs_++;
+      break;
+  };
+
+  initialized_ = true;
+}
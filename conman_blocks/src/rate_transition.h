@@ -0,0 +1,59 @@
+#ifndef __CONMAN_BLOCKS_RATE_TRANSITION_H
+#define __CONMAN_BLOCKS_RATE_TRANSITION_H
+
+#include <Eigen/Dense>
+
+#include "vector_filter.h"
+
+namespace conman_blocks {
+
+  /** \brief Connect blocks which run at different rates
+   *
+   * This block runs at the faster of the two rates and writes one sample to
+   * the slower side without any buffering:
+   *  - "hold": Write the latest input on every update (zero-order hold).
+   *  - "interpolate": Linearly interpolate between the last two inputs over
+   *    the period between them. This delays the input by one input period.
+   *  - "average": Write the average of the inputs received over the last
+   *    "decimation" updates once every "decimation" updates.
+   *
+   * The state is preallocated in configureHook, and each update is O(dim).
+   */
+  class RateTransition : public VectorFilter
+  {
+    // RTT properties
+    std::string mode_;
+    int decimation_;
+
+  public:
+    RateTransition(std::string const& name);
+
+  protected:
+    virtual bool configureFilter();
+    virtual void resetFilter();
+    virtual void filter(const RTT::Seconds period);
+    virtual void writeOutput(const bool filtered);
+
+  private:
+    enum Mode { HOLD, INTERPOLATE, AVERAGE };
+    Mode transition_mode_;
+
+    // True once an input has been received
+    bool initialized_;
+
+    // Interpolation state
+    RTT::Seconds input_period_;
+
+    // Averaging state
+    int n_updates_;
+    int n_inputs_;
+
+    // State (preallocated in configureHook)
+    Eigen::VectorXd
+      last_input_,
+      next_input_,
+      accumulator_;
+  };
+}
+
+#endif // ifndef __CONMAN_BLOCKS_RATE_TRANSITION_H
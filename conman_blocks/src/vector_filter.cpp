@@ -0,0 +1,135 @@
+
+#include <vector>
+
+#include <conman/hook.h>
+#include <rtt_rosparam/rosparam.h>
+
+#include "vector_filter.h"
+
+using namespace conman_blocks;
+
+VectorFilter::VectorFilter(
+    std::string const& name,
+    std::string const& in_name,
+    std::string const& out_name) :
+  TaskContext(name)
+  ,dim_(0)
+  ,in_(in_name)
+  ,out_(out_name)
+  ,input_()
+  ,output_()
+  ,time_(0.0)
+  ,has_input_(false)
+  ,input_time_(0.0)
+{
+  // Declare properties
+  this->addProperty("dim",dim_)
+    .doc("The dimension of the vectors.");
+
+  // Configure data ports
+  this->ports()->addPort(in_name, in_);
+  this->ports()->addPort(out_name, out_);
+
+  // Load Conman interface
+  conman_hook_ = conman::Hook::GetHook(this);
+  conman_hook_->setInputExclusivity(in_name, conman::Exclusivity::EXCLUSIVE);
+}
+
+bool VectorFilter::configureHook()
+{
+  // Load all of the properties (including the subclass parameters)
+  boost::shared_ptr<rtt_rosparam::ROSParam> rosparam =
+    this->getProvider<rtt_rosparam::ROSParam>("rosparam");
+  if(rosparam) {
+    const std::vector<std::string> names = this->properties()->list();
+    for(std::vector<std::string>::const_iterator it = names.begin();
+        it != names.end();
+        ++it)
+    {
+      rosparam->getComponentPrivate(*it);
+    }
+  }
+
+  // Preallocate the working samples so that reading the input never
+  // reallocates them
+  input_.setZero(dim_);
+  output_.setZero(dim_);
+
+  if(!this->configureFilter()) {
+    return false;
+  }
+
+  // Size the samples in the output connections
+  out_.setDataSample(output_);
+
+  // Declare the port dimensions so the scheme rejects mismatched connections
+  conman_hook_->setPortDimension(in_.getName(), dim_);
+  conman_hook_->setPortDimension(out_.getName(), dim_);
+
+  return true;
+}
+
+bool VectorFilter::startHook()
+{
+  dimension_guard_.reset();
+  has_input_ = false;
+  this->resetFilter();
+  return true;
+}
+
+void VectorFilter::updateHook()
+{
+  time_ = conman_hook_->getTime();
+
+  const bool filtered = this->readInput();
+  this->writeOutput(filtered);
+}
+
+bool VectorFilter::readInput()
+{
+  if(in_.readNewest( input_, false ) != RTT::NewData ||
+     !dimension_guard_.check(this, in_, input_, dim_))
+  {
+    return false;
+  }
+
+  // The filter only runs when there's a new input, so it's given the time
+  // since the previous input instead of the update period
+  const RTT::Seconds period = has_input_ ? time_ - input_time_ : 0.0;
+  has_input_ = true;
+  input_time_ = time_;
+
+  this->filter(period);
+
+  return true;
+}
+
+void VectorFilter::writeOutput(const bool filtered)
+{
+  if(filtered) {
+    out_.write( output_ );
+  }
+}
+
+void VectorFilter::stopHook()
+{
+}
+
+void VectorFilter::cleanupHook()
+{
+}
+
+bool VectorFilter::sizeParameter(
+    const std::string &name,
+    Eigen::VectorXd &parameter,
+    const double default_value)
+{
+  if(parameter.size() == 0) {
+    parameter.setConstant(dim_, default_value);
+  } else if(parameter.size() != dim_) {
+    RTT::log(RTT::Error) << "Parameter \"" << name << "\" of component \"" << this->getName() << "\" should have dimension " << dim_ << " but it has dimension " << parameter.size() << "." << RTT::endlog();
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,97 @@
+#ifndef __CONMAN_BLOCKS_VECTOR_FILTER_H
+#define __CONMAN_BLOCKS_VECTOR_FILTER_H
+
+#include <rtt/RTT.hpp>
+#include <rtt/Port.hpp>
+
+#include <Eigen/Dense>
+
+#include <conman/hook.h>
+
+#include "dimension_guard.h"
+
+namespace conman_blocks {
+
+  /** \brief Base for blocks which map one joint vector to another
+   *
+   * This handles the dimension, the ports, and the conman interface. The
+   * input and output samples are preallocated in configureHook, and the
+   * subclass computes the output from the input in filter(), which must not
+   * allocate.
+   */
+  class VectorFilter : public RTT::TaskContext
+  {
+  protected:
+    // RTT properties
+    int dim_;
+
+    // RTT Ports
+    RTT::InputPort<Eigen::VectorXd> in_;
+    RTT::OutputPort<Eigen::VectorXd> out_;
+
+  public:
+    VectorFilter(
+        std::string const& name,
+        std::string const& in_name,
+        std::string const& out_name);
+    virtual bool configureHook();
+    virtual bool startHook();
+    virtual void updateHook();
+    virtual void stopHook();
+    virtual void cleanupHook();
+
+  protected:
+    //! Size the parameters once the dimension is known
+    virtual bool configureFilter() = 0;
+    //! Reset any state when the block is started
+    virtual void resetFilter() { }
+    /** \brief Compute output_ from input_
+     *
+     * \param period The time since the previous input (zero for the first
+     * input after the block is started)
+     */
+    virtual void filter(const RTT::Seconds period) = 0;
+
+    /** \brief Read and filter a new input, if there is one
+     *
+     * This is the first step of updateHook. It returns true if output_ was
+     * computed from a new input.
+     */
+    bool readInput();
+    /** \brief Write the output
+     *
+     * This is the second step of updateHook. By default, the output is only
+     * written when it was computed from a new input.
+     */
+    virtual void writeOutput(const bool filtered);
+
+    /** \brief Check the size of a parameter vector
+     *
+     * An empty parameter is set to the default value for each coefficient.
+     */
+    bool sizeParameter(
+        const std::string &name,
+        Eigen::VectorXd &parameter,
+        const double default_value);
+
+    // Working variables (preallocated in configureHook)
+    Eigen::VectorXd
+      input_,
+      output_;
+
+    // Rejects inputs with the wrong dimension
+    DimensionGuard dimension_guard_;
+
+    // The time of the current update
+    RTT::Seconds time_;
+
+    // The time of the previous input (valid once has_input_ is set)
+    bool has_input_;
+    RTT::Seconds input_time_;
+
+    // Conman interface
+    boost::shared_ptr<conman::Hook> conman_hook_;
+  };
+}
+
+#endif // ifndef __CONMAN_BLOCKS_VECTOR_FILTER_H
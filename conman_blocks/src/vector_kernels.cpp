@@ -0,0 +1,21 @@
+
+#include "vector_kernels.h"
+
+namespace conman_blocks {
+  namespace kernels {
+
+    VectorOps SelectVectorOps(const int dim)
+    {
+      // Specializations for cartesian vectors, twists, and common arms and
+      // hands
+      switch(dim) {
+        case 3: return GetVectorOps<3>();
+        case 4: return GetVectorOps<4>();
+        case 6: return GetVectorOps<6>();
+        case 7: return GetVectorOps<7>();
+        default: return GetVectorOps<Eigen::Dynamic>();
+      };
+    }
+
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef __CONMAN_BLOCKS_VECTOR_KERNELS_H
+#define __CONMAN_BLOCKS_VECTOR_KERNELS_H
+
+#include <Eigen/Dense>
+
+namespace conman_blocks {
+  namespace kernels {
+
+    //! The operation used to combine vectors coefficient-wise
+    enum Reduction { SUM, MAX, MIN };
+
+    /** \brief Vector kernels for a given dimension
+     *
+     * The samples are passed as dynamic vectors so that the port types (and
+     * typekits) don't change, but for a fixed dimension N they are mapped onto
+     * fixed-size vectors so that Eigen can unroll and vectorize the loops.
+     * The samples need to be preallocated with N coefficients.
+     */
+    template <int N>
+    struct VectorKernels
+    {
+      typedef Eigen::Matrix<double,N,1> Vector;
+      typedef Eigen::Map<Vector,Eigen::Aligned> Map;
+      typedef Eigen::Map<const Vector,Eigen::Aligned> ConstMap;
+
+      static void SetZero(Eigen::VectorXd &y)
+      {
+        Map(y.data(), y.size()).setZero();
+      }
+
+      static void Assign(Eigen::VectorXd &y, const Eigen::VectorXd &x)
+      {
+        Map(y.data(), y.size()) = ConstMap(x.data(), x.size());
+      }
+
+      static void Reduce(const Reduction reduction, Eigen::VectorXd &y, const Eigen::VectorXd &x)
+      {
+        Map y_map(y.data(), y.size());
+        ConstMap x_map(x.data(), x.size());
+
+        switch(reduction) {
+          case SUM: y_map += x_map; break;
+          case MAX: y_map = y_map.cwiseMax(x_map); break;
+          case MIN: y_map = y_map.cwiseMin(x_map); break;
+        };
+      }
+
+      static void AddScaled(Eigen::VectorXd &y, const double a, const Eigen::VectorXd &x)
+      {
+        Map(y.data(), y.size()) += a * ConstMap(x.data(), x.size());
+      }
+    };
+
+    //! A set of vector kernels for one dimension
+    struct VectorOps
+    {
+      //! The dimension of the kernels (Eigen::Dynamic for any dimension)
+      int dim;
+
+      void (*set_zero)(Eigen::VectorXd &y);
+      void (*assign)(Eigen::VectorXd &y, const Eigen::VectorXd &x);
+      void (*reduce)(const Reduction reduction, Eigen::VectorXd &y, const Eigen::VectorXd &x);
+      void (*add_scaled)(Eigen::VectorXd &y, const double a, const Eigen::VectorXd &x);
+    };
+
+    //! Get the kernels for a dimension known at compile-time
+    template <int N>
+    VectorOps GetVectorOps()
+    {
+      VectorOps ops;
+      ops.dim = N;
+      ops.set_zero = &VectorKernels<N>::SetZero;
+      ops.assign = &VectorKernels<N>::Assign;
+      ops.reduce = &VectorKernels<N>::Reduce;
+      ops.add_scaled = &VectorKernels<N>::AddScaled;
+      return ops;
+    }
+
+    /** \brief Get the kernels for a dimension known at runtime
+     *
+     * This returns the fixed-size kernels if there is a specialization for
+     * the dimension, and the dynamic kernels otherwise.
+     */
+    VectorOps SelectVectorOps(const int dim);
+  }
+}
+
+#endif // ifndef __CONMAN_BLOCKS_VECTOR_KERNELS_H
@@ -11,13 +11,40 @@ using namespace conman_blocks;
 VectorSum::VectorSum(std::string const& name) :
   TaskContext(name)
   ,dim_(0)
-  ,sum_()
+  ,reduction_("sum")
   // Haha... dim sum.
-  ,addends_in_("addends_in",RTT::ConnPolicy::buffer(17))
+  // Each writer contributes its latest sample once per cycle
+  ,addends_in_("addends_in",RTT::ConnPolicy::data())
+  ,reduction_mode_(kernels::SUM)
+  ,fixed_dim_(false)
+  ,ops_(kernels::SelectVectorOps(0))
+  ,sum_()
+  ,addend_()
+{
+  this->addInterface();
+}
+
+VectorSum::VectorSum(std::string const& name, const kernels::VectorOps &fixed_ops) :
+  TaskContext(name)
+  ,dim_(fixed_ops.dim)
+  ,reduction_("sum")
+  ,addends_in_("addends_in",RTT::ConnPolicy::data())
+  ,reduction_mode_(kernels::SUM)
+  ,fixed_dim_(true)
+  ,ops_(fixed_ops)
+  ,sum_()
+  ,addend_()
+{
+  this->addInterface();
+}
+
+void VectorSum::addInterface()
 {
   // Declare properties
   this->addProperty("dim",dim_)
-    .doc("The gravity vector in the root link frame.");
+    .doc("The dimension of the vectors.");
+  this->addProperty("reduction",reduction_)
+    .doc("The operation used to combine the inputs: \"sum\", \"max\", or \"min\" (coefficient-wise).");
 
   // Configure data ports
   this->ports()->addPort("addends_in", addends_in_);
@@ -32,33 +59,68 @@ bool VectorSum::configureHook()
 {
   boost::shared_ptr<rtt_rosparam::ROSParam> rosparam =
     this->getProvider<rtt_rosparam::ROSParam>("rosparam");
-  rosparam->getComponentPrivate("dim");
+  if(rosparam) {
+    rosparam->getComponentPrivate("dim");
+    rosparam->getComponentPrivate("reduction");
+  }
+
+  if(reduction_ == "sum") {
+    reduction_mode_ = kernels::SUM;
+  } else if(reduction_ == "max") {
+    reduction_mode_ = kernels::MAX;
+  } else if(reduction_ == "min") {
+    reduction_mode_ = kernels::MIN;
+  } else {
+    RTT::log(RTT::Error) << "Unknown VectorSum reduction \"" << reduction_ << "\". It should be \"sum\", \"max\", or \"min\"." << RTT::endlog();
+    return false;
+  }
+
+  // Get the kernels for this dimension
+  if(fixed_dim_) {
+    if(dim_ != ops_.dim) {
+      RTT::log(RTT::Error) << "VectorSum component \"" << this->getName() << "\" has a fixed dimension of " << ops_.dim << " but the \"dim\" property is " << dim_ << "." << RTT::endlog();
+      return false;
+    }
+  } else {
+    ops_ = kernels::SelectVectorOps(dim_);
+  }
+
+  // Preallocate the working samples so that reading the addends never
+  // reallocates them
+  sum_.setZero(dim_);
+  addend_.setZero(dim_);
+
+  // Size the samples in the output connections
+  sum_out_.setDataSample(sum_);
+
+  // Declare the port dimensions so the scheme rejects mismatched connections
+  conman_hook_->setPortDimension("addends_in", dim_);
+  conman_hook_->setPortDimension("sum_out", dim_);
 
-  sum_.resize(dim_);
   return true;
 }
 
 bool VectorSum::startHook()
 {
+  dimension_guard_.reset();
   return true;
 }
 
 void VectorSum::updateHook()
 {
-  // Reset the accumulator
-  sum_.setZero();
-
-  // Get the addends
+  // Reduce the inputs in-place (the first input initializes the accumulator)
   bool has_new_data = false;
-  Eigen::VectorXd addend;
-  while(addends_in_.read( addend, false ) == RTT::NewData) {
-    if(addend.size() == dim_) {
-      sum_ += addend;
-      has_new_data = true;
+  while(addends_in_.read( addend_, false ) == RTT::NewData) {
+    if(!dimension_guard_.check(this, addends_in_, addend_, dim_)) {
+      continue;
+    }
+
+    if(!has_new_data) {
+      ops_.assign(sum_, addend_);
     } else {
-      RTT::log(RTT::Error) << "Input to VectorSum component does not have the correct dimension. All inputs should have dimension "<<dim_<<" but this input had dimension " << addend.size();
-      this->error();
+      ops_.reduce(reduction_mode_, sum_, addend_);
     }
+    has_new_data = true;
   }
 
   // Write the sum
@@ -8,11 +8,25 @@
 
 #include <conman/hook.h>
 
+#include "dimension_guard.h"
+#include "vector_kernels.h"
+
 namespace conman_blocks {
+
+  /** \brief Reduce the vectors from several writers into one
+   *
+   * Each writer connected to "addends_in" contributes its latest sample once
+   * per update, and the samples are summed (or their coefficient-wise max or
+   * min is taken) into a preallocated accumulator. The reduction happens in
+   * this block: a scheme doesn't combine the samples of the writers
+   * connected to an UNRESTRICTED input, so fan-in should go through a block
+   * like this one.
+   */
   class VectorSum : public RTT::TaskContext
   {
     // RTT properties
     int dim_;
+    std::string reduction_;
 
     // RTT Ports
     RTT::InputPort<Eigen::VectorXd> addends_in_;
@@ -26,14 +40,48 @@ namespace conman_blocks {
     virtual void stopHook();
     virtual void cleanupHook();
 
+  protected:
+    // Construct a block with a dimension fixed at compile-time
+    VectorSum(std::string const& name, const kernels::VectorOps &fixed_ops);
+
   private:
+    // Declare the properties, ports and conman interface
+    void addInterface();
+
+    // The operation used to combine the inputs
+    kernels::Reduction reduction_mode_;
+
+    // The vector kernels (fixed-size if the dimension is fixed or has a
+    // specialization)
+    const bool fixed_dim_;
+    kernels::VectorOps ops_;
+
+    // Working variables (preallocated in configureHook)
+    Eigen::VectorXd 
+      sum_,
+      addend_;
 
-    // Working variables
-    Eigen::VectorXd sum_;
+    // Rejects addends with the wrong dimension
+    DimensionGuard dimension_guard_;
 
     // Conman interface
     boost::shared_ptr<conman::Hook> conman_hook_;
   };
+
+  //! VectorSum with a dimension fixed at compile-time
+  template <int N>
+  class FixedVectorSum : public VectorSum
+  {
+  public:
+    FixedVectorSum(std::string const& name) :
+      VectorSum(name, kernels::GetVectorOps<N>())
+    { }
+  };
+
+  typedef FixedVectorSum<3> VectorSum3;
+  typedef FixedVectorSum<4> VectorSum4;
+  typedef FixedVectorSum<6> VectorSum6;
+  typedef FixedVectorSum<7> VectorSum7;
 }
 
 
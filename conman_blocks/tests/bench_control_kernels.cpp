@@ -0,0 +1,108 @@
+/** Copyright (c) 2013, Jonathan Bohren, all rights reserved.
+ * This software is released under the BSD 3-clause license, for the details of
+ * this license, please see LICENSE.txt at the root of this repository.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+#include <rtt/os/TimeService.hpp>
+
+#include <Eigen/Dense>
+
+#include "../src/control_kernels.h"
+
+using namespace conman_blocks;
+
+static const int dim = 7;
+static const int n_iterations = 1000000;
+
+// Accumulated so that the kernels can't be optimized away
+static volatile double checksum = 0.0;
+
+// Operands for the kernels (the inputs alternate so they can't be hoisted out
+// of the loops)
+template <class Vector>
+struct Operands
+{
+  Operands() :
+    a(Vector::Constant(dim, 0.5)),
+    b(Vector::Constant(dim, 0.1)),
+    y(Vector::Zero(dim)),
+    z(Vector::Zero(dim)),
+    w(Vector::Zero(dim))
+  {
+    x[0] = Vector::Random(dim);
+    x[1] = Vector::Random(dim);
+  }
+
+  Vector a, b, x[2], y, z, w;
+};
+
+template <class Vector>
+struct GainKernel {
+  static void Run(Operands<Vector> &o, const int i) { kernels::Gain(o.a, o.x[i&1], o.y); }
+};
+
+template <class Vector>
+struct SaturateKernel {
+  static void Run(Operands<Vector> &o, const int i) { kernels::Saturate(o.a, o.x[i&1], o.y); }
+};
+
+template <class Vector>
+struct DeadbandKernel {
+  static void Run(Operands<Vector> &o, const int i) { kernels::Deadband(o.b, o.x[i&1], o.y); }
+};
+
+template <class Vector>
+struct RateLimitKernel {
+  static void Run(Operands<Vector> &o, const int i) { kernels::RateLimit(o.a, 0.001, o.x[i&1], o.y); }
+};
+
+template <class Vector>
+struct PIDKernel {
+  static void Run(Operands<Vector> &o, const int i) {
+    kernels::PID(o.a, o.b, o.b, o.a, 0.001, o.x[i&1], o.z, o.w, o.y);
+  }
+};
+
+// Time one kernel, in nanoseconds per call
+template <template <class> class Kernel, class Vector>
+double Time()
+{
+  Operands<Vector> operands;
+
+  const RTT::os::TimeService::nsecs start = RTT::os::TimeService::Instance()->getNSecs();
+  for(int i=0; i < n_iterations; i++) {
+    Kernel<Vector>::Run(operands, i);
+  }
+  const RTT::os::TimeService::nsecs elapsed = RTT::os::TimeService::Instance()->getNSecs(start);
+
+  checksum += operands.y.sum();
+  return double(elapsed) / n_iterations;
+}
+
+template <template <class> class Kernel>
+void Report(const std::string &name)
+{
+  std::cout << std::setw(12) << name
+    << std::setw(12) << Time<Kernel, Eigen::VectorXd>()
+    << std::setw(12) << Time<Kernel, Eigen::Matrix<double,dim,1> >() << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  std::cout << "Nanoseconds per call over " << n_iterations << " calls with dimension " << dim << std::endl;
+  std::cout << std::setw(12) << "kernel"
+    << std::setw(12) << "dynamic"
+    << std::setw(12) << "fixed" << std::endl;
+
+  Report<GainKernel>("gain");
+  Report<SaturateKernel>("saturate");
+  Report<DeadbandKernel>("deadband");
+  Report<RateLimitKernel>("rate_limit");
+  Report<PIDKernel>("pid");
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+/** Copyright (c) 2013, Jonathan Bohren, all rights reserved.
+ * This software is released under the BSD 3-clause license, for the details of
+ * this license, please see LICENSE.txt at the root of this repository.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+#include <rtt/os/TimeService.hpp>
+
+#include <Eigen/Dense>
+
+#include "../src/vector_kernels.h"
+
+using namespace conman_blocks;
+
+static const int n_iterations = 1000000;
+
+// Accumulated so that the kernels can't be optimized away
+static volatile double checksum = 0.0;
+
+// Time one kernel, in nanoseconds per call
+static double TimeReduce(const kernels::VectorOps &ops, const int dim)
+{
+  Eigen::VectorXd sum = Eigen::VectorXd::Zero(dim);
+  Eigen::VectorXd addend = Eigen::VectorXd::Random(dim);
+
+  const RTT::os::TimeService::nsecs start = RTT::os::TimeService::Instance()->getNSecs();
+  for(int i=0; i < n_iterations; i++) {
+    ops.reduce(kernels::SUM, sum, addend);
+  }
+  const RTT::os::TimeService::nsecs elapsed = RTT::os::TimeService::Instance()->getNSecs(start);
+
+  checksum += sum.sum();
+  return double(elapsed) / n_iterations;
+}
+
+static double TimeAddScaled(const kernels::VectorOps &ops, const int dim)
+{
+  Eigen::VectorXd sum = Eigen::VectorXd::Zero(dim);
+  Eigen::VectorXd addend = Eigen::VectorXd::Random(dim);
+
+  const RTT::os::TimeService::nsecs start = RTT::os::TimeService::Instance()->getNSecs();
+  for(int i=0; i < n_iterations; i++) {
+    ops.add_scaled(sum, 0.5, addend);
+  }
+  const RTT::os::TimeService::nsecs elapsed = RTT::os::TimeService::Instance()->getNSecs(start);
+
+  checksum += sum.sum();
+  return double(elapsed) / n_iterations;
+}
+
+int main(int argc, char** argv)
+{
+  const int dims[] = {3, 4, 6, 7};
+  const kernels::VectorOps dynamic_ops = kernels::GetVectorOps<Eigen::Dynamic>();
+
+  std::cout << "Nanoseconds per call over " << n_iterations << " calls" << std::endl;
+  std::cout << std::setw(5) << "dim"
+    << std::setw(12) << "kernel"
+    << std::setw(12) << "dynamic"
+    << std::setw(12) << "fixed" << std::endl;
+
+  for(size_t i=0; i < sizeof(dims)/sizeof(dims[0]); i++) {
+    const int dim = dims[i];
+    const kernels::VectorOps fixed_ops = kernels::SelectVectorOps(dim);
+
+    std::cout << std::setw(5) << dim
+      << std::setw(12) << "reduce"
+      << std::setw(12) << TimeReduce(dynamic_ops, dim)
+      << std::setw(12) << TimeReduce(fixed_ops, dim) << std::endl;
+    std::cout << std::setw(5) << dim
+      << std::setw(12) << "add_scaled"
+      << std::setw(12) << TimeAddScaled(dynamic_ops, dim)
+      << std::setw(12) << TimeAddScaled(fixed_ops, dim) << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
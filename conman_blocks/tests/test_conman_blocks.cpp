@@ -0,0 +1,428 @@
+/** Copyright (c) 2013, Jonathan Bohren, all rights reserved.
+ * This software is released under the BSD 3-clause license, for the details of
+ * this license, please see LICENSE.txt at the root of this repository.
+ */
+
+#include <string>
+
+#include <rtt/os/startstop.h>
+#include <rtt/RTT.hpp>
+#include <rtt/Port.hpp>
+#include <rtt/extras/SlaveActivity.hpp>
+
+#include <Eigen/Dense>
+
+#include "../src/control_kernels.h"
+#include "../src/control_blocks.h"
+#include "../src/rate_transition.h"
+#include "../src/vector_kernels.h"
+#include "../src/vector_sum.h"
+#include "../src/feed_forward_feed_back.h"
+
+#include <gtest/gtest.h>
+
+// Count heap allocations so that the realtime paths can be checked
+#include <allocation_counter.h>
+
+class BlocksTest : public ::testing::Test {
+protected:
+  static const int dim = 7;
+
+  BlocksTest() :
+    a_out("a_out"),
+    b_out("b_out"),
+    feedback_out("feedback_out"),
+    sum_in("sum_in"),
+    a(Eigen::VectorXd::Constant(dim, 1.0)),
+    b(Eigen::VectorXd::Constant(dim, 2.0)),
+    sum(Eigen::VectorXd::Zero(dim))
+  {
+    a_out.setDataSample(a);
+    b_out.setDataSample(b);
+    feedback_out.setDataSample(b);
+  }
+
+  RTT::OutputPort<Eigen::VectorXd> a_out;
+  RTT::OutputPort<Eigen::VectorXd> b_out;
+  RTT::OutputPort<Eigen::VectorXd> feedback_out;
+  RTT::InputPort<Eigen::VectorXd> sum_in;
+
+  Eigen::VectorXd a, b, sum;
+};
+
+TEST_F(BlocksTest, VectorSumAllocation) {
+  conman_blocks::VectorSum vector_sum("vector_sum");
+  vector_sum.properties()->getPropertyType<int>("dim")->set(dim);
+  ASSERT_TRUE(vector_sum.configure());
+
+  a_out.connectTo(vector_sum.ports()->getPort("addends_in"));
+  b_out.connectTo(vector_sum.ports()->getPort("addends_in"));
+  vector_sum.ports()->getPort("sum_out")->connectTo(&sum_in);
+
+  // Warm up
+  a_out.write(a);
+  vector_sum.updateHook();
+  sum_in.read(sum);
+
+  // Updates don't allocate
+  {
+    conman::test::AllocationCounter allocations;
+    for(int i=0; i < 10; i++) {
+      a_out.write(a);
+      b_out.write(b);
+      vector_sum.updateHook();
+      sum_in.read(sum);
+    }
+    EXPECT_EQ(0, allocations.count());
+  }
+
+  EXPECT_TRUE(sum.isApprox(a + b));
+}
+
+TEST_F(BlocksTest, FeedForwardFeedBackAllocation) {
+  conman_blocks::FeedForwardFeedBack fffb("fffb");
+  fffb.properties()->getPropertyType<int>("dim")->set(dim);
+  ASSERT_TRUE(fffb.configure());
+
+  a_out.connectTo(fffb.ports()->getPort("feedforward_in"));
+  b_out.connectTo(fffb.ports()->getPort("feedforward_in"));
+  feedback_out.connectTo(fffb.ports()->getPort("feedback_in"));
+  fffb.ports()->getPort("sum_out")->connectTo(&sum_in);
+
+  // Warm up
+  a_out.write(a);
+  feedback_out.write(b);
+  fffb.updateHook();
+  sum_in.read(sum);
+
+  // Updates don't allocate
+  {
+    conman::test::AllocationCounter allocations;
+    for(int i=0; i < 10; i++) {
+      a_out.write(a);
+      b_out.write(b);
+      feedback_out.write(b);
+      fffb.updateHook();
+      sum_in.read(sum);
+    }
+    EXPECT_EQ(0, allocations.count());
+  }
+
+  EXPECT_TRUE(sum.isApprox(a + 2*b));
+}
+
+TEST_F(BlocksTest, VectorSumReduction) {
+  conman_blocks::VectorSum vector_sum("vector_sum");
+  vector_sum.properties()->getPropertyType<int>("dim")->set(dim);
+  vector_sum.properties()->getPropertyType<std::string>("reduction")->set("max");
+  ASSERT_TRUE(vector_sum.configure());
+
+  a_out.connectTo(vector_sum.ports()->getPort("addends_in"));
+  b_out.connectTo(vector_sum.ports()->getPort("addends_in"));
+  vector_sum.ports()->getPort("sum_out")->connectTo(&sum_in);
+
+  a(0) = 3.0;
+  a_out.write(a);
+  b_out.write(b);
+  vector_sum.updateHook();
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_EQ(3.0, sum(0));
+  EXPECT_EQ(2.0, sum(1));
+
+  // Each writer contributes its latest sample once
+  a_out.write(a);
+  a_out.write(a);
+  vector_sum.updateHook();
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(sum.isApprox(a));
+
+  vector_sum.properties()->getPropertyType<std::string>("reduction")->set("product");
+  EXPECT_FALSE(vector_sum.configure());
+}
+
+TEST_F(BlocksTest, VectorSumDimensionGuard) {
+  conman_blocks::VectorSum vector_sum("vector_sum");
+  vector_sum.properties()->getPropertyType<int>("dim")->set(dim);
+  ASSERT_TRUE(vector_sum.configure());
+  ASSERT_TRUE(vector_sum.start());
+
+  a_out.connectTo(vector_sum.ports()->getPort("addends_in"));
+  vector_sum.ports()->getPort("sum_out")->connectTo(&sum_in);
+
+  // Samples with the wrong dimension are dropped and put the block in the
+  // error state
+  a_out.write(Eigen::VectorXd::Zero(dim+1));
+  vector_sum.updateHook();
+  EXPECT_NE(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(vector_sum.inRunTimeError());
+
+  vector_sum.stop();
+}
+
+TEST(VectorKernelsTest, Specializations) {
+  using namespace conman_blocks;
+
+  EXPECT_EQ(7, kernels::SelectVectorOps(7).dim);
+  EXPECT_EQ(4, kernels::SelectVectorOps(4).dim);
+  EXPECT_EQ(Eigen::Dynamic, kernels::SelectVectorOps(5).dim);
+
+  // The fixed-size kernels agree with the dynamic kernels
+  const kernels::VectorOps fixed_ops = kernels::SelectVectorOps(7);
+  const kernels::VectorOps dynamic_ops = kernels::SelectVectorOps(5);
+
+  Eigen::VectorXd x = Eigen::VectorXd::Random(7), y = Eigen::VectorXd::Random(7);
+  Eigen::VectorXd y_fixed = y, y_dynamic = y;
+
+  fixed_ops.add_scaled(y_fixed, 0.5, x);
+  dynamic_ops.add_scaled(y_dynamic, 0.5, x);
+  EXPECT_TRUE(y_fixed.isApprox(y + 0.5*x));
+  EXPECT_TRUE(y_dynamic.isApprox(y_fixed));
+
+  fixed_ops.reduce(kernels::MAX, y_fixed, x);
+  dynamic_ops.reduce(kernels::MAX, y_dynamic, x);
+  EXPECT_TRUE(y_dynamic.isApprox(y_fixed));
+}
+
+TEST_F(BlocksTest, FixedVectorSum) {
+  conman_blocks::VectorSum7 vector_sum("vector_sum");
+  EXPECT_EQ(dim, vector_sum.properties()->getPropertyType<int>("dim")->get());
+  ASSERT_TRUE(vector_sum.configure());
+
+  a_out.connectTo(vector_sum.ports()->getPort("addends_in"));
+  b_out.connectTo(vector_sum.ports()->getPort("addends_in"));
+  vector_sum.ports()->getPort("sum_out")->connectTo(&sum_in);
+
+  a_out.write(a);
+  b_out.write(b);
+  vector_sum.updateHook();
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(sum.isApprox(a + b));
+
+  // The dimension can't be changed
+  vector_sum.properties()->getPropertyType<int>("dim")->set(4);
+  EXPECT_FALSE(vector_sum.configure());
+}
+
+TEST(ControlKernelsTest, Kernels) {
+  using namespace conman_blocks;
+
+  Eigen::Vector3d x(-2.0, 0.5, 3.0), y;
+  const Eigen::Vector3d ones = Eigen::Vector3d::Ones();
+
+  kernels::Gain(Eigen::Vector3d(1.0, 2.0, 3.0), x, y);
+  EXPECT_TRUE(y.isApprox(Eigen::Vector3d(-2.0, 1.0, 9.0)));
+
+  kernels::Saturate(ones, x, y);
+  EXPECT_TRUE(y.isApprox(Eigen::Vector3d(-1.0, 0.5, 1.0)));
+
+  kernels::Deadband(ones, x, y);
+  EXPECT_TRUE(y.isApprox(Eigen::Vector3d(-1.0, 0.0, 2.0)));
+
+  y = Eigen::Vector3d::Zero();
+  kernels::RateLimit(ones, 0.5, x, y);
+  EXPECT_TRUE(y.isApprox(Eigen::Vector3d(-0.5, 0.5, 0.5)));
+
+  Eigen::Vector3d last_error = Eigen::Vector3d::Zero(), integral = Eigen::Vector3d::Zero();
+  kernels::PID(ones, ones, ones, ones, 0.5, x, last_error, integral, y);
+  EXPECT_TRUE(integral.isApprox(Eigen::Vector3d(-1.0, 0.25, 1.0)));
+  EXPECT_TRUE(y.isApprox(x + integral + x / 0.5));
+  EXPECT_TRUE(last_error.isApprox(x));
+}
+
+TEST_F(BlocksTest, ControlBlocksAllocation) {
+  conman_blocks::Gain gain("gain");
+  conman_blocks::Saturation saturation("saturation");
+  conman_blocks::PID pid("pid");
+
+  gain.properties()->getPropertyType<int>("dim")->set(dim);
+  saturation.properties()->getPropertyType<int>("dim")->set(dim);
+  pid.properties()->getPropertyType<int>("dim")->set(dim);
+  gain.properties()->getPropertyType<Eigen::VectorXd>("gains")->set(b);
+  pid.properties()->getPropertyType<Eigen::VectorXd>("p_gains")->set(b);
+
+  ASSERT_TRUE(gain.configure());
+  ASSERT_TRUE(saturation.configure());
+  ASSERT_TRUE(pid.configure());
+
+  a_out.connectTo(gain.ports()->getPort("in"));
+  gain.ports()->getPort("out")->connectTo(saturation.ports()->getPort("in"));
+  saturation.ports()->getPort("out")->connectTo(pid.ports()->getPort("error_in"));
+  pid.ports()->getPort("effort_out")->connectTo(&sum_in);
+
+  // Warm up
+  a_out.write(a);
+  gain.updateHook();
+  saturation.updateHook();
+  pid.updateHook();
+  sum_in.read(sum);
+
+  // Updates don't allocate
+  {
+    conman::test::AllocationCounter allocations;
+    for(int i=0; i < 10; i++) {
+      a_out.write(a);
+      gain.updateHook();
+      saturation.updateHook();
+      pid.updateHook();
+      sum_in.read(sum);
+    }
+    EXPECT_EQ(0, allocations.count());
+  }
+
+  EXPECT_TRUE(sum.isApprox(b.cwiseProduct(b.cwiseProduct(a))));
+
+  // Parameters need to have the right dimension
+  saturation.properties()->getPropertyType<Eigen::VectorXd>("limits")->set(Eigen::VectorXd::Ones(dim+1));
+  EXPECT_FALSE(saturation.configure());
+}
+
+TEST_F(BlocksTest, RateLimiterInputPeriod) {
+  conman_blocks::RateLimiter rate_limiter("rate_limiter");
+  rate_limiter.properties()->getPropertyType<int>("dim")->set(dim);
+  rate_limiter.properties()->getPropertyType<Eigen::VectorXd>("rates")->set(Eigen::VectorXd::Ones(dim));
+  rate_limiter.setActivity(new RTT::extras::SlaveActivity(rate_limiter.engine()));
+  ASSERT_TRUE(rate_limiter.configure());
+  ASSERT_TRUE(rate_limiter.start());
+
+  a_out.connectTo(rate_limiter.ports()->getPort("in"));
+  rate_limiter.ports()->getPort("out")->connectTo(&sum_in);
+
+  // Update the block through its hook so that it sees the time
+  boost::shared_ptr<conman::Hook> hook = conman::Hook::GetHook(&rate_limiter);
+
+  // The first input passes through
+  a_out.write(Eigen::VectorXd::Zero(dim));
+  hook->update(0.1);
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(sum.isZero());
+
+  // Nothing is written without an input
+  hook->update(0.2);
+  hook->update(0.3);
+  EXPECT_NE(RTT::NewData, sum_in.read(sum));
+
+  // The output moves by the rate times the time since the last input, not
+  // the update period
+  a_out.write(b);
+  hook->update(0.4);
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(sum.isApprox(Eigen::VectorXd::Constant(dim, 0.3)));
+
+  rate_limiter.stop();
+}
+
+TEST_F(BlocksTest, RateTransitionAverage) {
+  conman_blocks::RateTransition rate_transition("rate_transition");
+  rate_transition.properties()->getPropertyType<int>("dim")->set(dim);
+  rate_transition.properties()->getPropertyType<std::string>("mode")->set("average");
+  rate_transition.properties()->getPropertyType<int>("decimation")->set(2);
+  ASSERT_TRUE(rate_transition.configure());
+  ASSERT_TRUE(rate_transition.start());
+
+  a_out.connectTo(rate_transition.ports()->getPort("in"));
+  rate_transition.ports()->getPort("out")->connectTo(&sum_in);
+
+  // Warm up
+  a_out.write(a);
+  rate_transition.updateHook();
+  a_out.write(b);
+  rate_transition.updateHook();
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(sum.isApprox(0.5*(a + b)));
+
+  // The output is only written every other update, and updates don't
+  // allocate
+  {
+    conman::test::AllocationCounter allocations;
+    a_out.write(a);
+    rate_transition.updateHook();
+    EXPECT_NE(RTT::NewData, sum_in.read(sum));
+    a_out.write(a);
+    rate_transition.updateHook();
+    EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+    EXPECT_EQ(0, allocations.count());
+  }
+  EXPECT_TRUE(sum.isApprox(a));
+
+  rate_transition.stop();
+}
+
+TEST_F(BlocksTest, RateTransitionInterpolate) {
+  conman_blocks::RateTransition rate_transition("rate_transition");
+  rate_transition.properties()->getPropertyType<int>("dim")->set(dim);
+  rate_transition.properties()->getPropertyType<std::string>("mode")->set("interpolate");
+  rate_transition.setActivity(new RTT::extras::SlaveActivity(rate_transition.engine()));
+  ASSERT_TRUE(rate_transition.configure());
+  ASSERT_TRUE(rate_transition.start());
+
+  a_out.connectTo(rate_transition.ports()->getPort("in"));
+  rate_transition.ports()->getPort("out")->connectTo(&sum_in);
+
+  // Update the block through its hook so that it sees the time
+  boost::shared_ptr<conman::Hook> hook = conman::Hook::GetHook(&rate_transition);
+
+  // The first input is held until the second one
+  a_out.write(a);
+  hook->update(0.1);
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(sum.isApprox(a));
+  hook->update(0.2);
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(sum.isApprox(a));
+
+  // The output moves from the last input to the next input over the period
+  // between them, and then it's held
+  a_out.write(b);
+  hook->update(0.3);
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(sum.isApprox(a));
+  hook->update(0.4);
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(sum.isApprox(0.5*(a + b)));
+  hook->update(0.5);
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(sum.isApprox(b));
+  hook->update(0.6);
+  EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+  EXPECT_TRUE(sum.isApprox(b));
+
+  rate_transition.stop();
+}
+
+TEST_F(BlocksTest, RateTransitionHold) {
+  conman_blocks::RateTransition rate_transition("rate_transition");
+  rate_transition.properties()->getPropertyType<int>("dim")->set(dim);
+  ASSERT_TRUE(rate_transition.configure());
+  ASSERT_TRUE(rate_transition.start());
+
+  a_out.connectTo(rate_transition.ports()->getPort("in"));
+  rate_transition.ports()->getPort("out")->connectTo(&sum_in);
+
+  // Nothing is written before the first input
+  rate_transition.updateHook();
+  EXPECT_NE(RTT::NewData, sum_in.read(sum));
+
+  // The last input is written on every update
+  a_out.write(a);
+  for(int i=0; i < 3; i++) {
+    rate_transition.updateHook();
+    EXPECT_EQ(RTT::NewData, sum_in.read(sum));
+    EXPECT_TRUE(sum.isApprox(a));
+  }
+
+  rate_transition.properties()->getPropertyType<std::string>("mode")->set("sample");
+  rate_transition.stop();
+  EXPECT_FALSE(rate_transition.configure());
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+
+  // Initialize Orocos
+  __os_init(argc, argv);
+
+  RTT::Logger::log().setStdStream(std::cerr);
+  RTT::Logger::log().mayLogStdOut(true);
+
+  return RUN_ALL_TESTS();
+}